@@ -0,0 +1,291 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "AsyncLog.h"
+#include "checkpoint/ThreadManager.h"
+#include "frame.h" // For framecount
+#include "GlobalState.h"
+#include "../shared/LogRing.h"
+
+#include <cstring>
+#include <cerrno>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#endif
+
+namespace libtas {
+
+/* Size of the mapping, rounded up to the page size */
+static const size_t layout_size = (sizeof(LogRing::Layout) + 4095) & ~static_cast<size_t>(4095);
+
+static int ring_fd = -1;
+static LogRing::Layout* layout = nullptr;
+
+/* Index of the ring owned by the current thread. -1 means that the thread
+ * did not look for a ring yet, and -2 that no ring was available. */
+static thread_local int ring_index = -1;
+
+void AsyncLog::init()
+{
+#ifdef __linux__
+    if (layout)
+        return;
+
+    NATIVECALL(ring_fd = syscall(SYS_memfd_create, "libtas_log", MFD_CLOEXEC));
+    if (ring_fd < 0)
+        return;
+
+    if (ftruncate(ring_fd, layout_size) < 0) {
+        NATIVECALL(close(ring_fd));
+        ring_fd = -1;
+        return;
+    }
+
+    void* addr;
+    NATIVECALL(addr = mmap(nullptr, layout_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring_fd, 0));
+    if (addr == MAP_FAILED) {
+        NATIVECALL(close(ring_fd));
+        ring_fd = -1;
+        return;
+    }
+
+    /* The object is zero-filled, so all rings are empty and free */
+    layout = static_cast<LogRing::Layout*>(addr);
+    layout->ring_count = LogRing::RING_COUNT;
+    layout->ring_records = LogRing::RING_RECORDS;
+    layout->record_size = sizeof(LogRing::Record);
+    layout->magic = LogRing::MAGIC;
+#endif
+}
+
+int AsyncLog::getFd()
+{
+    return ring_fd;
+}
+
+void* AsyncLog::getAddr()
+{
+    return layout;
+}
+
+size_t AsyncLog::getSize()
+{
+    return layout ? layout_size : 0;
+}
+
+/* Look for a ring for the calling thread. Rings are identified by the thread
+ * tid, so that a recycled thread finds its ring back. Rings of threads that
+ * have terminated are taken over. */
+static int claimRing(pid_t tid)
+{
+    for (int i = 0; i < LogRing::RING_COUNT; i++) {
+        if (layout->rings[i].owner.load(std::memory_order_relaxed) == tid)
+            return i;
+    }
+
+    for (int i = 0; i < LogRing::RING_COUNT; i++) {
+        int32_t expected = 0;
+        if (layout->rings[i].owner.compare_exchange_strong(expected, tid))
+            return i;
+    }
+
+    pid_t pid;
+    NATIVECALL(pid = getpid());
+    for (int i = 0; i < LogRing::RING_COUNT; i++) {
+        int32_t owner = layout->rings[i].owner.load(std::memory_order_relaxed);
+        int ret;
+        NATIVECALL(ret = syscall(SYS_tgkill, pid, owner, 0));
+        if ((ret == -1) && (errno == ESRCH) &&
+            layout->rings[i].owner.compare_exchange_strong(owner, tid))
+            return i;
+    }
+
+    return -2;
+}
+
+/* Append an argument into the record payload. Returns false if it did not fit */
+static bool writeArg(LogRing::Record& rec, uint8_t type, const void* data, size_t size)
+{
+    if (rec.payload_size + 1 + size > LogRing::PAYLOAD_SIZE)
+        return false;
+
+    rec.payload[rec.payload_size++] = type;
+    memcpy(rec.payload + rec.payload_size, data, size);
+    rec.payload_size += size;
+    return true;
+}
+
+static bool writeString(LogRing::Record& rec, const char* str)
+{
+    if (!str)
+        str = "(null)";
+
+    /* Truncate the string to the remaining space */
+    size_t len = strlen(str);
+    size_t avail = LogRing::PAYLOAD_SIZE - rec.payload_size;
+    if (avail < 1 + sizeof(uint16_t))
+        return false;
+    avail -= 1 + sizeof(uint16_t);
+    if (len > avail) {
+        len = avail;
+        rec.flags |= LogRing::REC_TRUNCATED;
+    }
+
+    uint16_t len16 = len;
+    rec.payload[rec.payload_size++] = LogRing::ARG_STRING;
+    memcpy(rec.payload + rec.payload_size, &len16, sizeof(uint16_t));
+    rec.payload_size += sizeof(uint16_t);
+    memcpy(rec.payload + rec.payload_size, str, len);
+    rec.payload_size += len;
+    return true;
+}
+
+/* Encode all arguments of the format string, following the printf rules of
+ * default argument promotion. */
+static void encodeArgs(LogRing::Record& rec, const char* fmt, va_list args)
+{
+    LogRing::Conversion c;
+    while (LogRing::nextConversion(fmt, c)) {
+        fmt = c.end;
+
+        for (int s = 0; s < c.stars; s++) {
+            int64_t v = va_arg(args, int);
+            if (!writeArg(rec, LogRing::ARG_INT, &v, sizeof(v))) {
+                rec.flags |= LogRing::REC_TRUNCATED;
+                return;
+            }
+        }
+
+        bool ok = true;
+        switch (LogRing::argType(c)) {
+            case LogRing::ARG_INT: {
+                int64_t v;
+                switch (c.length) {
+                    case 'l': v = va_arg(args, long); break;
+                    case 'q':
+                    case 'L': v = va_arg(args, long long); break;
+                    case 'j': v = va_arg(args, intmax_t); break;
+                    case 'z': v = va_arg(args, ssize_t); break;
+                    case 't': v = va_arg(args, ptrdiff_t); break;
+                    default: v = va_arg(args, int); break;
+                }
+                ok = writeArg(rec, LogRing::ARG_INT, &v, sizeof(v));
+                break;
+            }
+            case LogRing::ARG_UINT: {
+                uint64_t v;
+                switch (c.length) {
+                    case 'l': v = va_arg(args, unsigned long); break;
+                    case 'q':
+                    case 'L': v = va_arg(args, unsigned long long); break;
+                    case 'j': v = va_arg(args, uintmax_t); break;
+                    case 'z': v = va_arg(args, size_t); break;
+                    case 't': v = va_arg(args, ptrdiff_t); break;
+                    default: v = va_arg(args, unsigned int); break;
+                }
+                ok = writeArg(rec, LogRing::ARG_UINT, &v, sizeof(v));
+                break;
+            }
+            case LogRing::ARG_DOUBLE: {
+                double v;
+                if (c.length == 'L')
+                    v = va_arg(args, long double);
+                else
+                    v = va_arg(args, double);
+                ok = writeArg(rec, LogRing::ARG_DOUBLE, &v, sizeof(v));
+                break;
+            }
+            case LogRing::ARG_STRING:
+                ok = writeString(rec, va_arg(args, const char*));
+                break;
+            case LogRing::ARG_POINTER: {
+                uint64_t v = reinterpret_cast<uintptr_t>(va_arg(args, void*));
+                ok = writeArg(rec, LogRing::ARG_POINTER, &v, sizeof(v));
+                break;
+            }
+            default:
+                if (c.conv == 'n') {
+                    va_arg(args, void*);
+                    break;
+                }
+                /* Unknown conversion, we cannot tell what the following
+                 * arguments are */
+                rec.flags |= LogRing::REC_TRUNCATED;
+                return;
+        }
+
+        if (!ok) {
+            rec.flags |= LogRing::REC_TRUNCATED;
+            return;
+        }
+    }
+}
+
+bool AsyncLog::push(LogCategoryFlag lcf, const char* file, int line, const char* fmt, va_list args)
+{
+    if (!layout)
+        return false;
+
+    if (ring_index == -1)
+        ring_index = claimRing(ThreadManager::getThreadTid());
+
+    if (ring_index < 0)
+        return false;
+
+    LogRing::Ring& ring = layout->rings[ring_index];
+
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+    uint32_t tail = ring.tail.load(std::memory_order_acquire);
+    if ((head - tail) >= LogRing::RING_RECORDS)
+        return false;
+
+    LogRing::Record& rec = ring.records[head & (LogRing::RING_RECORDS - 1)];
+    rec.fmt = reinterpret_cast<uintptr_t>(fmt);
+    rec.file = reinterpret_cast<uintptr_t>(file);
+    rec.framecount = framecount;
+    rec.lcf = lcf;
+    rec.tid = ThreadManager::getThreadTid();
+    rec.line = line;
+    rec.payload_size = 0;
+    rec.flags = ThreadManager::isMainThread() ? LogRing::REC_MAINTHREAD : 0;
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+    encodeArgs(rec, fmt, args_copy);
+    va_end(args_copy);
+
+    ring.head.store(head + 1, std::memory_order_release);
+
+#ifdef __linux__
+    /* Wake the program if it sleeps, pairs with the fence of its reader */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (layout->reader_waiting.load(std::memory_order_relaxed)) {
+        layout->wake_seq.fetch_add(1);
+        NATIVECALL(syscall(SYS_futex, reinterpret_cast<uint32_t*>(&layout->wake_seq), FUTEX_WAKE, 1, nullptr, nullptr, 0));
+    }
+#endif
+    return true;
+}
+
+}
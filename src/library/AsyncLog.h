@@ -0,0 +1,55 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBTAS_ASYNCLOG_H_INCL
+#define LIBTAS_ASYNCLOG_H_INCL
+
+#include "../shared/lcf.h"
+
+#include <cstdarg>
+#include <cstddef>
+
+namespace libtas {
+
+/* Asynchronous logging: instead of formatting and printing messages, each
+ * thread pushes compact binary records into its own lock-free ring located
+ * in a shared memory object, which is drained and formatted by the program. */
+namespace AsyncLog {
+
+/* Create and map the shared memory object holding the log rings */
+void init();
+
+/* Returns the file descriptor of the shared memory object, or -1 */
+int getFd();
+
+/* Returns the address and size of the shared mapping, which must be skipped
+ * when saving and loading states */
+void* getAddr();
+size_t getSize();
+
+/* Push a log record into the ring of the calling thread. Returns false if
+ * the record could not be pushed (no free ring or ring full), in which case
+ * the message must be printed synchronously. */
+bool push(LogCategoryFlag lcf, const char* file, int line, const char* fmt, va_list args);
+
+}
+}
+
+#endif
@@ -43,6 +43,7 @@
 #include <stdint.h>
 #include <execinfo.h>
 #include <map>
+#include <unordered_map>
 
 extern char**environ;
 
@@ -50,64 +51,60 @@ extern char**environ;
 
 namespace libtas {
 
-static uint64_t hash;
 static uint64_t timecall_count;
 
-void BusyLoopDetection::reset()
-{
-    if (!Global::shared_config.busyloop_detection)
-        return;
+/* Symbolization of a single return address */
+struct FrameInfo {
+    /* Value to hash for this frame, which does not depend on where the
+     * libraries were loaded */
+    uint64_t key;
 
-    /* Remove any fake ticks cause by the busy loop detector */
-    DeterministicTimer::get().fakeAdvanceTimer({0, 0});
+    /* Frame description for the time trace */
+    std::string trace;
+};
 
-    timecall_count = 0;
-}
+/* Time call stacks that were encountered, and the count of calls since the
+ * last frame boundary */
+struct TimeCall {
+    int type;
+    unsigned int count;
+    bool sent;
+    std::string trace;
+};
 
-void BusyLoopDetection::resetHash()
-{
-    hash = 0;
-}
+/* Cache of symbolized return addresses. Entries are only valid while the
+ * corresponding library stays loaded, which is the case for the vast
+ * majority of games. */
+static std::unordered_map<void*, FrameInfo> frame_cache;
+
+/* Cache of stack hashes indexed by the hash of raw return addresses */
+static std::unordered_map<uint64_t, uint64_t> stack_cache;
 
-void BusyLoopDetection::toHash(const char* string)
+static std::map<uint64_t, TimeCall> time_calls;
+
+static void toHash(uint64_t& hash, const char* string)
 {
     const char* c = string;
     for (; *c != '\0'; c++)
         hash = hash * 33 + *c;
 }
 
-void BusyLoopDetection::toHash(intptr_t addr)
+static void toHash(uint64_t& hash, intptr_t addr)
 {
     hash = hash * 33 + addr;
 }
 
-void BusyLoopDetection::increment(int type)
+/* Symbolize a return address. Returns false if the address is inside an
+ * anonymous mapping, so that it must not be cached. */
+static bool symbolize(void* address, FrameInfo& frame)
 {
-    if (!Global::shared_config.busyloop_detection && !Global::shared_config.time_trace)
-        return;
-    if (!ThreadManager::isMainThread())
-        return;
-    if (GlobalState::isNative())
-        return;
-    if (DeterministicTimer::get().isInsideFrameBoundary())
-        return;
-
-    debuglogstdio(LCF_TIMEGET | LCF_FREQUENT, "Time function called");
-
-    GlobalState::setNative(true);
-
-    resetHash();
-
-    toHash(static_cast<intptr_t>(type));
-
-    void* addresses[MAX_STACK_SIZE];
-    const int n = backtrace(addresses, MAX_STACK_SIZE);
-
     /* Get the ld_library_path content */
     /* The env name was modified in libTAS init function */
     static char* ld_path = nullptr;
+    static bool ld_path_init = false;
 
-    if (ld_path == nullptr) {
+    if (!ld_path_init) {
+        ld_path_init = true;
         const char* ld = "DD_LIBRARY_PATH=";
         for (int i=0; environ[i]; i++) {
             if (strstr(environ[i], ld) == environ[i]) {
@@ -120,97 +117,204 @@ void BusyLoopDetection::increment(int type)
         }
     }
 
+    frame.key = 0;
+    std::ostringstream oss;
+
     /* We don't need the whole `backtrace_symbols()` feature, only some information,
      * so this is a simplified implementation of this function. */
-    std::ostringstream oss;
+    Dl_info info;
+    int status = dladdr(address, &info);
+    bool cacheable = true;
+    if (status && info.dli_fname != NULL && info.dli_fname[0] != '\0') {
+        /* Check if the program or library is provided by the game,
+         * using the content of LD_LIBRARY_PATH
+         */
+        bool isGameLibrary = false;
+        /* Putting executable base addresses directly, because I'm lazy... */
+        if (info.dli_fbase == (void*)0x400000 || info.dli_fbase == (void*)0x8048000)
+            isGameLibrary = true;
+        else if (ld_path) {
+            isGameLibrary = strstr(info.dli_fname, ld_path);
+        }
 
-    /* Start the stack at frame 3 to skip this, DeterministicTimer::getTicks() and gettime() */
-    for (int cnt = 3; cnt < n; ++cnt) {
-        Dl_info info;
-        int status = dladdr(addresses[cnt], &info);
-        if (status && info.dli_fname != NULL && info.dli_fname[0] != '\0') {
-            /* Check if the program or library is provided by the game,
-             * using the content of LD_LIBRARY_PATH
-             */
-            bool isGameLibrary = false;
-            /* Putting executable base addresses directly, because I'm lazy... */
-            if (info.dli_fbase == (void*)0x400000 || info.dli_fbase == (void*)0x8048000)
-                isGameLibrary = true;
-            else if (ld_path) {
-                isGameLibrary = strstr(info.dli_fname, ld_path);
+        if (isGameLibrary) {
+            /* Hash the file name */
+            const char* filename = strrchr(info.dli_fname, '/');
+            toHash(frame.key, filename? ++filename : info.dli_fname);
+
+            /* Hash the address offset */
+            if (info.dli_fbase && (address >= info.dli_fbase))
+                toHash(frame.key, reinterpret_cast<intptr_t>(address) - reinterpret_cast<intptr_t>(info.dli_fbase));
+        }
+        else {
+            /* We should be safe to push the function called inside the library.
+             * everything else may change (even library name) */
+            if (info.dli_sname != NULL) {
+                toHash(frame.key, info.dli_sname);
             }
+        }
 
-            if (isGameLibrary) {
-                /* Hash the file name */
-                const char* filename = strrchr(info.dli_fname, '/');
-                toHash(filename? ++filename : info.dli_fname);
+        /* Building stack trace string */
+        oss << info.dli_fname;
 
-                /* Hash the address offset */
-                if (info.dli_fbase && (addresses[cnt] >= info.dli_fbase))
-                    toHash(reinterpret_cast<intptr_t>(addresses[cnt]) - reinterpret_cast<intptr_t>(info.dli_fbase));
-            }
-            else {
-                /* We should be safe to push the function called inside the library.
-                 * everything else may change (even library name) */
-                if (info.dli_sname != NULL) {
-                    toHash(info.dli_sname);
-                }
-            }
+        if (info.dli_sname == NULL)
+            info.dli_saddr = info.dli_fbase;
 
-            /* Building stack trace string */
-            if (Global::shared_config.time_trace) {
-                oss << info.dli_fname;
-
-                if (info.dli_sname == NULL)
-                    info.dli_saddr = info.dli_fbase;
-
-                if (info.dli_sname != NULL || info.dli_saddr != 0) {
-                    oss << "(" << (info.dli_sname ? info.dli_sname : "");
-                    if (info.dli_saddr != 0) {
-                        if (addresses[cnt] >= (void *)info.dli_saddr) {
-                            oss << '+' << std::hex << (reinterpret_cast<intptr_t>(addresses[cnt]) - reinterpret_cast<intptr_t>(info.dli_saddr));
-                        }
-                        else {
-                            oss << '-' << std::hex << (reinterpret_cast<intptr_t>(info.dli_saddr) - reinterpret_cast<intptr_t>(addresses[cnt]));
-                        }
-                    }
-                    oss << ")";
+        if (info.dli_sname != NULL || info.dli_saddr != 0) {
+            oss << "(" << (info.dli_sname ? info.dli_sname : "");
+            if (info.dli_saddr != 0) {
+                if (address >= (void *)info.dli_saddr) {
+                    oss << '+' << std::hex << (reinterpret_cast<intptr_t>(address) - reinterpret_cast<intptr_t>(info.dli_saddr));
+                }
+                else {
+                    oss << '-' << std::hex << (reinterpret_cast<intptr_t>(info.dli_saddr) - reinterpret_cast<intptr_t>(address));
                 }
-                oss << " ";
             }
+            oss << ")";
         }
-        else {
-            /* Executed code comes from some anonymous mapping, which is often
-             * the sign of JIT execution. For now, we trust that the code always
-             * has the same offset from the beginning of the mapped section. */
-
-            /* Find the corresponding memory area */
+        oss << " ";
+    }
+    else {
+        /* Executed code comes from some anonymous mapping, which is often
+         * the sign of JIT execution. For now, we trust that the code always
+         * has the same offset from the beginning of the mapped section.
+         * The mapping may be replaced, so this is not cached. */
+        cacheable = false;
+
+        /* Find the corresponding memory area */
+        Area area;
 #ifdef __unix__
-            ProcSelfMaps memMapLayout;
+        if (ProcSelfMaps::getAreaAt(reinterpret_cast<uintptr_t>(address), &area)) {
+            toHash(frame.key, reinterpret_cast<intptr_t>(address) - reinterpret_cast<intptr_t>(area.addr));
+        }
 #elif defined(__APPLE__) && defined(__MACH__)
-            MachVmMaps memMapLayout;
-#endif
-            Area area;
-            while (memMapLayout.getNextArea(&area)) {
-                if ((addresses[cnt] >= area.addr) && (addresses[cnt] < area.endAddr)) {
-                    toHash(reinterpret_cast<intptr_t>(addresses[cnt]) - reinterpret_cast<intptr_t>(area.addr));
-                    break;
-                }
+        MachVmMaps memMapLayout;
+        while (memMapLayout.getNextArea(&area)) {
+            if ((address >= area.addr) && (address < area.endAddr)) {
+                toHash(frame.key, reinterpret_cast<intptr_t>(address) - reinterpret_cast<intptr_t>(area.addr));
+                break;
             }
         }
-        if (Global::shared_config.time_trace) {
-            oss << "[" << addresses[cnt] << "]\n";
-        }
+#endif
     }
+    oss << "[" << address << "]\n";
+    frame.trace = oss.str();
+
+    return cacheable;
+}
+
+/* Send the time calls of the current frame to the program. The stack trace
+ * of each hash is only sent the first time. */
+static void sendTimeCalls()
+{
+    lockSocket();
+    for (auto& it : time_calls) {
+        TimeCall& tc = it.second;
+        if (tc.count == 0)
+            continue;
 
-    if (Global::shared_config.time_trace) {
-        lockSocket();
         sendMessage(MSGB_GETTIME_BACKTRACE);
-        sendData(&type, sizeof(int));
-        sendData(&hash, sizeof(uint64_t));
-        sendString(oss.str());
-        unlockSocket();
+        sendData(&tc.type, sizeof(int));
+        sendData(&it.first, sizeof(uint64_t));
+        sendData(&tc.count, sizeof(unsigned int));
+        sendString(tc.sent ? std::string() : tc.trace);
+
+        tc.count = 0;
+        tc.sent = true;
+    }
+    unlockSocket();
+}
+
+void BusyLoopDetection::reset()
+{
+    if (!time_calls.empty()) {
+        GlobalState::setNative(true);
+        if (Global::shared_config.time_trace)
+            sendTimeCalls();
+        else
+            for (auto& it : time_calls)
+                it.second.count = 0;
+        GlobalState::setNative(false);
+    }
+
+    if (!Global::shared_config.busyloop_detection)
+        return;
+
+    /* Remove any fake ticks cause by the busy loop detector */
+    DeterministicTimer::get().fakeAdvanceTimer({0, 0});
+
+    timecall_count = 0;
+}
+
+void BusyLoopDetection::increment(int type)
+{
+    if (!Global::shared_config.busyloop_detection && !Global::shared_config.time_trace)
+        return;
+    if (!ThreadManager::isMainThread())
+        return;
+    if (GlobalState::isNative())
+        return;
+    if (DeterministicTimer::get().isInsideFrameBoundary())
+        return;
+
+    debuglogstdio(LCF_TIMEGET | LCF_FREQUENT, "Time function called");
+
+    GlobalState::setNative(true);
+
+    void* addresses[MAX_STACK_SIZE];
+    const int n = backtrace(addresses, MAX_STACK_SIZE);
+
+    /* Hash the raw return addresses, to look for an already symbolized stack.
+     * Start the stack at frame 3 to skip this, DeterministicTimer::getTicks()
+     * and gettime() */
+    uint64_t raw_hash = static_cast<uint64_t>(type);
+    for (int cnt = 3; cnt < n; ++cnt) {
+        raw_hash ^= reinterpret_cast<uintptr_t>(addresses[cnt]);
+        raw_hash *= 0x100000001b3ULL;
+    }
+
+    uint64_t hash;
+    auto stack_it = stack_cache.find(raw_hash);
+    if (stack_it != stack_cache.end()) {
+        hash = stack_it->second;
     }
+    else {
+        hash = 0;
+        toHash(hash, static_cast<intptr_t>(type));
+
+        bool cacheable = true;
+        std::string trace;
+        for (int cnt = 3; cnt < n; ++cnt) {
+            auto frame_it = frame_cache.find(addresses[cnt]);
+            if (frame_it != frame_cache.end()) {
+                toHash(hash, static_cast<intptr_t>(frame_it->second.key));
+                trace += frame_it->second.trace;
+                continue;
+            }
+
+            FrameInfo frame;
+            if (symbolize(addresses[cnt], frame))
+                frame_cache.emplace(addresses[cnt], frame);
+            else
+                cacheable = false;
+
+            toHash(hash, static_cast<intptr_t>(frame.key));
+            trace += frame.trace;
+        }
+
+        if (cacheable)
+            stack_cache.emplace(raw_hash, hash);
+
+        TimeCall& tc = time_calls[hash];
+        if (tc.trace.empty()) {
+            tc.type = type;
+            tc.trace = trace;
+        }
+    }
+
+    if (Global::shared_config.time_trace)
+        time_calls[hash].count++;
+
     GlobalState::setNative(false);
 
     if (hash == Global::shared_config.busy_loop_hash) {
@@ -25,15 +25,9 @@
 namespace libtas {
 namespace BusyLoopDetection {
 
-/* Reset the state, at the end of each frame */
+/* Reset the state and send the time calls of the frame, at the end of each frame */
 void reset();
 
-void resetHash();
-
-void toHash(const char* string);
-
-void toHash(intptr_t addr);
-
 /* Update the state after a time call was made */
 void increment(int type);
 
@@ -87,14 +87,11 @@ struct timespec DeterministicTimer::getTicks(SharedConfig::TimeCallType type)
     }
 
     if ((type == SharedConfig::TIMETYPE_UNTRACKED_MONOTONIC) || GlobalState::isOwnCode()) {
-        TimeHolder returnTicks = ticks + fakeExtraTicks;
-        return returnTicks;
+        return readTicks(true);
     }
 
     if ((type == SharedConfig::TIMETYPE_UNTRACKED_REALTIME)) {
-        TimeHolder returnTicks = ticks + fakeExtraTicks;
-        returnTicks += realtime_delta;
-        return returnTicks;
+        return readTicks(false);
     }
 
     DEBUGLOGCALL(LCF_TIMEGET | LCF_FREQUENT);
@@ -118,12 +115,12 @@ struct timespec DeterministicTimer::getTicks(SharedConfig::TimeCallType type)
     if (!insideFrameBoundary && /* Don't track if already inside a frame boundary */
         gettimes_threshold >= 0) {
 
-        /* We actually track this time call */
-        std::lock_guard<std::mutex> lock(ticks_mutex);
-        int* gettimes_count = mainT ? &main_gettimes[type] : &sec_gettimes[type];
-        (*gettimes_count)++;
+        /* We actually track this time call. Only the call that reaches the
+         * limit advances time, even if other threads increment the count
+         * concurrently. */
+        std::atomic<int>& gettimes_count = mainT ? main_gettimes[type] : sec_gettimes[type];
 
-        if(*gettimes_count > gettimes_threshold) {
+        if ((gettimes_count.fetch_add(1, std::memory_order_relaxed) + 1) == (gettimes_threshold + 1)) {
             /*
              * We reached the limit of the number of calls.
              * We advance the deterministic timer by some value
@@ -136,16 +133,15 @@ struct timespec DeterministicTimer::getTicks(SharedConfig::TimeCallType type)
 
             /* Reseting the number of calls from all functions */
             for (int i = 0; i < SharedConfig::TIMETYPE_NUMTRACKEDTYPES; i++) {
-                main_gettimes[i] = 0;
-                sec_gettimes[i] = 0;
+                main_gettimes[i].store(0, std::memory_order_relaxed);
+                sec_gettimes[i].store(0, std::memory_order_relaxed);
             }
         }
     }
     else if (mainT && !insideFrameBoundary) {
         /* Still register calls to time functions, so that we can inform users
          * of potential options to tweak. */
-        main_gettimes[type]++;
-        if (main_gettimes[type] == ALERT_CALL_THRESHOLD) {            
+        if ((main_gettimes[type].fetch_add(1, std::memory_order_relaxed) + 1) == ALERT_CALL_THRESHOLD) {
             debuglogstdio(LCF_TIMESET | LCF_WARNING, "WARNING! many calls to function %s, you may need to enable time-tracking", gettimes_names[type]);
         }
     }
@@ -156,12 +152,41 @@ struct timespec DeterministicTimer::getTicks(SharedConfig::TimeCallType type)
         addDelay(delay);
     }
 
-    TimeHolder returnTicks = ticks + fakeExtraTicks;
-    if (!isTimeCallMonotonic(type))
-        returnTicks += realtime_delta;
+    return readTicks(isTimeCallMonotonic(type));
+}
+
+TimeHolder DeterministicTimer::readTicks(bool monotonic)
+{
+    TimeHolder returnTicks;
+    unsigned int seq;
+    do {
+        seq = ticks_seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            /* A modification is in progress */
+            continue;
+        }
+
+        returnTicks = ticks + fakeExtraTicks;
+        if (!monotonic)
+            returnTicks += realtime_delta;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || (seq != ticks_seq.load(std::memory_order_relaxed)));
+
     return returnTicks;
 }
 
+void DeterministicTimer::beginTicksWrite()
+{
+    ticks_seq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void DeterministicTimer::endTicksWrite()
+{
+    ticks_seq.fetch_add(1, std::memory_order_release);
+}
+
 void DeterministicTimer::addDelay(struct timespec delayTicks)
 {
     debuglogstdio(LCF_TIMESET | LCF_SLEEP, "%s call with delay %u.%010u sec", __func__, delayTicks.tv_sec, delayTicks.tv_nsec);
@@ -183,7 +208,9 @@ void DeterministicTimer::addDelay(struct timespec delayTicks)
         std::lock_guard<std::mutex> lock(ticks_mutex);
 
         addedDelay += delayTicks;
+        beginTicksWrite();
         ticks += delayTicks;
+        endTicksWrite();
     }
 
     if(!Global::shared_config.fastforward)
@@ -239,8 +266,8 @@ void DeterministicTimer::exitFrameBoundary()
 
     /* Reset the counts of each time get function */
     for (int i = 0; i < SharedConfig::TIMETYPE_NUMTRACKEDTYPES; i++) {
-        main_gettimes[i] = 0;
-        sec_gettimes[i] = 0;
+        main_gettimes[i].store(0, std::memory_order_relaxed);
+        sec_gettimes[i].store(0, std::memory_order_relaxed);
     }
 
     /* We sleep the right amount of time so that the game runs at normal speed */
@@ -311,11 +338,15 @@ TimeHolder DeterministicTimer::enterFrameBoundary()
      * the remaining length. Otherwise, we don't increment ticks, and we
      * decrement addedDelay by the time increment.
      */
+    std::unique_lock<std::mutex> lock(ticks_mutex);
     if (timeIncrement > addedDelay) {
         TimeHolder deltaTicks = timeIncrement - addedDelay;
+        beginTicksWrite();
         ticks += deltaTicks;
-        debuglogstdio(LCF_TIMESET, "%s added %u.%010u", __func__, deltaTicks.tv_sec, deltaTicks.tv_nsec);
+        endTicksWrite();
         addedDelay = {0, 0};
+        lock.unlock();
+        debuglogstdio(LCF_TIMESET, "%s added %u.%010u", __func__, deltaTicks.tv_sec, deltaTicks.tv_nsec);
     }
     else {
         addedDelay -= timeIncrement;
@@ -325,7 +356,10 @@ TimeHolder DeterministicTimer::enterFrameBoundary()
 }
 
 void DeterministicTimer::fakeAdvanceTimer(struct timespec extraTicks) {
+    std::lock_guard<std::mutex> lock(ticks_mutex);
+    beginTicksWrite();
     fakeExtraTicks = extraTicks;
+    endTicksWrite();
 }
 
 void DeterministicTimer::fakeAdvanceTimerFrame() {
@@ -339,29 +373,34 @@ void DeterministicTimer::fakeAdvanceTimerFrame() {
 
     timeIncrement.tv_nsec+=1000000;
 
+    std::lock_guard<std::mutex> lock(ticks_mutex);
     if (timeIncrement > addedDelay) {
+        beginTicksWrite();
         fakeExtraTicks = timeIncrement - addedDelay;
+        endTicksWrite();
     }
 }
 
 void DeterministicTimer::initialize(uint64_t initial_sec, uint64_t initial_nsec)
 {
+    beginTicksWrite();
     ticks = {initial_sec, initial_nsec};
     
     realtime_delta = {Global::shared_config.initial_time_sec, Global::shared_config.initial_time_nsec};
     realtime_delta -= ticks;
+    fakeExtraTicks = {0, 0};
+    endTicksWrite();
 
     setFramerate(Global::shared_config.initial_framerate_num, Global::shared_config.initial_framerate_den);
 
     NATIVECALL(clock_gettime(CLOCK_MONOTONIC, &lastEnterTime));
 
     for (int i = 0; i < SharedConfig::TIMETYPE_NUMTRACKEDTYPES; i++) {
-        main_gettimes[i] = 0;
-        sec_gettimes[i] = 0;
+        main_gettimes[i].store(0, std::memory_order_relaxed);
+        sec_gettimes[i].store(0, std::memory_order_relaxed);
     }
 
     addedDelay = {0, 0};
-    fakeExtraTicks = {0, 0};
 
     inited = true;
 }
@@ -379,7 +418,11 @@ void DeterministicTimer::setRealTime(uint32_t new_realtime_sec, uint32_t new_rea
     TimeHolder th_real;
     th_real.tv_sec = new_realtime_sec;
     th_real.tv_nsec = new_realtime_nsec;
+
+    std::lock_guard<std::mutex> lock(ticks_mutex);
+    beginTicksWrite();
     realtime_delta = th_real - ticks;
+    endTicksWrite();
 }
 
 void DeterministicTimer::setFramerate(uint32_t new_framerate_num, uint32_t new_framerate_den)
@@ -24,6 +24,7 @@
 #include "../shared/SharedConfig.h"
 
 #include <mutex>
+#include <atomic>
 
 namespace libtas {
 /* A timer that gives deterministic values, at least in the main thread.
@@ -95,6 +96,13 @@ public:
 
 private:
 
+    /* Return the time seen by the game, without locking */
+    TimeHolder readTicks(bool monotonic);
+
+    /* Surround each modification of ticks, fakeExtraTicks or realtime_delta */
+    void beginTicksWrite();
+    void endTicksWrite();
+
     bool insideFrameBoundary = false;
 
     /* By how much time do we increment the timer, excluding fractional part.
@@ -135,12 +143,17 @@ private:
     TimeHolder addedDelay;
 
     /* Count for each time-getting method before time auto-advances to
-     * avoid a freeze. Distinguish between main and secondary threads.
+     * avoid a freeze. Distinguish between main and secondary threads, which
+     * are kept on separate cache lines.
      */
-    int main_gettimes[SharedConfig::TIMETYPE_NUMTRACKEDTYPES];
-    int sec_gettimes[SharedConfig::TIMETYPE_NUMTRACKEDTYPES];
+    std::atomic<int> main_gettimes[SharedConfig::TIMETYPE_NUMTRACKEDTYPES];
+    alignas(64) std::atomic<int> sec_gettimes[SharedConfig::TIMETYPE_NUMTRACKEDTYPES];
+
+    /* Sequence counter so that time functions can read the ticks value
+     * without locking. It is odd while the value is being modified. */
+    alignas(64) std::atomic<unsigned int> ticks_seq{0};
 
-    /* Mutex to protect access to the ticks value */
+    /* Mutex to serialize modifications of the ticks value */
     std::mutex ticks_mutex;
     std::mutex frame_mutex;
 
@@ -0,0 +1,142 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "FrameTiming.h"
+#include "global.h"
+#include "GlobalState.h"
+#include "../shared/sockethelpers.h"
+#include "../shared/messages.h"
+
+#include <time.h>
+
+namespace libtas {
+
+/* Record being filled */
+static FrameTrace::Record current_record;
+
+/* Last closed record, waiting to be sent */
+static FrameTrace::Record last_record;
+static bool has_last_record = false;
+
+static int current_phase = -1;
+static uint64_t phase_start = 0;
+
+/* Accumulated duration of each phase in the current frame */
+static uint64_t durations[FrameTrace::GAME_PHASES];
+
+/* Start time and accumulated duration of each counter in the current frame */
+static uint64_t counter_starts[FrameTiming::COUNTERS];
+static uint64_t counter_durations[FrameTiming::COUNTERS];
+
+static float history[FrameTrace::GAME_PHASES][FrameTiming::HISTORY_SIZE];
+static float counter_history[FrameTiming::COUNTERS][FrameTiming::HISTORY_SIZE];
+static int history_index = 0;
+
+static uint64_t now()
+{
+    struct timespec ts;
+    NATIVECALL(clock_gettime(CLOCK_MONOTONIC, &ts));
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+void FrameTiming::switchPhase(FrameTrace::GamePhase phase)
+{
+    uint64_t t = now();
+
+    if (current_phase >= 0) {
+        uint64_t duration = t - phase_start;
+        durations[current_phase] += duration;
+
+        /* Extend the previous segment if it is the same phase, otherwise add
+         * a new segment. Extra segments are dropped from the timeline, but
+         * still accounted in the durations */
+        uint32_t count = current_record.segment_count;
+        FrameTrace::Segment* last = count ? &current_record.segments[count-1] : nullptr;
+        if (last && (last->phase == static_cast<uint32_t>(current_phase))) {
+            last->duration = static_cast<uint32_t>(t - last->start);
+        }
+        else if (count < FrameTrace::MAX_SEGMENTS) {
+            FrameTrace::Segment& segment = current_record.segments[count];
+            segment.start = phase_start;
+            segment.duration = static_cast<uint32_t>(duration);
+            segment.phase = current_phase;
+            current_record.segment_count++;
+        }
+    }
+
+    current_phase = phase;
+    phase_start = t;
+}
+
+void FrameTiming::startCounter(Counter counter)
+{
+    counter_starts[counter] = now();
+}
+
+void FrameTiming::stopCounter(Counter counter)
+{
+    counter_durations[counter] += now() - counter_starts[counter];
+}
+
+void FrameTiming::endFrame(uint64_t framecount)
+{
+    switchPhase(FrameTrace::GAME_RUN);
+
+    current_record.framecount = framecount;
+    last_record = current_record;
+    has_last_record = true;
+
+    for (int p = 0; p < FrameTrace::GAME_PHASES; p++) {
+        history[p][history_index] = durations[p] / 1000000.0f;
+        durations[p] = 0;
+    }
+    for (int c = 0; c < COUNTERS; c++) {
+        counter_history[c][history_index] = counter_durations[c] / 1000000.0f;
+        counter_durations[c] = 0;
+    }
+    history_index = (history_index + 1) % HISTORY_SIZE;
+
+    /* The game phase that just started belongs to the next record */
+    current_record.segment_count = 0;
+}
+
+void FrameTiming::send()
+{
+    if (!Global::shared_config.frame_trace || !has_last_record)
+        return;
+
+    sendMessage(MSGB_FRAME_TRACE);
+    sendData(&last_record, sizeof(FrameTrace::Record));
+    has_last_record = false;
+}
+
+const float* FrameTiming::getHistory(int phase, int* offset)
+{
+    *offset = history_index;
+    return history[phase];
+}
+
+const float* FrameTiming::getCounterHistory(int counter, int* offset)
+{
+    *offset = history_index;
+    return counter_history[counter];
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBTAS_FRAMETIMING_H_INCL
+#define LIBTAS_FRAMETIMING_H_INCL
+
+#include "../shared/FrameTrace.h"
+
+#include <cstdint>
+
+namespace libtas {
+
+/* Finer-grained timing of each phase of a frame, as a timeline of segments.
+ * Unlike PerfTimer, it is reset on each frame, so that it can be shown in
+ * the HUD and sent to the program for tracing. It must only be called from
+ * the main thread. */
+namespace FrameTiming
+{
+    enum {
+        HISTORY_SIZE = 240,
+    };
+
+    /* Operations timed inside phases */
+    enum Counter {
+        COUNTER_ENCODE, // audio and video encoding
+        COUNTER_SAVESTATE, // saving a state
+        COUNTERS,
+    };
+
+    /* Close the current phase and start a new one */
+    void switchPhase(FrameTrace::GamePhase phase);
+
+    /* Start and stop timing an operation. The duration is added to the
+     * counter of the current frame */
+    void startCounter(Counter counter);
+    void stopCounter(Counter counter);
+
+    /* Close the record of the current frame and start the record of the next one */
+    void endFrame(uint64_t framecount);
+
+    /* Send the last closed record to the program if frame tracing is enabled.
+     * The socket must be locked. */
+    void send();
+
+    /* Returns the duration in milliseconds of a phase for the last frames,
+     * as a circular buffer of size HISTORY_SIZE starting at `offset` */
+    const float* getHistory(int phase, int* offset);
+
+    /* Same as above for a counter */
+    const float* getCounterHistory(int counter, int* offset);
+}
+
+}
+
+#endif
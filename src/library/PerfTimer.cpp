@@ -46,6 +46,23 @@ PerfTimer::TimerType PerfTimer::currentTimer()
     return current_type;
 }
 
+TimeHolder PerfTimer::activeTime()
+{
+    TimeHolder total;
+    for (int i=0; i < TotalTimer; i++) {
+        if (i != IdleTimer)
+            total += elapsed[i];
+    }
+
+    if (current_type != NoTimer && current_type != IdleTimer) {
+        TimeHolder end_time;
+        NATIVECALL(clock_gettime(CLOCK_MONOTONIC, &end_time));
+        total += (end_time - current_time[current_type]);
+    }
+
+    return total;
+}
+
 void PerfTimer::print()
 {
     debuglogstdio(LCF_INFO, "Game timer took %d.%03d sec", elapsed[GameTimer].tv_sec, elapsed[GameTimer].tv_nsec / 1000000);
@@ -45,6 +45,10 @@ class PerfTimer
         TimerType currentTimer();
         void print();
 
+        /* Time spent in all timers except the idle timer, including the
+         * running one */
+        TimeHolder activeTime();
+
     private:
         
         TimeHolder current_time[TotalTimer];
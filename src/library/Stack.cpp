@@ -47,14 +47,9 @@ void Stack::grow()
 
 #ifdef __unix__
     /* Find the current stack area */
-    ProcSelfMaps procSelfMaps;
     Area stackArea;
     uintptr_t stackPointer = reinterpret_cast<uintptr_t>(&stackArea);
-    while (procSelfMaps.getNextArea(&stackArea)) {
-        if ((stackPointer >= reinterpret_cast<uintptr_t>(stackArea.addr)) && (stackPointer < reinterpret_cast<uintptr_t>(stackArea.endAddr))) {
-            break;
-        }
-    }
+    ProcSelfMaps::getAreaAt(stackPointer, &stackArea);
 
     /* Check if we found the stack */
     if (!stackArea.addr) {
@@ -78,16 +73,12 @@ void Stack::grow()
     /* Look at the new stack area */
     /* Apparently, if we don't use another local variable here, the compiler
      * optimizes the alloca code above! */
-    ProcSelfMaps newProcSelfMaps;
-    while (newProcSelfMaps.getNextArea(&stackArea)) {
-        if ((stackPointer >= reinterpret_cast<uintptr_t>(stackArea.addr)) && (stackPointer < reinterpret_cast<uintptr_t>(stackArea.endAddr))) {
-            break;
-        }
-    }
+    Area newStackArea;
+    ProcSelfMaps::getAreaAt(stackPointer, &newStackArea);
 
     /* Check if we found the stack */
-    if (stackArea.addr) {
-        // debuglogstdio(LCF_INFO, "New stack size is %d", stackArea.size);
+    if (newStackArea.addr) {
+        // debuglogstdio(LCF_INFO, "New stack size is %d", newStackArea.size);
         return;
     }
 #endif
@@ -24,6 +24,11 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
 
 namespace libtas {
 
@@ -80,6 +85,89 @@ ssize_t Utils::readAll(int fd, void *buf, size_t count)
     return num_read;
 }
 
+// Copy the first count bytes of in_fd at the beginning of out_fd, inside the
+// kernel when possible (returns num copied, less than count on EOF).
+// The file offset of in_fd is left untouched, but not the one of out_fd.
+// return value:
+// -1: unrecoverable error
+// <n>: number of bytes copied
+ssize_t Utils::copyAll(int out_fd, int in_fd, size_t count)
+{
+    off_t in_off = 0;
+    off_t out_off = 0;
+    size_t num_copied = 0;
+
+#ifdef __linux__
+#ifdef SYS_copy_file_range
+    /* Works between two memfds, and between files of the same filesystem on
+     * recent kernels. Fails with EXDEV or EINVAL otherwise. */
+    while (num_copied < count) {
+        ssize_t rc = syscall(SYS_copy_file_range, in_fd, &in_off, out_fd, &out_off, count - num_copied, 0);
+        if (rc == -1) {
+            if (errno == EINTR)
+                continue;
+            break;
+        } else if (rc == 0) {
+            return num_copied;
+        }
+        num_copied += rc;
+    }
+    if (num_copied == count)
+        return num_copied;
+#endif
+
+    /* sendfile writes at the current offset of out_fd, and only requires
+     * in_fd to be mmap-able, which is the case for regular files and memfds */
+    if (lseek(out_fd, out_off, SEEK_SET) != -1) {
+        while (num_copied < count) {
+            ssize_t rc = sendfile(out_fd, in_fd, &in_off, count - num_copied);
+            if (rc == -1) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            } else if (rc == 0) {
+                return num_copied;
+            }
+            num_copied += rc;
+            out_off += rc;
+        }
+        if (num_copied == count)
+            return num_copied;
+    }
+#endif
+
+    /* Fallback to a copy through userspace */
+    char buf[4096];
+    while (num_copied < count) {
+        size_t len = count - num_copied;
+        if (len > sizeof(buf))
+            len = sizeof(buf);
+        ssize_t rc = pread(in_fd, buf, len, in_off);
+        if (rc == -1) {
+            if (errno == EINTR)
+                continue;
+            debuglogstdio(LCF_ERROR, "Copy from file %d failed with errno %d", in_fd, errno);
+            return -1;
+        } else if (rc == 0) {
+            break;
+        }
+        for (ssize_t w = 0; w < rc;) {
+            ssize_t wc = pwrite(out_fd, buf + w, rc - w, out_off + w);
+            if (wc == -1) {
+                if (errno == EINTR)
+                    continue;
+                debuglogstdio(LCF_ERROR, "Copy to file %d failed with errno %d", out_fd, errno);
+                return -1;
+            }
+            w += wc;
+        }
+        in_off += rc;
+        out_off += rc;
+        num_copied += rc;
+    }
+    return num_copied;
+}
+
 /* This function detects if the given page is zero pages or not. There is
  * scope of improving this function using some optimizations.
  *
@@ -30,6 +30,7 @@ namespace Utils
 {
     ssize_t writeAll(int fd, const void *buf, size_t count);
     ssize_t readAll(int fd, void *buf, size_t count);
+    ssize_t copyAll(int out_fd, int in_fd, size_t count);
     bool isZeroPage(void *addr);
 }
 }
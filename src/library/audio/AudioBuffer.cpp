@@ -114,6 +114,23 @@ bool AudioBuffer::checkSize(void)
     return true;
 }
 
+int AudioBuffer::countSamples(int nbSamples, int position, bool loopstatic)
+{
+    if (size == 0)
+        return 0;
+
+    if (position >= sampleSize)
+        return 0;
+
+    int endPosition = sampleSize;
+
+    /* Loop points are only considered for uncompressed formats, as in getSamples() */
+    if (loopstatic && (loop_point_end != 0) && (format != SAMPLE_FMT_MSADPCM))
+        endPosition = loop_point_end;
+
+    return std::min(nbSamples, endPosition - position);
+}
+
 int AudioBuffer::getSamples(uint8_t* &outSamples, int nbSamples, int position, bool loopstatic)
 {
     /* If the buffer is empty (e.g. for ALSA we push an empty buffer to save
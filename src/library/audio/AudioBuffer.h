@@ -48,6 +48,10 @@ class AudioBuffer
          */
         int getSamples( uint8_t* &outSamples, int outNbSamples, int position, bool loopstatic);
 
+        /* Same as getSamples(), but only returns the number of samples that
+         * would be returned, without accessing or decoding them */
+        int countSamples(int outNbSamples, int position, bool loopstatic);
+
         /* Identifier of the buffer */
         int id;
 
@@ -20,6 +20,7 @@
 #include "AudioContext.h"
 #include "AudioBuffer.h"
 #include "AudioSource.h"
+#include "AudioMixer.h"
 #ifdef __linux__
 #include "AudioPlayerAlsa.h"
 #elif defined(__APPLE__) && defined(__MACH__)
@@ -206,6 +207,14 @@ std::shared_ptr<AudioSource> AudioContext::getSource(int id) const
     return nullptr;
 }
 
+bool AudioContext::isMixingSkipped()
+{
+    return !Global::shared_config.av_dumping && 
+        (Global::shared_config.audio_mute ||
+            (Global::shared_config.fastforward && 
+                (Global::shared_config.fastforward_mode & SharedConfig::FF_MIXING)));
+}
+
 void AudioContext::mixAllSources(int nbSamples)
 {
     return mixAllSources(samplesToTicks(nbSamples, outFrequency));
@@ -234,6 +243,14 @@ void AudioContext::mixAllSources(struct timespec ticks)
 
     if (paused) return;
 
+    /* Sources are accumulated into a float bus, which is clamped at the end.
+     * When mixing is skipped, sources only advance and the bus is unused. */
+    bool skipMixing = isMixingSkipped();
+    if (skipMixing)
+        mixBus.clear();
+    else
+        mixBus.assign(outNbSamples*outNbChannels, 0.0f);
+
     pthread_t mix_thread = ThreadManager::getThreadId();
 
     mutex.lock();
@@ -265,11 +282,22 @@ void AudioContext::mixAllSources(struct timespec ticks)
             }
         }
 
-        source->mixWith(ticks, &outSamples[0], outBytes, outBitDepth, outNbChannels, outFrequency, outVolume);
+        source->mixWith(ticks, mixBus.data(), outBytes, outBitDepth, outNbChannels, outFrequency, outVolume);
     }
     
     mutex.unlock();
 
+    if (!skipMixing) {
+        int saturated = 0;
+        if (outBitDepth == 8)
+            saturated = AudioMixer::clampU8(mixBus.data(), outSamples.data(), outNbSamples*outNbChannels);
+        if (outBitDepth == 16)
+            saturated = AudioMixer::clampS16(mixBus.data(), reinterpret_cast<int16_t*>(outSamples.data()), outNbSamples*outNbChannels);
+
+        if (saturated > 0)
+            debuglogstdio(LCF_SOUND | LCF_WARNING, "Audio mixing clipped %d samples", saturated);
+    }
+
     if (!isLoopback && !Global::shared_config.audio_mute) {
         /* Play the music */
 #ifdef __linux__
@@ -45,6 +45,10 @@ class AudioContext
 
         static AudioContext& get();
 
+        /* Returns if sources must only advance their position without
+         * mixing samples, when audio is muted or during fast-forward */
+        static bool isMixingSkipped();
+
         /* Master volume.
          * Can be larger than 1 but output volume will be clamped to one */
         float outVolume;
@@ -64,6 +68,9 @@ class AudioContext
         /* Mixed buffer during a frame */
         std::vector<uint8_t> outSamples;
 
+        /* Accumulation bus of all sources during a frame, before clamping */
+        std::vector<float> mixBus;
+
         /* Size of the mixed buffer in samples */
         int outNbSamples;
 
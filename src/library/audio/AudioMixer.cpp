@@ -0,0 +1,149 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "AudioMixer.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace libtas {
+
+void AudioMixer::accumulateU8(float* bus, const uint8_t* samples, int nbValues, float volume)
+{
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i center = _mm_set1_epi16(128);
+    const __m128 vol = _mm_set1_ps(volume);
+    for (; i + 16 <= nbValues; i += 16) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+
+        /* Expand to signed 16-bit centered on zero */
+        __m128i s16[2];
+        s16[0] = _mm_sub_epi16(_mm_unpacklo_epi8(s, zero), center);
+        s16[1] = _mm_sub_epi16(_mm_unpackhi_epi8(s, zero), center);
+
+        for (int h = 0; h < 2; h++) {
+            /* Sign-extend to 32-bit */
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s16[h], s16[h]), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s16[h], s16[h]), 16);
+            float* b = bus + i + 8*h;
+            _mm_storeu_ps(b, _mm_add_ps(_mm_loadu_ps(b), _mm_mul_ps(_mm_cvtepi32_ps(lo), vol)));
+            _mm_storeu_ps(b + 4, _mm_add_ps(_mm_loadu_ps(b + 4), _mm_mul_ps(_mm_cvtepi32_ps(hi), vol)));
+        }
+    }
+#endif
+    for (; i < nbValues; i++)
+        bus[i] += (static_cast<int>(samples[i]) - 128) * volume;
+}
+
+void AudioMixer::accumulateS16(float* bus, const int16_t* samples, int nbValues, float volume)
+{
+    int i = 0;
+#ifdef __SSE2__
+    const __m128 vol = _mm_set1_ps(volume);
+    for (; i + 8 <= nbValues; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+
+        /* Sign-extend to 32-bit */
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        _mm_storeu_ps(bus + i, _mm_add_ps(_mm_loadu_ps(bus + i), _mm_mul_ps(_mm_cvtepi32_ps(lo), vol)));
+        _mm_storeu_ps(bus + i + 4, _mm_add_ps(_mm_loadu_ps(bus + i + 4), _mm_mul_ps(_mm_cvtepi32_ps(hi), vol)));
+    }
+#endif
+    for (; i < nbValues; i++)
+        bus[i] += samples[i] * volume;
+}
+
+int AudioMixer::clampU8(const float* bus, uint8_t* samples, int nbValues)
+{
+    int nbSaturate = 0;
+    int i = 0;
+#ifdef __SSE2__
+    const __m128 minv = _mm_set1_ps(-128.0f);
+    const __m128 maxv = _mm_set1_ps(127.0f);
+    const __m128i center = _mm_set1_epi16(128);
+    for (; i + 8 <= nbValues; i += 8) {
+        __m128 a = _mm_loadu_ps(bus + i);
+        __m128 b = _mm_loadu_ps(bus + i + 4);
+
+        int mask = _mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(a, minv), _mm_cmpgt_ps(a, maxv)));
+        mask |= _mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(b, minv), _mm_cmpgt_ps(b, maxv))) << 4;
+        nbSaturate += __builtin_popcount(mask);
+
+        a = _mm_min_ps(_mm_max_ps(a, minv), maxv);
+        b = _mm_min_ps(_mm_max_ps(b, minv), maxv);
+        __m128i s16 = _mm_add_epi16(_mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)), center);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(samples + i), _mm_packus_epi16(s16, s16));
+    }
+#endif
+    for (; i < nbValues; i++) {
+        float v = bus[i];
+        if (v < -128.0f) {
+            v = -128.0f;
+            nbSaturate++;
+        }
+        else if (v > 127.0f) {
+            v = 127.0f;
+            nbSaturate++;
+        }
+        samples[i] = static_cast<uint8_t>(static_cast<int>(v) + 128);
+    }
+    return nbSaturate;
+}
+
+int AudioMixer::clampS16(const float* bus, int16_t* samples, int nbValues)
+{
+    int nbSaturate = 0;
+    int i = 0;
+#ifdef __SSE2__
+    const __m128 minv = _mm_set1_ps(-32768.0f);
+    const __m128 maxv = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= nbValues; i += 8) {
+        __m128 a = _mm_loadu_ps(bus + i);
+        __m128 b = _mm_loadu_ps(bus + i + 4);
+
+        int mask = _mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(a, minv), _mm_cmpgt_ps(a, maxv)));
+        mask |= _mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(b, minv), _mm_cmpgt_ps(b, maxv))) << 4;
+        nbSaturate += __builtin_popcount(mask);
+
+        a = _mm_min_ps(_mm_max_ps(a, minv), maxv);
+        b = _mm_min_ps(_mm_max_ps(b, minv), maxv);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + i), _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+    }
+#endif
+    for (; i < nbValues; i++) {
+        float v = bus[i];
+        if (v < -32768.0f) {
+            v = -32768.0f;
+            nbSaturate++;
+        }
+        else if (v > 32767.0f) {
+            v = 32767.0f;
+            nbSaturate++;
+        }
+        samples[i] = static_cast<int16_t>(v);
+    }
+    return nbSaturate;
+}
+
+}
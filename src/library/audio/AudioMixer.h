@@ -0,0 +1,50 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBTAS_AUDIOMIXER_H_INCL
+#define LIBTAS_AUDIOMIXER_H_INCL
+
+#include <cstdint>
+
+namespace libtas {
+
+/* Functions to mix audio sources into a float accumulation bus, and to convert
+ * the bus into the output sample format once all sources have been mixed.
+ * Samples are interleaved, and `nbValues` is the number of samples multiplied
+ * by the number of channels. Uses SSE2 when available. */
+namespace AudioMixer {
+
+    /* Add `nbValues` unsigned 8-bit samples multiplied by `volume` to the bus */
+    void accumulateU8(float* bus, const uint8_t* samples, int nbValues, float volume);
+
+    /* Add `nbValues` signed 16-bit samples multiplied by `volume` to the bus */
+    void accumulateS16(float* bus, const int16_t* samples, int nbValues, float volume);
+
+    /* Clamp the bus into unsigned 8-bit samples. Returns the number of
+     * saturated values */
+    int clampU8(const float* bus, uint8_t* samples, int nbValues);
+
+    /* Clamp the bus into signed 16-bit samples. Returns the number of
+     * saturated values */
+    int clampS16(const float* bus, int16_t* samples, int nbValues);
+}
+}
+
+#endif
@@ -23,12 +23,24 @@
 #include "logging.h"
 #include "global.h" // Global::shared_config
 #include "GlobalState.h"
+#include "checkpoint/ThreadSync.h" // futexWait, futexWake
+
+#include <algorithm> // std::min
+#include <cstring> // memcpy
+#include <time.h>
 
 namespace libtas {
 
 snd_pcm_t *AudioPlayerAlsa::phandle;
 AudioPlayerAlsa::APStatus AudioPlayerAlsa::status = STATUS_UNINIT;
 std::vector<uint8_t> AudioPlayerAlsa::silence;
+std::vector<uint8_t> AudioPlayerAlsa::ring;
+std::atomic<uint32_t> AudioPlayerAlsa::ringWrite(0);
+std::atomic<uint32_t> AudioPlayerAlsa::ringRead(0);
+int AudioPlayerAlsa::alignSize = 1;
+pthread_t AudioPlayerAlsa::playbackThread;
+std::atomic<bool> AudioPlayerAlsa::playbackSleeping(false);
+std::atomic<bool> AudioPlayerAlsa::playbackQuit(false);
 
 bool AudioPlayerAlsa::init(AudioContext& ac)
 {
@@ -51,6 +63,15 @@ bool AudioPlayerAlsa::init(AudioContext& ac)
         silence.assign(sil_bytes, 0x00);
     }
 
+    /* Build a ring that can hold at least 200 ms of samples */
+    size_t ring_size = 1;
+    while (ring_size < static_cast<size_t>(0.2 * ac.outFrequency * ac.outAlignSize))
+        ring_size <<= 1;
+    ring.assign(ring_size, 0);
+    ringWrite = 0;
+    ringRead = 0;
+    alignSize = ac.outAlignSize;
+
     GlobalNative gn;
 
     if (snd_pcm_open(&phandle, "default", SND_PCM_STREAM_PLAYBACK, 0) < 0) {
@@ -111,9 +132,94 @@ bool AudioPlayerAlsa::init(AudioContext& ac)
 
     snd_pcm_hw_params_free(hw_params);
 
+    /* Start the playback thread, which is created natively because it is
+     * stopped before any savestate */
+    playbackQuit = false;
+    playbackSleeping = false;
+    if (pthread_create(&playbackThread, nullptr, playbackLoop, nullptr) != 0) {
+        debuglogstdio(LCF_SOUND | LCF_ERROR, "  Could not create the playback thread");
+        snd_pcm_close(phandle);
+        return false;
+    }
+
     return true;
 }
 
+bool AudioPlayerAlsa::write(const uint8_t* samples, int nbSamples)
+{
+    while (nbSamples > 0) {
+        int err = snd_pcm_writei(phandle, samples, nbSamples);
+        if (err >= 0) {
+            samples += err * alignSize;
+            nbSamples -= err;
+            continue;
+        }
+
+        if (err == -EPIPE) {
+            debuglogstdio(LCF_SOUND, "  Underrun");
+            err = snd_pcm_prepare(phandle);
+            if (err < 0) {
+                debuglogstdio(LCF_SOUND | LCF_ERROR, "  Can't recovery from underrun, prepare failed: %s", snd_strerror(err));
+                return false;
+            }
+
+            /* Send silence bytes first */
+            snd_pcm_writei(phandle, silence.data(), silence.size()/alignSize);
+        }
+        else if (err != -EINTR && err != -EAGAIN) {
+            debuglogstdio(LCF_SOUND | LCF_ERROR, "  snd_pcm_writei() failed: %s", snd_strerror (err));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void* AudioPlayerAlsa::playbackLoop(void* arg)
+{
+    GlobalNative gn;
+    std::vector<uint8_t> samples;
+
+    while (!playbackQuit) {
+        uint32_t read = ringRead.load(std::memory_order_relaxed);
+        uint32_t written = ringWrite.load();
+        uint32_t available = written - read;
+
+        if (available == 0) {
+            /* Wait for the mixer to push samples. The flag is set before
+             * checking the write position again, so that the mixer only
+             * needs to wake us when we are about to sleep. */
+            playbackSleeping = true;
+            if ((ringWrite.load() == written) && !playbackQuit) {
+                struct timespec deadline;
+                clock_gettime(CLOCK_MONOTONIC, &deadline);
+                deadline.tv_nsec += 100 * 1000 * 1000;
+                if (deadline.tv_nsec >= 1000000000) {
+                    deadline.tv_sec++;
+                    deadline.tv_nsec -= 1000000000;
+                }
+                ThreadSync::futexWait(&ringWrite, written, &deadline);
+            }
+            playbackSleeping = false;
+            continue;
+        }
+
+        /* Copy the samples out of the ring, so that the mixer can reuse
+         * that space while we are blocked writing to the device */
+        samples.resize(available);
+        uint32_t mask = ring.size() - 1;
+        uint32_t start = read & mask;
+        uint32_t first = std::min<uint32_t>(available, ring.size() - start);
+        memcpy(samples.data(), &ring[start], first);
+        memcpy(samples.data() + first, ring.data(), available - first);
+        ringRead.store(read + available, std::memory_order_release);
+
+        write(samples.data(), available / alignSize);
+    }
+
+    return nullptr;
+}
+
 bool AudioPlayerAlsa::play(AudioContext& ac)
 {
     if (status == STATUS_UNINIT) {
@@ -131,36 +237,27 @@ bool AudioPlayerAlsa::play(AudioContext& ac)
         return true;
 
     debuglogstdio(LCF_SOUND, "Play an audio frame");
-    int err;
-    {
-        GlobalNative gn;
-        err = snd_pcm_writei(phandle, ac.outSamples.data(), ac.outNbSamples);
-    }
-	if (err < 0) {
-		if (err == -EPIPE) {
-			debuglogstdio(LCF_SOUND, "  Underrun");
-            {
-                GlobalNative gn;
-	            err = snd_pcm_prepare(phandle);
-            }
-			if (err < 0) {
-				debuglogstdio(LCF_SOUND | LCF_ERROR, "  Can't recovery from underrun, prepare failed: %s", snd_strerror(err));
-			    return false;
-            }
-            else {
-                {
-                    GlobalNative gn;
-                    /* Send silence bytes first */
-                    snd_pcm_writei(phandle, silence.data(), silence.size()/ac.outAlignSize);
-                    snd_pcm_writei(phandle, ac.outSamples.data(), ac.outNbSamples);
-                }
-            }
-		}
-		else {
-			debuglogstdio(LCF_SOUND | LCF_ERROR, "  snd_pcm_writei() failed: %s", snd_strerror (err));
-			return false;
-		}
-	}
+
+    /* Push the samples into the ring, or drop them if the playback thread
+     * is late, as the device cannot keep up anyway */
+    uint32_t size = ac.outNbSamples * ac.outAlignSize;
+    uint32_t written = ringWrite.load(std::memory_order_relaxed);
+    uint32_t read = ringRead.load(std::memory_order_acquire);
+    if (size > ring.size() - (written - read)) {
+        debuglogstdio(LCF_SOUND | LCF_WARNING, "  Audio ring is full, dropping samples");
+        return true;
+    }
+
+    uint32_t mask = ring.size() - 1;
+    uint32_t start = written & mask;
+    uint32_t first = std::min<uint32_t>(size, ring.size() - start);
+    memcpy(&ring[start], ac.outSamples.data(), first);
+    memcpy(ring.data(), ac.outSamples.data() + first, size - first);
+    ringWrite.store(written + size);
+
+    /* Wake the playback thread if it is waiting for samples */
+    if (playbackSleeping.exchange(false))
+        ThreadSync::futexWake(&ringWrite);
 
     return true;
 }
@@ -168,7 +265,14 @@ bool AudioPlayerAlsa::play(AudioContext& ac)
 void AudioPlayerAlsa::close()
 {
     if (status == STATUS_OK) {
+        /* Stop the playback thread first */
+        playbackQuit = true;
+        ThreadSync::futexWake(&ringWrite);
+        NATIVECALL(pthread_join(playbackThread, nullptr));
+
         MYASSERT(snd_pcm_close(phandle) == 0)
+        ringWrite = 0;
+        ringRead = 0;
         status = STATUS_UNINIT;
     }
 }
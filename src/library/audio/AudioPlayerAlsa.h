@@ -23,12 +23,17 @@
 #include <alsa/asoundlib.h>
 #include <stdint.h>
 #include <vector>
+#include <atomic>
+#include <pthread.h>
 
 namespace libtas {
 
 class AudioContext;
 
-/* Class in charge of sending the mixed samples to the audio device */
+/* Class in charge of sending the mixed samples to the audio device. Samples
+ * are pushed by the mixing thread into a single-producer single-consumer
+ * ring, and written to the device by a dedicated playback thread, so that
+ * blocking writes and underruns do not stall the game. */
 class AudioPlayerAlsa
 {
 private:
@@ -45,6 +50,27 @@ private:
     static snd_pcm_t *phandle;
 
     static std::vector<uint8_t> silence;
+
+    /* Ring of mixed samples. Positions are byte counts that wrap around,
+     * so the ring size must be a power of two. The write position is also
+     * used as a futex word to wake the playback thread. */
+    static std::vector<uint8_t> ring;
+    static std::atomic<uint32_t> ringWrite;
+    static std::atomic<uint32_t> ringRead;
+
+    /* Size of one sample frame in bytes */
+    static int alignSize;
+
+    /* Playback thread and its state */
+    static pthread_t playbackThread;
+    static std::atomic<bool> playbackSleeping;
+    static std::atomic<bool> playbackQuit;
+
+    /* Loop of the playback thread, writing samples from the ring */
+    static void* playbackLoop(void* arg);
+
+    /* Write samples to the device, recovering from underruns */
+    static bool write(const uint8_t* samples, int nbSamples);
     
 public:
     /* Init the connection to the server.
@@ -18,8 +18,10 @@
  */
 
 #include "AudioSource.h"
+#include "AudioContext.h"
 #include "AudioConverter.h"
 #include "AudioBuffer.h"
+#include "AudioMixer.h"
 #ifdef __unix__
 #include "AudioConverterSwr.h"
 #elif defined(__APPLE__) && defined(__MACH__)
@@ -32,6 +34,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <cstring>
 
 namespace libtas {
 
@@ -83,6 +86,39 @@ void AudioSource::rewind(void)
 void AudioSource::dirty(void)
 {
     audioConverter->dirty();
+    mixPath = MIX_UNDETERMINED;
+}
+
+void AudioSource::queueSamples(const uint8_t* samples, int nbSamples)
+{
+    if (mixPath == MIX_CONVERTER) {
+        audioConverter->queueSamples(samples, nbSamples);
+        return;
+    }
+
+    /* Samples are already in the output format, copy them as is */
+    int bytes = nbSamples * mixAlignSize;
+    int avail = static_cast<int>(mixedSamples.size()) - mixedBytes;
+    if (bytes > avail)
+        bytes = avail;
+    if (bytes > 0) {
+        memcpy(mixedSamples.data() + mixedBytes, samples, bytes);
+        mixedBytes += bytes;
+    }
+}
+
+int AudioSource::readSamples(AudioBuffer& buffer, int nbSamples, int position, bool loopstatic, bool skipMixing)
+{
+    /* When not mixing, only compute how far we advance in the buffer, without
+     * accessing or decoding samples */
+    if (skipMixing)
+        return buffer.countSamples(nbSamples, position, loopstatic);
+
+    uint8_t* begSamples;
+    int availableSamples = buffer.getSamples(begSamples, nbSamples, position, loopstatic);
+    if (availableSamples > 0)
+        queueSamples(begSamples, availableSamples);
+    return availableSamples;
 }
 
 int AudioSource::nbQueue()
@@ -178,7 +214,7 @@ bool AudioSource::willEnd(struct timespec ticks)
 }
 
 
-int AudioSource::mixWith( struct timespec ticks, uint8_t* outSamples, int outBytes, int outBitDepth, int outNbChannels, int outFrequency, float outVolume)
+int AudioSource::mixWith( struct timespec ticks, float* mixBus, int outBytes, int outBitDepth, int outNbChannels, int outFrequency, float outVolume)
 {
     if (state != SOURCE_PLAYING)
         return -1;
@@ -188,34 +224,56 @@ int AudioSource::mixWith( struct timespec ticks, uint8_t* outSamples, int outByt
 
     debuglogstdio(LCF_SOUND, "Start mixing source %d", id);
 
-    bool skipMixing = (!audioConverter->isAvailable()) || 
-                        (!Global::shared_config.av_dumping && 
-                            (Global::shared_config.audio_mute ||
-                                (Global::shared_config.fastforward && 
-                                    (Global::shared_config.fastforward_mode & SharedConfig::FF_MIXING))));
+    bool skipMixing = (!audioConverter->isAvailable()) || AudioContext::isMixingSkipped();
+
+    /* When mixing resumes, the resampler may still hold samples from before
+     * it was skipped, so we start from a fresh context */
+    if (skippedMixing && !skipMixing)
+        dirty();
+    skippedMixing = skipMixing;
 
     std::shared_ptr<AudioBuffer> curBuf = buffer_queue[queue_index];
 
     if (!skipMixing) {
+        /* Get the sample format */
+        AudioBuffer::SampleFormat outFormat = AudioBuffer::SAMPLE_FMT_U8;
+        switch (outBitDepth) {
+            case 8:
+                outFormat = AudioBuffer::SAMPLE_FMT_U8;
+                break;
+            case 16:
+                outFormat = AudioBuffer::SAMPLE_FMT_S16;
+                break;
+            default:
+                debuglogstdio(LCF_SOUND | LCF_ERROR, "Unknown audio format");
+                break;
+        }
+
+        /* Check if we can bypass the resampler, when the buffer has already
+         * the output format. MS-ADPCM buffers are decoded into S16 samples. */
+        if (mixPath == MIX_UNDETERMINED) {
+            AudioBuffer::SampleFormat inFormat = curBuf->format;
+            if (inFormat == AudioBuffer::SAMPLE_FMT_MSADPCM)
+                inFormat = AudioBuffer::SAMPLE_FMT_S16;
+
+            if ((inFormat == outFormat) &&
+                (curBuf->nbChannels == outNbChannels) &&
+                (static_cast<int>(curBuf->frequency*pitch) == outFrequency))
+                mixPath = MIX_DIRECT;
+            else
+                mixPath = MIX_CONVERTER;
+        }
+
         /* Check if audio converter is initialized.
          * If not, set parameters and init it */
-        if (! audioConverter->isInited()) {
-            /* Get the sample format */
-            AudioBuffer::SampleFormat outFormat = AudioBuffer::SAMPLE_FMT_U8;
-            switch (outBitDepth) {
-                case 8:
-                    outFormat = AudioBuffer::SAMPLE_FMT_U8;
-                    break;
-                case 16:
-                    outFormat = AudioBuffer::SAMPLE_FMT_S16;
-                    break;
-                default:
-                    debuglogstdio(LCF_SOUND | LCF_ERROR, "Unknown audio format");
-                    break;
-            }
-
+        if ((mixPath == MIX_CONVERTER) && (! audioConverter->isInited())) {
             audioConverter->init(curBuf->format, curBuf->nbChannels, static_cast<int>(curBuf->frequency*pitch), outFormat, outNbChannels, outFrequency);
         }
+
+        /* Prepare the array of samples to mix */
+        mixAlignSize = outNbChannels * outBitDepth / 8;
+        mixedSamples.resize(outBytes);
+        mixedBytes = 0;
     }
 
     /* Mixing source volume and master volume.
@@ -226,8 +284,6 @@ int AudioSource::mixWith( struct timespec ticks, uint8_t* outSamples, int outByt
      * TODO: This is where we can support panning.
      */
     float resultVolume = (volume * outVolume) > 1.0?1.0:(volume*outVolume);
-    int lvas = (int)(resultVolume * 65536.0f);
-    int rvas = (int)(resultVolume * 65536.0f);
 
     /* Number of samples to advance in the buffer. */
     int inNbSamples = ticksToSamples(ticks, static_cast<int>(curBuf->frequency*pitch));
@@ -235,25 +291,17 @@ int AudioSource::mixWith( struct timespec ticks, uint8_t* outSamples, int outByt
     int oldPosition = position;
     int newPosition = position + inNbSamples;
 
-    uint8_t* begSamples;
-    int availableSamples = curBuf->getSamples(begSamples, inNbSamples, oldPosition, (source == SOURCE_STATIC) && looping);
+    int availableSamples = readSamples(*curBuf, inNbSamples, oldPosition, (source == SOURCE_STATIC) && looping, skipMixing);
 
     if (availableSamples == inNbSamples) {
         /* We did not reach the end of the buffer, easy case */
 
         position = newPosition;
         debuglogstdio(LCF_SOUND, "  Buffer %d in read in range %d - %d", curBuf->id, oldPosition, position);
-        if (!skipMixing) {
-            audioConverter->queueSamples(begSamples, inNbSamples);
-        }
     }
     else {
         /* We reached the end of the buffer */
         debuglogstdio(LCF_SOUND, "  Buffer %d is read from %d to its end %d", curBuf->id, oldPosition, curBuf->sampleSize);
-        if (!skipMixing) {
-            if (availableSamples > 0)
-                audioConverter->queueSamples(begSamples, availableSamples);
-        }
 
         int remainingSamples = inNbSamples - availableSamples;
         if (source == SOURCE_CALLBACK) {
@@ -270,10 +318,7 @@ int AudioSource::mixWith( struct timespec ticks, uint8_t* outSamples, int outByt
                 detTimer.fakeAdvanceTimer({static_cast<time_t>(extraTicks / 1000000000), static_cast<long>(extraTicks % 1000000000)});
                 callback(*curBuf);
                 detTimer.fakeAdvanceTimer({0, 0});
-                availableSamples = curBuf->getSamples(begSamples, remainingSamples, 0, false);
-                if (!skipMixing) {
-                    audioConverter->queueSamples(begSamples, availableSamples);
-                }
+                availableSamples = readSamples(*curBuf, remainingSamples, 0, false, skipMixing);
 
                 debuglogstdio(LCF_SOUND, "  Buffer %d is read again from 0 to %d", curBuf->id, availableSamples);
                 if (remainingSamples == availableSamples)
@@ -290,13 +335,9 @@ int AudioSource::mixWith( struct timespec ticks, uint8_t* outSamples, int outByt
             if (looping) {
                 for (int i=(queue_index+1)%queue_size; remainingSamples>0; i=(i+1)%queue_size) {
                     std::shared_ptr<AudioBuffer> loopbuf = buffer_queue[i];
-                    availableSamples = loopbuf->getSamples(begSamples, remainingSamples, loopbuf->loop_point_beg, (source == SOURCE_STATIC) && looping);
+                    availableSamples = readSamples(*loopbuf, remainingSamples, loopbuf->loop_point_beg, (source == SOURCE_STATIC) && looping, skipMixing);
                     debuglogstdio(LCF_SOUND, "  Buffer %d in read in range %d - %d", loopbuf->id, loopbuf->loop_point_beg, availableSamples);
 
-                    if (!skipMixing) {
-                        audioConverter->queueSamples(begSamples, availableSamples);
-                    }
-
                     finalIndex = i;
                     finalPos = loopbuf->loop_point_beg + availableSamples;
                     remainingSamples -= availableSamples;
@@ -305,13 +346,9 @@ int AudioSource::mixWith( struct timespec ticks, uint8_t* outSamples, int outByt
             else {
                 for (int i=queue_index+1; (remainingSamples>0) && (i<queue_size); i++) {
                     std::shared_ptr<AudioBuffer> loopbuf = buffer_queue[i];
-                    availableSamples = loopbuf->getSamples(begSamples, remainingSamples, 0, false);
+                    availableSamples = readSamples(*loopbuf, remainingSamples, 0, false, skipMixing);
                     debuglogstdio(LCF_SOUND, "  Buffer %d in read in range 0 - %d", loopbuf->id, availableSamples);
 
-                    if (!skipMixing) {
-                        audioConverter->queueSamples(begSamples, availableSamples);
-                    }
-
                     finalIndex = i;
                     finalPos = availableSamples;
                     remainingSamples -= availableSamples;
@@ -334,13 +371,9 @@ int AudioSource::mixWith( struct timespec ticks, uint8_t* outSamples, int outByt
                         int queue_size = buffer_queue.size();
                         for (int i=queue_index+1; (remainingSamples>0) && (i<queue_size); i++) {
                             std::shared_ptr<AudioBuffer> loopbuf = buffer_queue[i];
-                            availableSamples = loopbuf->getSamples(begSamples, remainingSamples, 0, false);
+                            availableSamples = readSamples(*loopbuf, remainingSamples, 0, false, skipMixing);
                             debuglogstdio(LCF_SOUND, "  Buffer %d in read in range 0 - %d", loopbuf->id, availableSamples);
 
-                            if (!skipMixing) {
-                                audioConverter->queueSamples(begSamples, availableSamples);
-                            }
-
                             finalIndex = i;
                             finalPos = availableSamples;
                             remainingSamples -= availableSamples;
@@ -372,58 +405,21 @@ int AudioSource::mixWith( struct timespec ticks, uint8_t* outSamples, int outByt
     int convOutSamples = 0;
 
     if (!skipMixing) {
-        /* Allocate the mixed audio array */
-        int outNbSamples = outBytes / (outNbChannels * outBitDepth / 8);
-        mixedSamples.resize(outBytes);
+        int outNbSamples = outBytes / mixAlignSize;
 
         /* Get the converter samples */
-        convOutSamples = audioConverter->getSamples(mixedSamples.data(), outNbSamples);
-
-        #define clamptofullsignedrange(x,lo,hi) ((static_cast<unsigned int>((x)-(lo))<=static_cast<unsigned int>((hi)-(lo)))?(x):(((x)<0)?(lo):(hi)))
-
-        int nbSaturate = 0;
-
-        /* Add mixed source to the output buffer */
-        if (outBitDepth == 8) {
-            for (int s=0; s<convOutSamples*outNbChannels; s+=outNbChannels) {
-                int myL = mixedSamples[s];
-                int otherL = outSamples[s];
-                int sumL = otherL + ((myL * lvas) >> 16) - 256;
-                outSamples[s] = clamptofullsignedrange(sumL, 0, UINT8_MAX);
-                nbSaturate += (sumL < 0) || (sumL > UINT8_MAX);
-
-                if (outNbChannels == 2) {
-                    int myR = mixedSamples[s+1];
-                    int otherR = outSamples[s+1];
-                    int sumR = otherR + ((myR * rvas) >> 16) - 256;
-                    outSamples[s+1] = clamptofullsignedrange(sumR, 0, UINT8_MAX);
-                    nbSaturate += (sumR < 0) || (sumR > UINT8_MAX);
-                }
-            }
-        }
+        if (mixPath == MIX_CONVERTER)
+            convOutSamples = audioConverter->getSamples(mixedSamples.data(), outNbSamples);
+        else
+            convOutSamples = mixedBytes / mixAlignSize;
 
-        if (outBitDepth == 16) {
-            int16_t* mixedSamples16 = reinterpret_cast<int16_t*>(mixedSamples.data());
-            int16_t* outSamples16 = reinterpret_cast<int16_t*>(outSamples);
-            for (int s=0; s<convOutSamples*outNbChannels; s+=outNbChannels) {
-                int myL = mixedSamples16[s];
-                int otherL = outSamples16[s];
-                int sumL = otherL + ((myL * lvas) >> 16);
-                outSamples16[s] = clamptofullsignedrange(sumL, INT16_MIN, INT16_MAX);
-                nbSaturate += (sumL < INT16_MIN) || (sumL > INT16_MAX);
-
-                if (outNbChannels == 2) {
-                    int myR = mixedSamples16[s+1];
-                    int otherR = outSamples16[s+1];
-                    int sumR = otherR + ((myR * rvas) >> 16);
-                    outSamples16[s+1] = clamptofullsignedrange(sumR, INT16_MIN, INT16_MAX);
-                    nbSaturate += (sumR < INT16_MIN) || (sumR > INT16_MAX);
-                }
-            }
-        }
-        
-        if (nbSaturate > 0)
-            debuglogstdio(LCF_SOUND | LCF_WARNING, "Saturation during mixing for %d samples", nbSaturate);        
+        /* Add mixed source to the accumulation bus. Clamping is done once
+         * all sources are mixed. */
+        if (outBitDepth == 8)
+            AudioMixer::accumulateU8(mixBus, mixedSamples.data(), convOutSamples*outNbChannels, resultVolume);
+
+        if (outBitDepth == 16)
+            AudioMixer::accumulateS16(mixBus, reinterpret_cast<int16_t*>(mixedSamples.data()), convOutSamples*outNbChannels, resultVolume);
     }
 
     /* Reset the audio converter if the source has stopped */
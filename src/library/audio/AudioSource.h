@@ -111,9 +111,26 @@ class AudioSource
         /* Object for resampling audio */
         std::unique_ptr<AudioConverter> audioConverter;
 
+        /* How samples are brought to the output format */
+        enum MixPath {
+            MIX_UNDETERMINED,
+            MIX_CONVERTER, /* Samples are resampled by the audio converter */
+            MIX_DIRECT, /* Samples already have the output format */
+        };
+        MixPath mixPath;
+
         /* Temporary array of mixed samples */
         std::vector<uint8_t> mixedSamples;
 
+        /* Number of bytes written in mixedSamples when bypassing the converter */
+        int mixedBytes;
+
+        /* Size of an output sample (chan * bitdepth / 8) */
+        int mixAlignSize;
+
+        /* Was mixing skipped during the last call to mixWith() */
+        bool skippedMixing = false;
+
         /* In case of callback type, callback function.
          * We send as an argument a pointer to the buffer to refill.
          */
@@ -165,11 +182,22 @@ class AudioSource
         /* Check if reading a number of ticks will reach the end of the source */
         bool willEnd(struct timespec ticks);
 
-        /* Mix the buffer with an external buffer of the given format.
-         * The number of samples to mix correspond to the number of ticks given.
-         * The function returns the number of samples written in the output buffer.
+        /* Mix the buffer into an accumulation bus of samples of the given
+         * format, stored as floats. The number of samples to mix correspond to
+         * the number of ticks given.
+         * The function returns the number of samples added to the bus.
          */
-        int mixWith( struct timespec ticks, uint8_t* outSamples, int outBytes, int outBitDepth, int outNbChannels, int outFrequency, float outVolume);
+        int mixWith( struct timespec ticks, float* mixBus, int outBytes, int outBitDepth, int outNbChannels, int outFrequency, float outVolume);
+
+    private:
+        /* Send samples to the audio converter, or copy them directly if they
+         * already have the output format */
+        void queueSamples(const uint8_t* samples, int nbSamples);
+
+        /* Advance inside a buffer by at most `nbSamples` from `position`,
+         * and send the samples to be mixed unless mixing is skipped.
+         * Returns the number of samples advanced */
+        int readSamples(AudioBuffer& buffer, int nbSamples, int position, bool loopstatic, bool skipMixing);
 };
 }
 
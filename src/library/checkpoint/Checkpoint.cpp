@@ -54,6 +54,9 @@
 #include <csignal>
 #include <stdint.h>
 #include <sys/statvfs.h>
+#ifdef __linux__
+#include <sys/sysmacros.h> // major, minor
+#endif
 #include <cerrno>
 #ifdef __unix__
 #include <X11/Xlibint.h>
@@ -89,9 +92,15 @@ static int base_ss_index = -1;
 /* Savestate ucontext (must be stored outside the alt stack) */
 static ucontext_t ss_ucontext;
 
+/* Whether the last checkpoint wrote the savestate */
+static bool checkpoint_succeeded = false;
+
 static void readAllAreas();
 static int reallocateArea(Area *saved_area, Area *current_area);
 static void readAnArea(SaveStateLoading &saved_area, int spmfd, SaveStateLoading &parent_state, SaveStateLoading &base_state);
+static bool isSameMappedFile(const Area &area);
+static bool openMappedFile(const Area &saved_area, int spmfd, int *filefd);
+static void restoreFilePage(const Area &saved_area, char* addr, uint64_t page, bool same_mapping, int filefd);
 
 static void writeAllAreas(bool base);
 static size_t writeAnArea(SaveStateSaving state, int spmfd, SaveStateLoading &parent_state, bool base);
@@ -168,11 +177,11 @@ static void setPagesFd(int index, int fd)
 int Checkpoint::checkCheckpoint()
 {
     if (Global::shared_config.savestate_settings & SharedConfig::SS_RAM)
-        return SaveStateManager::ESTATE_OK;
+        return SaveStateStatus::ESTATE_OK;
 
     /* TODO: Find another way to check for space, because mapped memory is
      * way bigger than final savestate size. */
-    return SaveStateManager::ESTATE_OK;
+    return SaveStateStatus::ESTATE_OK;
 
     /* Get an estimation of the savestate space */
     uint64_t savestate_size = 0;
@@ -205,11 +214,11 @@ int Checkpoint::checkCheckpoint()
     if ((ret = statvfs(savestate_str.c_str(), &devData)) >= 0) {
         uint64_t available_size = static_cast<uint64_t>(devData.f_bavail) * devData.f_bsize;
         if (savestate_size > available_size) {
-            return SaveStateManager::ESTATE_NOMEM;
+            return SaveStateStatus::ESTATE_NOMEM;
         }
     }
 
-    return SaveStateManager::ESTATE_OK;
+    return SaveStateStatus::ESTATE_OK;
 }
 
 int Checkpoint::checkRestore()
@@ -217,20 +226,20 @@ int Checkpoint::checkRestore()
     /* Check that the savestate files exist */
     if (Global::shared_config.savestate_settings & SharedConfig::SS_RAM) {
         if (!getPagemapFd(ss_index)) {
-            return SaveStateManager::ESTATE_NOSTATE;
+            return SaveStateStatus::ESTATE_NOSTATE;
         }
 
         if (!getPagesFd(ss_index)) {
-            return SaveStateManager::ESTATE_NOSTATE;
+            return SaveStateStatus::ESTATE_NOSTATE;
         }
     }
     else {
         struct stat sb;
         if (stat(pagemappath, &sb) == -1) {
-            return SaveStateManager::ESTATE_NOSTATE;
+            return SaveStateStatus::ESTATE_NOSTATE;
         }
         if (stat(pagespath, &sb) == -1) {
-            return SaveStateManager::ESTATE_NOSTATE;
+            return SaveStateStatus::ESTATE_NOSTATE;
         }
     }
 
@@ -242,7 +251,7 @@ int Checkpoint::checkRestore()
     else {
         NATIVECALL(pmfd = open(pagemappath, O_RDONLY));
         if (pmfd == -1)
-            return SaveStateManager::ESTATE_NOSTATE;
+            return SaveStateStatus::ESTATE_NOSTATE;
     }
 
     /* Read the savestate header */
@@ -272,19 +281,36 @@ int Checkpoint::checkRestore()
 
         if (t == sh.thread_count) {
             /* We didn't find a match */
-            return SaveStateManager::ESTATE_NOTSAMETHREADS;
+            return SaveStateStatus::ESTATE_NOTSAMETHREADS;
         }
     }
 
     if (n != sh.thread_count) {
-        return SaveStateManager::ESTATE_NOTSAMETHREADS;
+        return SaveStateStatus::ESTATE_NOTSAMETHREADS;
+    }
+
+    /* Check that the files of areas with file pages were not removed or
+     * replaced, because their pages could not be restored */
+    SaveStateLoading saved_state(pagemappath, pagespath, getPagemapFd(ss_index), getPagesFd(ss_index));
+    for (Area area = saved_state.getArea(); area; area = saved_state.nextArea()) {
+        if (area.filepages && !area.skip && !area.uncommitted && !isSameMappedFile(area)) {
+            debuglogstdio(LCF_CHECKPOINT | LCF_ERROR, "Mapped file %s was removed or replaced", area.name);
+            return SaveStateStatus::ESTATE_NOFILE;
+        }
     }
 
-    return SaveStateManager::ESTATE_OK;
+    return SaveStateStatus::ESTATE_OK;
+}
+
+bool Checkpoint::lastCheckpointSucceeded()
+{
+    return checkpoint_succeeded;
 }
 
 void Checkpoint::handler(int signum, siginfo_t *info, void *ucontext)
 {
+    checkpoint_succeeded = false;
+
 #ifdef __unix__
     /* Check that we are using our alternate stack by looking at the address
      * of this local variable.
@@ -378,6 +404,7 @@ void Checkpoint::handler(int signum, siginfo_t *info, void *ucontext)
         memcpy(&ss_ucontext, ucontext, sizeof(ucontext_t));
 
         writeAllAreas(false);
+        checkpoint_succeeded = true;
     }
 }
 
@@ -386,8 +413,8 @@ static void readAllAreas()
     SaveStateLoading saved_state(pagemappath, pagespath, getPagemapFd(ss_index), getPagesFd(ss_index));
 
     int spmfd = -1;
+    NATIVECALL(spmfd = open("/proc/self/pagemap", O_RDONLY));
     if (Global::shared_config.savestate_settings & (SharedConfig::SS_INCREMENTAL | SharedConfig::SS_PRESENT)) {
-        NATIVECALL(spmfd = open("/proc/self/pagemap", O_RDONLY));
         MYASSERT(spmfd != -1);
     }
 
@@ -666,10 +693,18 @@ static void readAnArea(SaveStateLoading &saved_state, int spmfd, SaveStateLoadin
     /* Current index in the pagemaps array */
     int pagemap_i = 512;
 
+    /* Mapped file to restore file pages, opened on the first file page.
+     * -2 if not opened yet. */
+    int filefd = -2;
+
+    /* If the current mapping is the same as the saved mapping, so that the file
+     * pages can be restored by discarding the modified pages */
+    bool same_mapping = false;
+
     char* endAddr = static_cast<char*>(saved_area.endAddr);
     for (char* curAddr = static_cast<char*>(saved_area.addr);
     curAddr < endAddr;
-    curAddr += 4096, page_i++, pagemap_i++) {
+    curAddr += 4096, page_i++) {
 
         /* We read pagemap flags in chunks to avoid too many read syscalls. */
         if ((spmfd != -1) && (pagemap_i >= 512)) {
@@ -685,6 +720,13 @@ static void readAnArea(SaveStateLoading &saved_state, int spmfd, SaveStateLoadin
         bool soft_dirty = page & (0x1ull << 55);
         bool page_present = page & (0x1ull << 63);
 
+        if (flag == Area::FILE_PAGE) {
+            if (filefd == -2)
+                same_mapping = openMappedFile(saved_area, spmfd, &filefd);
+            restoreFilePage(saved_area, curAddr, page, same_mapping, filefd);
+            continue;
+        }
+
         /* It seems that static memory is both zero and unmapped, so we still
          * need to memset the region if it was mapped.
          *
@@ -760,12 +802,119 @@ static void readAnArea(SaveStateLoading &saved_state, int spmfd, SaveStateLoadin
     base_state.finishLoad();
     saved_state.finishLoad();
 
+    if (filefd >= 0) {
+        NATIVECALL(close(filefd));
+    }
+
     /* Recover permission to the area */
     if (!(saved_area.prot & PROT_WRITE) || !(saved_area.prot & PROT_READ)) {
         MYASSERT(mprotect(saved_area.addr, saved_area.size, saved_area.prot) == 0)
     }
 }
 
+/* Check that the file of a mapped area is still the file at its path. Deleted
+ * files, memfds and files replaced on disk cannot be reopened to read back
+ * their pages. */
+static bool isSameMappedFile(const Area &area)
+{
+    if (area.name[0] != '/')
+        return false;
+
+    if (strncmp(area.name, "/memfd:", 7) == 0)
+        return false;
+
+    static const char deleted[] = " (deleted)";
+    size_t len = strlen(area.name);
+    if ((len >= sizeof(deleted) - 1) && (strcmp(area.name + len - (sizeof(deleted) - 1), deleted) == 0))
+        return false;
+
+    struct stat sb;
+    int ret;
+    NATIVECALL(ret = stat(area.name, &sb));
+    if (ret == -1)
+        return false;
+
+    return S_ISREG(sb.st_mode) && (sb.st_ino == area.inodenum)
+#ifdef __linux__
+        && (major(sb.st_dev) == area.devmajor) && (minor(sb.st_dev) == area.devminor)
+#endif
+        ;
+}
+
+/* Open the file of a saved area to restore its file pages, and check that it
+ * was not replaced. Returns if the current mapping at the area address is the
+ * same as the saved one. */
+static bool openMappedFile(const Area &saved_area, int spmfd, int *filefd)
+{
+    NATIVECALL(*filefd = open(saved_area.name, O_RDONLY));
+
+    struct stat sb;
+    if ((*filefd != -1) && ((fstat(*filefd, &sb) == -1) || (sb.st_ino != saved_area.inodenum))) {
+        NATIVECALL(close(*filefd));
+        *filefd = -1;
+    }
+
+    if (*filefd == -1) {
+        debuglogstdio(LCF_CHECKPOINT | LCF_ERROR, "Could not open the original file %s to restore its pages", saved_area.name);
+        return false;
+    }
+
+    /* We need the pagemap to know which pages were modified */
+    if (spmfd == -1)
+        return false;
+
+#ifdef __unix__
+    Area current_area;
+    if (!ProcSelfMaps::getAreaAt(reinterpret_cast<uintptr_t>(saved_area.addr), &current_area))
+        return false;
+
+    /* Check that the same file offset is mapped at the same address */
+    return (current_area.inodenum == saved_area.inodenum) &&
+        (current_area.devmajor == saved_area.devmajor) &&
+        (current_area.devminor == saved_area.devminor) &&
+        (current_area.flags & Area::AREA_FILE) && (current_area.flags & Area::AREA_PRIV) &&
+        ((reinterpret_cast<char*>(saved_area.addr) - reinterpret_cast<char*>(current_area.addr)) ==
+            (saved_area.offset - current_area.offset));
+#else
+    return false;
+#endif
+}
+
+/* Restore a page of a private file mapping that was not modified when saving */
+static void restoreFilePage(const Area &saved_area, char* addr, uint64_t page, bool same_mapping, int filefd)
+{
+    if (same_mapping) {
+        bool page_present = page & (0x1ull << 63);
+        bool page_swapped = page & (0x1ull << 62);
+        bool file_page = page & (0x1ull << 61);
+
+        /* Page still has the file content */
+        if (file_page || (!page_present && !page_swapped))
+            return;
+
+        /* Discarding the private copy of the page makes the mapping fall back
+         * to the file content */
+        if (madvise(addr, 4096, MADV_DONTNEED) == 0)
+            return;
+    }
+
+    if (filefd < 0)
+        return;
+
+    if (!(saved_area.prot & PROT_WRITE)) {
+        MYASSERT(mprotect(addr, 4096, saved_area.prot | PROT_WRITE | PROT_READ) == 0)
+    }
+
+    off_t offset = saved_area.offset + (addr - static_cast<char*>(saved_area.addr));
+    ssize_t size;
+    NATIVECALL(size = pread(filefd, addr, 4096, offset));
+    if (size < 0)
+        size = 0;
+
+    /* Part of the page after the end of the file is zero */
+    if (size < 4096)
+        memset(addr + size, 0, 4096 - size);
+}
 
 static void writeAllAreas(bool base)
 {
@@ -924,6 +1073,11 @@ static void writeAllAreas(bool base)
     bool not_eof = memMapLayout.getNextArea(&area);
     
     while (not_eof) {
+        /* Unmodified pages of private file mappings can be read back from the
+         * file, if it can be reopened when loading */
+        area.filepages = (Global::shared_config.savestate_settings & SharedConfig::SS_FILEPAGES) &&
+            (spmfd != -1) && (area.flags & Area::AREA_FILE) && (area.flags & Area::AREA_PRIV) &&
+            !area.isSkipped() && isSameMappedFile(area);
         state.processArea(area);
         savestate_size += writeAnArea(state, spmfd, parent_state, base);
         not_eof = memMapLayout.getNextArea(&area);
@@ -1015,6 +1169,8 @@ static size_t writeAnArea(SaveStateSaving state, int spmfd, SaveStateLoading &pa
     /* Current index in the pagemaps array */
     int pagemap_i = 512;
 
+    bool file_pages = area.filepages;
+
     char* endAddr = static_cast<char*>(area.endAddr);
     for (char* curAddr = static_cast<char*>(area.addr); curAddr < endAddr; curAddr += 4096, page_i++) {
 
@@ -1028,10 +1184,18 @@ static size_t writeAnArea(SaveStateSaving state, int spmfd, SaveStateLoading &pa
         /* Gather the flag for the current pagemap. */
         uint64_t page = (spmfd != -1)?pagemaps[pagemap_i++]:-1;
         bool page_present = page & (0x1ull << 63);
+        bool page_swapped = page & (0x1ull << 62);
+        bool file_page = page & (0x1ull << 61);
         bool soft_dirty = page & (0x1ull << 55);
 
+        /* Check if page is still the page of the mapped file. A page that was
+         * neither accessed nor swapped out also has the content of the file. */
+        if (file_pages && (file_page || (!page_present && !page_swapped))) {
+            state.savePageFlag(Area::FILE_PAGE);
+        }
+
         /* Check if page is present */
-        if ((Global::shared_config.savestate_settings & SharedConfig::SS_PRESENT) && (!page_present)) {
+        else if ((Global::shared_config.savestate_settings & SharedConfig::SS_PRESENT) && (!page_present)) {
             state.savePageFlag(Area::NO_PAGE);
         }
 
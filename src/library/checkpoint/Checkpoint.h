@@ -38,6 +38,10 @@ namespace Checkpoint
 
     int checkCheckpoint();
     int checkRestore();
+
+    /* Returns if the last checkpoint wrote the savestate */
+    bool lastCheckpointSucceeded();
+
     void handler(int signum, siginfo_t *info, void *ucontext);
 }
 }
@@ -23,6 +23,7 @@
 #include "ReservedMemory.h"
 
 #include "logging.h"
+#include "AsyncLog.h"
 #include "Utils.h"
 
 #include <unistd.h>
@@ -97,6 +98,11 @@ bool Area::isSkipped() const
         return true;
     }
 
+    /* Don't save our asynchronous log rings */
+    if ((addr == AsyncLog::getAddr()) && (size == AsyncLog::getSize())) {
+        return true;
+    }
+
     /* Don't save area that cannot be promoted to read/write */
     if ((max_prot & (PROT_WRITE|PROT_READ)) != (PROT_WRITE|PROT_READ)) {
         return false;
@@ -51,6 +51,7 @@ struct Area {
         FULL_PAGE, /* Area contains a copy of the page */
         BASE_PAGE, /* Page was not modified from base savestate */
         COMPRESSED_PAGE, /* Full page but compressed */
+        FILE_PAGE, /* Page is identical to the page of the mapped file */
     };
 
     void* addr;
@@ -74,6 +75,7 @@ struct Area {
     ino_t inodenum;
     bool skip;
     bool uncommitted;
+    bool filepages; // unmodified pages are stored as FILE_PAGE
     off_t page_offset; // position of the first area page in the pages file (in bytes)
     
     enum {
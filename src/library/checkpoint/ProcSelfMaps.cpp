@@ -28,28 +28,81 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <errno.h>
 #include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+/* Query of a single memory section, available since Linux 6.11 */
+#ifndef PROCMAP_QUERY
+struct procmap_query {
+    uint64_t size;
+    uint64_t query_flags;
+    uint64_t query_addr;
+    uint64_t vma_start;
+    uint64_t vma_end;
+    uint64_t vma_flags;
+    uint64_t vma_page_size;
+    uint64_t vma_offset;
+    uint64_t inode;
+    uint32_t dev_major;
+    uint32_t dev_minor;
+    uint32_t vma_name_size;
+    uint32_t build_id_size;
+    uint64_t vma_name_addr;
+    uint64_t build_id_addr;
+};
+
+#define PROCMAP_QUERY _IOWR('f', 17, struct procmap_query)
+#define PROCMAP_QUERY_VMA_READABLE 0x01
+#define PROCMAP_QUERY_VMA_WRITABLE 0x02
+#define PROCMAP_QUERY_VMA_EXECUTABLE 0x04
+#define PROCMAP_QUERY_VMA_SHARED 0x08
+#endif
 
 namespace libtas {
 
-ProcSelfMaps::ProcSelfMaps() : off(0)
+ProcSelfMaps::ProcSelfMaps() : off(0), buffer_off(0), buffer_len(0), buffer_eof(false)
 {
     /* We need to copy /proc/self/maps, because it can be modified while parsing it */
     int fd;
     NATIVECALL(fd = open("/proc/self/maps", O_RDONLY));
     MYASSERT(fd != -1);
-    NATIVECALL(tmp_fd = open("/tmp/libtas-maps", O_RDWR | O_CREAT | O_TRUNC, 0666));
-    MYASSERT(tmp_fd != -1);
-    
+
+    /* Store the copy in an anonymous file, so that it never touches the disk */
+    NATIVECALL(tmp_fd = syscall(SYS_memfd_create, "libtas-maps", MFD_CLOEXEC));
+
+    if (tmp_fd == -1) {
+        /* Use the temporary directory of this game instance if set */
+        const char* tmpdir;
+        NATIVECALL(tmpdir = getenv("LIBTAS_TMPDIR"));
+        if (!tmpdir || !tmpdir[0])
+            tmpdir = "/tmp";
+        char mapsfile[1024];
+        snprintf(mapsfile, 1024, "%s/libtas-maps", tmpdir);
+
+        NATIVECALL(tmp_fd = open(mapsfile, O_RDWR | O_CREAT | O_TRUNC, 0666));
+        MYASSERT(tmp_fd != -1);
+    }
+
+    /* Copy by large chunks, the first chunk being kept for parsing */
     ssize_t sz = 1;
-    
     while (sz > 0) {
-        char buf[4096];
-        sz = Utils::readAll(fd, buf, 4096);
-        Utils::writeAll(tmp_fd, buf, sz);
+        sz = Utils::readAll(fd, buffer, BUFFER_SIZE);
+        Utils::writeAll(tmp_fd, buffer, sz);
+        if (buffer_len == 0) {
+            buffer_len = sz;
+            buffer_eof = (sz < BUFFER_SIZE);
+        }
     }
     NATIVECALL(close(fd));
+
+    /* The buffer only holds the first chunk if there were many */
+    if (!buffer_eof)
+        buffer_len = 0;
 }
 
 ProcSelfMaps::~ProcSelfMaps()
@@ -62,6 +115,27 @@ void ProcSelfMaps::reset()
     off = 0;
 }
 
+bool ProcSelfMaps::fillLine(off_t offset)
+{
+    /* Refill the buffer if it does not contain an entire line starting at
+     * the offset, which is at most FILENAMESIZE bytes long */
+    if ((offset < buffer_off) ||
+        ((offset + Area::FILENAMESIZE > buffer_off + buffer_len) && !buffer_eof) ||
+        (offset >= buffer_off + buffer_len)) {
+
+        ssize_t ret = pread(tmp_fd, buffer, BUFFER_SIZE, offset);
+        buffer_off = offset;
+        buffer_len = (ret < 0) ? 0 : ret;
+        buffer_eof = (buffer_len < BUFFER_SIZE);
+    }
+
+    if (offset >= buffer_off + buffer_len)
+        return false;
+
+    line = buffer + (offset - buffer_off);
+    return true;
+}
+
 uintptr_t ProcSelfMaps::readDec()
 {
     uintptr_t v = 0;
@@ -102,8 +176,7 @@ uintptr_t ProcSelfMaps::readHex()
 
 bool ProcSelfMaps::getNextArea(Area *area)
 {
-    ssize_t ret = pread(tmp_fd, line, Area::FILENAMESIZE, off);
-    if (ret < 1) {
+    if (!fillLine(off)) {
         area->addr = nullptr;
         area->size = 0;
         return false;        
@@ -164,8 +237,7 @@ bool ProcSelfMaps::getNextArea(Area *area)
     while (line_idx == Area::FILENAMESIZE) {
         debuglogstdio(LCF_CHECKPOINT | LCF_WARNING, "File path of memory section is too long");
         off += Area::FILENAMESIZE;
-        ssize_t ret = pread(tmp_fd, line, Area::FILENAMESIZE, off);
-        if (ret < 1) {
+        if (!fillLine(off)) {
             area->addr = nullptr;
             area->size = 0;
             return false;        
@@ -192,13 +264,41 @@ bool ProcSelfMaps::getNextArea(Area *area)
         area->prot |= PROT_EXEC;
     }
 
+    setFlags(area, sflag == 's');
+
+    /* Sometimes the [heap] is split into several contiguous segments, such as
+     * after a dumping was made (but why...?). This can screw up our code for
+     * loading and remapping the [heap] using brk, so we always read the [heap]
+     * as one single segment.
+     */
+    if (area->flags & Area::AREA_HEAP) {
+        Area next_area;
+        off_t cur_off = off;
+        bool valid = getNextArea(&next_area); // recursive call
+        if (valid && (next_area.flags & Area::AREA_HEAP)) {
+            MYASSERT(area->endAddr == next_area.addr)
+            MYASSERT(area->flags == next_area.flags)
+            area->prot |= next_area.prot;
+            area->endAddr = next_area.endAddr;
+            area->size += next_area.size;
+        }
+        else {
+            off = cur_off;
+        }
+    }
+
+    return true;
+}
+
+void ProcSelfMaps::setFlags(Area *area, bool shared)
+{
     /* Max protection does not exist on Linux, so setting all flags */
     area->max_prot = PROT_READ | PROT_WRITE | PROT_EXEC;
 
-    if (sflag == 's') {
+    if (shared) {
         area->flags = Area::AREA_SHARED;
     }
-    if (sflag == 'p') {
+    else {
         area->flags = Area::AREA_PRIV;
     }
     if (area->name[0] == '\0') {
@@ -216,29 +316,76 @@ bool ProcSelfMaps::getNextArea(Area *area)
 
     if (strcmp(area->name, "[heap]") == 0)
         area->flags |= Area::AREA_HEAP;
+}
 
-    /* Sometimes the [heap] is split into several contiguous segments, such as
-     * after a dumping was made (but why...?). This can screw up our code for
-     * loading and remapping the [heap] using brk, so we always read the [heap]
-     * as one single segment.
-     */
-    if (area->flags & Area::AREA_HEAP) {
-        Area next_area;
-        off_t cur_off = off;
-        bool valid = getNextArea(&next_area); // recursive call
-        if (valid && (next_area.flags & Area::AREA_HEAP)) {
-            MYASSERT(area->endAddr == next_area.addr)
-            MYASSERT(area->flags == next_area.flags)
-            area->prot |= next_area.prot;
-            area->endAddr = next_area.endAddr;
-            area->size += next_area.size;
+bool ProcSelfMaps::getAreaAt(uintptr_t addr, Area *area)
+{
+    /* -1 if unknown, 0 if not supported, 1 if supported */
+    static int query_supported = -1;
+
+    if (query_supported != 0) {
+        int fd;
+        NATIVECALL(fd = open("/proc/self/maps", O_RDONLY));
+        MYASSERT(fd != -1);
+
+        struct procmap_query query;
+        memset(&query, 0, sizeof(query));
+        query.size = sizeof(query);
+        query.query_addr = addr;
+        query.vma_name_addr = reinterpret_cast<uintptr_t>(area->name);
+        query.vma_name_size = Area::FILENAMESIZE;
+
+        int ret;
+        NATIVECALL(ret = ioctl(fd, PROCMAP_QUERY, &query));
+        int err = errno;
+        NATIVECALL(close(fd));
+
+        if (ret == 0) {
+            query_supported = 1;
+
+            area->addr = reinterpret_cast<void*>(query.vma_start);
+            area->endAddr = reinterpret_cast<void*>(query.vma_end);
+            area->size = static_cast<size_t>(query.vma_end - query.vma_start);
+            area->offset = query.vma_offset;
+            area->devmajor = query.dev_major;
+            area->devminor = query.dev_minor;
+            area->inodenum = query.inode;
+            if (query.vma_name_size == 0)
+                area->name[0] = '\0';
+
+            area->prot = 0;
+            if (query.vma_flags & PROCMAP_QUERY_VMA_READABLE)
+                area->prot |= PROT_READ;
+            if (query.vma_flags & PROCMAP_QUERY_VMA_WRITABLE)
+                area->prot |= PROT_WRITE;
+            if (query.vma_flags & PROCMAP_QUERY_VMA_EXECUTABLE)
+                area->prot |= PROT_EXEC;
+
+            setFlags(area, query.vma_flags & PROCMAP_QUERY_VMA_SHARED);
+            return true;
         }
-        else {
-            off = cur_off;
+
+        if (err == ENOENT) {
+            /* No section contains the address */
+            query_supported = 1;
+            area->addr = nullptr;
+            area->size = 0;
+            return false;
+        }
+
+        if ((err == ENOTTY) || (err == EINVAL)) {
+            debuglogstdio(LCF_CHECKPOINT, "PROCMAP_QUERY is not supported, parsing /proc/self/maps instead");
+            query_supported = 0;
         }
     }
 
-    return true;
+    /* Scan the whole snapshot */
+    ProcSelfMaps memMapLayout;
+    while (memMapLayout.getNextArea(area)) {
+        if ((addr >= reinterpret_cast<uintptr_t>(area->addr)) && (addr < reinterpret_cast<uintptr_t>(area->endAddr)))
+            return true;
+    }
+    return false;
 }
 
 }
@@ -32,7 +32,7 @@ struct Area;
 class ProcSelfMaps
 {
     public:
-        /* Read the /proc/self/maps file into reserved memory */
+        /* Take a snapshot of the /proc/self/maps file into an anonymous file */
         ProcSelfMaps();
         ~ProcSelfMaps();
 
@@ -42,14 +42,35 @@ class ProcSelfMaps
         /* Reset all internal variables */
         void reset();
 
+        /* Get the memory section containing `addr`, without reading the
+         * whole file when the kernel supports the PROCMAP_QUERY ioctl.
+         * Returns false if no section contains the address. */
+        static bool getAreaAt(uintptr_t addr, Area *area);
+
     private:
         uintptr_t readDec();
         uintptr_t readHex();
 
+        /* Make the snapshot content starting at `offset` available in `line`.
+         * Returns false at the end of the snapshot */
+        bool fillLine(off_t offset);
+
+        /* Set the area flags from its sharing mode and name */
+        static void setFlags(Area *area, bool shared);
+
         int tmp_fd;
         off_t off;
-        
-        char line[1024];
+
+        /* Buffer of the snapshot content, to read it by large chunks */
+        enum {
+            BUFFER_SIZE = 16384
+        };
+        char buffer[BUFFER_SIZE];
+        off_t buffer_off;
+        ssize_t buffer_len;
+        bool buffer_eof;
+
+        char* line;
         int line_idx;
 };
 }
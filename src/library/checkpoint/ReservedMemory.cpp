@@ -35,7 +35,8 @@ void ReservedMemory::init()
 {
     /* Create a special place to hold restore memory.
      * will be used for the second stack we will switch to, as well as
-     * the ProcSelfMaps object that need some space.
+     * the ProcSelfMaps object and the savefile snapshot table that need
+     * some space.
      */
     if (restoreAddr == 0) {
         restoreLength = RESTORE_TOTAL_SIZE;
@@ -22,6 +22,8 @@
 #ifndef LIBTAS_RESERVEDMEMORY_H
 #define LIBTAS_RESERVEDMEMORY_H
 
+#include "../shared/SharedConfig.h"
+
 #include <cstdint> // intptr_t
 #include <cstddef> // size_t
 
@@ -32,16 +34,18 @@ namespace libtas {
 namespace ReservedMemory {
     enum Addresses {
         PAGEMAPS_ADDR = 0,
-        PAGES_ADDR = 11*sizeof(int),
-        SS_SLOTS_ADDR = 22*sizeof(int),
-        PSM_ADDR = 22*sizeof(int)+11*sizeof(bool),
+        PAGES_ADDR = SharedConfig::SAVESTATE_SLOTS*sizeof(int),
+        SS_SLOTS_ADDR = 2*SharedConfig::SAVESTATE_SLOTS*sizeof(int),
+        SAVEFILES_ADDR = 2*SharedConfig::SAVESTATE_SLOTS*sizeof(int)+SharedConfig::SAVESTATE_SLOTS*sizeof(bool),
+        PSM_ADDR = SAVEFILES_ADDR + 128 * 1024,
         COMPRESSED_ADDR = ONE_MB,
         STACK_ADDR = 6 * ONE_MB,
     };
     enum Sizes {
         PAGEMAPS_SIZE = PAGES_ADDR - PAGEMAPS_ADDR,
         PAGES_SIZE = SS_SLOTS_ADDR - PAGES_ADDR,
-        SS_SLOTS_SIZE = PSM_ADDR - SS_SLOTS_ADDR,
+        SS_SLOTS_SIZE = SAVEFILES_ADDR - SS_SLOTS_ADDR,
+        SAVEFILES_SIZE = PSM_ADDR - SAVEFILES_ADDR,
         PSM_SIZE = COMPRESSED_ADDR - PSM_ADDR,
         COMPRESSED_SIZE = STACK_ADDR - COMPRESSED_ADDR,
         STACK_SIZE = RESTORE_TOTAL_SIZE - STACK_ADDR,
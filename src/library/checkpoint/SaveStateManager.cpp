@@ -38,6 +38,7 @@
 #include "audio/AudioPlayerCoreAudio.h"
 #endif
 #include "fileio/FileHandleList.h"
+#include "fileio/SaveFileList.h"
 #include "renderhud/MessageWindow.h"
 #ifdef __unix__
 #include "xlib/xdisplay.h" // x11::gameDisplays
@@ -47,6 +48,7 @@
 #include <utility>
 #include <csignal>
 #include <algorithm> // std::find
+#include <atomic>
 #include <sys/mman.h>
 #include <sys/syscall.h> // syscall, SYS_gettid
 #include <sys/wait.h> // waitpid
@@ -61,6 +63,10 @@ static sem_t semWaitForCkptThreadSignal;
 static pthread_mutex_t threadResumeLock = PTHREAD_MUTEX_INITIALIZER;
 static volatile bool restoreInProgress = false;
 static int numThreads;
+
+/* Number of signaled threads that are not suspended yet. Used as a futex word
+ * so that the checkpoint thread sleeps until all threads are suspended. */
+static std::atomic<uint32_t> suspendPending(0);
 static int sig_suspend_threads = SIGXFSZ;
 static int sig_checkpoint = SIGSYS;
 static bool* state_dirty;
@@ -83,7 +89,7 @@ void SaveStateManager::init()
     ReservedMemory::init();
 
     state_dirty = static_cast<bool*>(ReservedMemory::getAddr(ReservedMemory::SS_SLOTS_ADDR));
-    memset(state_dirty, 0, 11*sizeof(bool));
+    memset(state_dirty, 0, SharedConfig::SAVESTATE_SLOTS*sizeof(bool));
 }
 
 void SaveStateManager::initCheckpointThread()
@@ -147,7 +153,7 @@ int SaveStateManager::waitChild()
         return -1;
     }
     status = WEXITSTATUS(status);
-    if ((status < 0) && (status > 10)) {
+    if ((status < 0) || (status >= SharedConfig::SAVESTATE_SLOTS)) {
         debuglogstdio(LCF_THREAD | LCF_CHECKPOINT | LCF_ERROR, "Got unknown status code %d from pid %d", status, pid);
         return -1;
     }
@@ -165,7 +171,7 @@ bool SaveStateManager::stateReady(int slot)
     if (!(Global::shared_config.savestate_settings & SharedConfig::SS_FORK))
         return true;
 
-    if ((slot < 0) && (slot > 10)) {
+    if ((slot < 0) || (slot >= SharedConfig::SAVESTATE_SLOTS)) {
         debuglogstdio(LCF_THREAD | LCF_CHECKPOINT | LCF_ERROR, "Wrong slot number");
         return false;
     }
@@ -181,7 +187,7 @@ void SaveStateManager::stateStatus(int slot, bool dirty)
 int SaveStateManager::checkpoint(int slot)
 {
     if (!stateReady(slot))
-        return ESTATE_NOTCOMPLETE;
+        return SaveStateStatus::ESTATE_NOTCOMPLETE;
 
     ThreadInfo *current_thread = ThreadManager::getCurrentThread();
     MYASSERT(current_thread->state == ThreadInfo::ST_CKPNTHREAD)
@@ -256,6 +262,11 @@ int SaveStateManager::checkpoint(int slot)
     urandom_disable_handler();
 #endif
 
+    /* We snapshot the content of savefiles, so that the savestate only stores
+     * a reference to the snapshot. This must be done AFTER suspending threads.
+     */
+    SaveFileList::snapshotSaveFiles();
+
     /* We flag all opened files as tracked and store their offset. This must be
      * done AFTER suspending threads.
      */
@@ -278,6 +289,20 @@ int SaveStateManager::checkpoint(int slot)
     /* Restoring the game alternate stack (if any) */
     AltStack::restoreStack();
 
+    /* When loading, we restore the content of savefiles from the snapshot
+     * referenced by the loaded savestate, before recovering file offsets.
+     * When saving, the snapshots of the savestate previously in this slot are
+     * only released if the new savestate was written.
+     */
+    bool saved = false;
+    if (isLoading()) {
+        SaveFileList::restoreSaveFiles();
+    }
+    else {
+        saved = Checkpoint::lastCheckpointSucceeded();
+        SaveFileList::commitSaveFiles(slot, saved);
+    }
+
     /* We recover the offset of all opened files. This must also be done BEFORE
      * resuming threads.
      */
@@ -305,17 +330,21 @@ int SaveStateManager::checkpoint(int slot)
 
     ThreadSync::releaseLocks();
 
-    /* Mark the savestate as dirty in case of fork savestate */
-    if (!isLoading())
+    if (!isLoading()) {
+        if (!saved)
+            return SaveStateStatus::ESTATE_UNKNOWN;
+
+        /* Mark the savestate as dirty in case of fork savestate */
         stateStatus(slot, true);
+    }
 
-    return ESTATE_OK;
+    return SaveStateStatus::ESTATE_OK;
 }
 
 int SaveStateManager::restore(int slot)
 {
     if (!stateReady(slot))
-        return ESTATE_NOTCOMPLETE;
+        return SaveStateStatus::ESTATE_NOTCOMPLETE;
 
     ThreadInfo *current_thread = ThreadManager::getCurrentThread();
     MYASSERT(current_thread->state == ThreadInfo::ST_CKPNTHREAD)
@@ -337,6 +366,12 @@ int SaveStateManager::restore(int slot)
         return ret;
     }
 
+    /* The savefiles could not be restored without their snapshots */
+    if (!SaveFileList::hasAllSnapshots(slot)) {
+        ThreadSync::releaseLocks();
+        return SaveStateStatus::ESTATE_NOSAVEFILE;
+    }
+
     /* We save the alternate stack if the game did set one */
     AltStack::saveStack();
 
@@ -411,7 +446,7 @@ int SaveStateManager::restore(int slot)
 
      ThreadSync::releaseLocks();
 
-     return ESTATE_UNKNOWN;
+     return SaveStateStatus::ESTATE_UNKNOWN;
 }
 
 void SaveStateManager::suspendThreads()
@@ -426,10 +461,13 @@ void SaveStateManager::suspendThreads()
     */
     ThreadManager::lockList();
 
+    /* Signal every thread once. Only threads in the middle of being created
+     * or recycled make us scan the list again. */
+    numThreads = 0;
+    suspendPending = 0;
     bool needrescan = false;
     do {
         needrescan = false;
-        numThreads = 0;
         ThreadInfo *next;
         for (ThreadInfo *thread = ThreadManager::getThreadList(); thread != nullptr; thread = next) {
             next = thread->next;
@@ -447,7 +485,6 @@ void SaveStateManager::suspendThreads()
             case ThreadInfo::ST_ZOMBIE_RECYCLE:
             case ThreadInfo::ST_IDLE:
                 /* Thread is running. Send it a signal so it will call stopthisthread.
-                * We will need to rescan (hopefully it will be suspended by then)
                 */
                 thread->orig_state = thread->state;
                 if (ThreadManager::updateState(thread, ThreadInfo::ST_SIGNALED, thread->state)) {
@@ -484,15 +521,20 @@ void SaveStateManager::suspendThreads()
                     //     MYASSERT(sigaction(SIGUSR1, &sigusr1, nullptr) == 0)
                     // }
 
+                    /* Count the thread before signaling, because the signal
+                     * handler decrements the count */
+                    suspendPending++;
+
                     /* Send the suspend signal to the thread */
                     debuglogstdio(LCF_THREAD | LCF_CHECKPOINT, "Signaling thread %d", thread->tid);
                     NATIVECALL(ret = pthread_kill(thread->pthread_id, sig_suspend_threads));
 
                     if (ret == 0) {
-                        needrescan = true;
+                        numThreads++;
                     }
                     else {
                         MYASSERT(ret == ESRCH)
+                        suspendPending--;
                         debuglogstdio(LCF_THREAD | LCF_CHECKPOINT, "Thread %d has died since", thread->tid);
                         ThreadManager::threadIsDead(thread);
                     }
@@ -500,25 +542,9 @@ void SaveStateManager::suspendThreads()
                 break;
 
             case ThreadInfo::ST_SIGNALED:
-                NATIVECALL(ret = pthread_kill(thread->pthread_id, 0));
-
-                if (ret == 0) {
-                    debuglogstdio(LCF_THREAD | LCF_CHECKPOINT, "Waiting for thread %d to be suspended", thread->tid);
-                    needrescan = true;
-                }
-                else {
-                    MYASSERT(ret == ESRCH)
-                    debuglogstdio(LCF_ERROR | LCF_THREAD | LCF_CHECKPOINT, "Signalled thread %d died", thread->tid);
-                    ThreadManager::threadIsDead(thread);
-                }
-                break;
-
             case ThreadInfo::ST_SUSPINPROG:
-                numThreads++;
-                break;
-
             case ThreadInfo::ST_SUSPENDED:
-                numThreads++;
+                /* Thread was signaled during a previous scan */
                 break;
 
             case ThreadInfo::ST_CKPNTHREAD:
@@ -546,12 +572,45 @@ void SaveStateManager::suspendThreads()
         }
     } while (needrescan);
 
-    ThreadManager::unlockList();
+    /* Wait for all signaled threads to be suspended. The futex is woken by the
+     * last thread entering the suspended state. If this takes long, check
+     * that no signaled thread has died in the meantime. */
+    while (uint32_t pending = suspendPending.load()) {
+        struct timespec deadline;
+        NATIVECALL(clock_gettime(CLOCK_MONOTONIC, &deadline));
+        deadline.tv_nsec += 100 * 1000 * 1000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        if (ThreadSync::futexWait(&suspendPending, pending, &deadline))
+            continue;
 
-    for (int i = 0; i < numThreads; i++) {
-        NATIVECALL(sem_wait(&semNotifyCkptThread));
+        ThreadInfo *next;
+        for (ThreadInfo *thread = ThreadManager::getThreadList(); thread != nullptr; thread = next) {
+            /* threadIsDead() may free the thread */
+            next = thread->next;
+            if (thread->state != ThreadInfo::ST_SIGNALED)
+                continue;
+
+            int ret;
+            NATIVECALL(ret = pthread_kill(thread->pthread_id, 0));
+            if (ret == 0) {
+                debuglogstdio(LCF_THREAD | LCF_CHECKPOINT, "Waiting for thread %d to be suspended", thread->tid);
+            }
+            else {
+                MYASSERT(ret == ESRCH)
+                debuglogstdio(LCF_ERROR | LCF_THREAD | LCF_CHECKPOINT, "Signalled thread %d died", thread->tid);
+                ThreadManager::threadIsDead(thread);
+                numThreads--;
+                suspendPending--;
+            }
+        }
     }
 
+    ThreadManager::unlockList();
+
     debuglogstdio(LCF_THREAD | LCF_CHECKPOINT, "%d threads were suspended", numThreads);
 }
 
@@ -599,7 +658,8 @@ void SaveStateManager::stopThisThread(int signum)
 
             /* Tell the checkpoint thread that we're all saved away */
             MYASSERT(ThreadManager::updateState(current_thread, ThreadInfo::ST_SUSPENDED, ThreadInfo::ST_SUSPINPROG))
-            NATIVECALL(sem_post(&semNotifyCkptThread));
+            if (suspendPending.fetch_sub(1) == 1)
+                ThreadSync::futexWake(&suspendPending);
 
             /* Then wait for the ckpt thread to write the ckpt file then wake us up */
             debuglogstdio(LCF_THREAD | LCF_CHECKPOINT, "Thread suspended");
@@ -665,6 +725,8 @@ void SaveStateManager::printError(int err)
         "Savestate does not exist",
         "Loading not allowed because new threads were created",
         "State still saving",
+        "Loading not allowed because a mapped file was removed or replaced",
+        "Loading not allowed because the state is missing savefile content",
         0 };
 
     if (err < 0) {
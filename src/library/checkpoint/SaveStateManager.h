@@ -20,6 +20,8 @@
 #ifndef LIBTAS_SAVESTATE_MANAGER_H
 #define LIBTAS_SAVESTATE_MANAGER_H
 
+#include "../shared/SaveStateStatus.h"
+
 #include <set>
 #include <map>
 #include <vector>
@@ -35,16 +37,6 @@ struct ThreadInfo;
 
 namespace SaveStateManager {
 
-/* List of error codes */
-enum Error {
-    ESTATE_OK = 0,
-    ESTATE_UNKNOWN = -1, // Unknown error
-    ESTATE_NOMEM = -2, // Not enough memory to perform savestate
-    ESTATE_NOSTATE = -3, // No state in slot
-    ESTATE_NOTSAMETHREADS = -4, // Thread list has changed
-    ESTATE_NOTCOMPLETE = -5, // State still being saved
-};
-
 
 void init();
 
@@ -78,15 +78,17 @@ struct ThreadInfo {
 
     bool quit = false; // is game quitting
 
-    bool syncEnabled = false; // main thread needs to wait for this thread
-    bool syncGo = false; // main thread can advance for now
-    std::atomic<int> syncCount;
-    int syncOldCount = 0;
+    std::atomic<bool> syncEnabled{false}; // main thread needs to wait for this thread
+    std::atomic<bool> syncGo{false}; // thread is waiting, so main thread can advance
+    std::atomic<uint32_t> syncCount{0}; // number of times the thread started waiting
+    uint32_t syncOldCount = 0; // value of syncCount at the last frame boundary
+    uint32_t syncPassCount = 0; // value of syncCount seen by the last detWait pass
 
     bool unityThread = false; // is unity wait thread
 
     ThreadInfo *next = nullptr; // next thread info in the linked list
     ThreadInfo *prev = nullptr; // previous thread info in the linked list
+    ThreadInfo *idle_next = nullptr; // next thread in the pool of idle threads
 };
 }
 
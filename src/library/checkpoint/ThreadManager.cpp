@@ -47,6 +47,35 @@ static bool is_child_fork = false;
 /* Past savestates are invalid when thread list has changed */
 static bool threadListChanged = false;
 
+/* Stack of idle threads, ready to be recycled */
+static ThreadInfo* idle_list = nullptr;
+static int idle_count = 0;
+
+/* Number of thread creations that recycled an idle thread or not */
+static int pool_hits = 0;
+static int pool_misses = 0;
+
+/* Push an idle thread in the pool. Must be called with the list locked */
+static void pushIdleThread(ThreadInfo* thread)
+{
+    thread->idle_next = idle_list;
+    idle_list = thread;
+    idle_count++;
+}
+
+/* Remove an idle thread from the pool. Must be called with the list locked */
+static void removeIdleThread(ThreadInfo* thread)
+{
+    for (ThreadInfo** th = &idle_list; *th != nullptr; th = &(*th)->idle_next) {
+        if (*th == thread) {
+            *th = thread->idle_next;
+            thread->idle_next = nullptr;
+            idle_count--;
+            return;
+        }
+    }
+}
+
 /* Offset of `tid` member in the hidden `pthread` structure */
 #ifdef __i386__
 static int offset_tid = 26;
@@ -163,26 +192,30 @@ bool ThreadManager::isMainThread()
 
 ThreadInfo* ThreadManager::getNewThread()
 {
-    ThreadInfo* thread = nullptr;
-
     lockList();
+
     /* Try to recycle a free thread */
-    for (ThreadInfo* th = thread_list; th != nullptr; th = th->next) {
-        if (th->state == ThreadInfo::ST_IDLE) {
-            thread = th;
-            /* We must change the state here so that this thread is not chosen
-             * twice by two different threads.
-             */
-            thread->state = ThreadInfo::ST_RECYCLED;
-            break;
-        }
+    ThreadInfo* thread = idle_list;
+    if (thread) {
+        idle_list = thread->idle_next;
+        thread->idle_next = nullptr;
+        idle_count--;
+        pool_hits++;
+
+        /* We must change the state here so that this thread is not chosen
+         * twice by two different threads.
+         */
+        MYASSERT(thread->state == ThreadInfo::ST_IDLE)
+        thread->state = ThreadInfo::ST_RECYCLED;
     }
 
     /* No free thread, create a new one */
-    if (!thread) {
+    else {
         thread = new ThreadInfo();
         debuglogstdio(LCF_THREAD, "Allocate a new ThreadInfo struct");
         threadListChanged = true;
+        if (Global::shared_config.recycle_threads)
+            pool_misses++;
     }
 
     unlockList();
@@ -228,9 +261,6 @@ bool ThreadManager::initThreadFromParent(ThreadInfo* thread, void * (* start_rou
     thread->initial_owncode = GlobalState::isOwnCode();
     thread->initial_nolog = GlobalState::isNoLog();
 
-    thread->syncCount = 0;
-    thread->syncOldCount = 0;
-    
     if (!isRecycled) {
         thread->pthread_id = 0;
         thread->tid = 0;
@@ -258,6 +288,13 @@ void ThreadManager::initThreadFromChild(ThreadInfo* thread)
     current_thread = thread;
     addToList(thread);
 
+    /* Threads created in advance are directly put in the pool */
+    if (thread->state == ThreadInfo::ST_IDLE) {
+        lockList();
+        pushIdleThread(thread);
+        unlockList();
+    }
+
     SaveStateManager::initThreadFromChild(thread);
 }
 
@@ -327,6 +364,9 @@ void ThreadManager::threadIsDead(ThreadInfo *thread)
         thread_list = thread_list->next;
     }
 
+    /* The thread may be idle, or idle but signaled for a savestate */
+    removeIdleThread(thread);
+
     if (thread->altstack.ss_sp) {
         free(thread->altstack.ss_sp);
     }
@@ -349,6 +389,7 @@ void ThreadManager::threadDetach(pthread_t pthread_id)
         if (thread->state == ThreadInfo::ST_ZOMBIE_RECYCLE) {
             debuglogstdio(LCF_THREAD, "Zombie thread %d is detached", thread->tid);
             MYASSERT(updateState(thread, ThreadInfo::ST_IDLE, ThreadInfo::ST_ZOMBIE_RECYCLE))            
+            pushIdleThread(thread);
         }
         unlockList();
     }
@@ -367,6 +408,7 @@ void ThreadManager::threadExit(void* retval)
         if (current_thread->detached) {
             debuglogstdio(LCF_THREAD, "Detached thread %d exited", current_thread->tid);
             MYASSERT(updateState(current_thread, ThreadInfo::ST_IDLE, ThreadInfo::ST_ZOMBIE_RECYCLE))
+            pushIdleThread(current_thread);
         }
     }
     else {
@@ -436,6 +478,13 @@ void ThreadManager::unlockList()
     MYASSERT(pthread_mutex_unlock(&threadListLock) == 0)
 }
 
+void ThreadManager::getPoolStats(int* idle, int* hits, int* misses)
+{
+    *idle = idle_count;
+    *hits = pool_hits;
+    *misses = pool_misses;
+}
+
 bool ThreadManager::hasThreadListChanged()
 {
     return threadListChanged;
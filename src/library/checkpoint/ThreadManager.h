@@ -122,6 +122,10 @@ void setCurrentThread(ThreadInfo *thread);
 void lockList();
 void unlockList();
 
+/* Get the number of idle threads waiting to be recycled, and the number of
+ * thread creations that recycled an idle thread or had to create one */
+void getPoolStats(int* idle, int* hits, int* misses);
+
 /* Has the thread list changed during the current frame? */
 bool hasThreadListChanged();
 
@@ -30,16 +30,37 @@
 #include <time.h> // nanosleep
 #include <atomic>
 #include <pthread.h> // pthread_rwlock_t
-#include <mutex>
-#include <condition_variable>
+#include <climits>
+#include <cerrno>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace libtas {
 
 static std::atomic<int> uninitializedThreadCount(0);
 static pthread_mutex_t wrapperExecutionLock = PTHREAD_MUTEX_INITIALIZER;
-static std::mutex detMutex;
-static std::condition_variable detCond;
-static bool syncGo[10];
+
+/* Counter incremented each time a synchronized thread starts or stops waiting,
+ * used as a futex word so that the main thread sleeps until it changes */
+static std::atomic<uint32_t> detSeq(0);
+
+/* Is the main thread sleeping on detSeq, so that threads only issue a wake
+ * syscall when needed */
+static std::atomic<bool> detSleeping(false);
+
+/* Words of the global locks, set to 1 when signaled */
+static std::atomic<uint32_t> syncGo[10];
+
+/* Notify the main thread that a synchronized thread changed state */
+static void detNotify()
+{
+    detSeq.fetch_add(1);
+    if (detSleeping.load())
+        ThreadSync::futexWake(&detSeq);
+}
 
 
 void ThreadSync::acquireLocks()
@@ -105,63 +126,105 @@ void ThreadSync::wrapperExecutionLockUnlock()
     }
 }
 
+bool ThreadSync::futexWait(std::atomic<uint32_t>* word, uint32_t val, const struct timespec* deadline)
+{
+#ifdef __linux__
+    long ret;
+    NATIVECALL(ret = syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_BITSET_PRIVATE,
+        val, deadline, nullptr, FUTEX_BITSET_MATCH_ANY));
+    return !((ret == -1) && (errno == ETIMEDOUT));
+#else
+    /* No futex available, poll the value instead */
+    while (word->load() == val) {
+        if (deadline) {
+            struct timespec now;
+            NATIVECALL(clock_gettime(CLOCK_MONOTONIC, &now));
+            if ((now.tv_sec > deadline->tv_sec) ||
+                ((now.tv_sec == deadline->tv_sec) && (now.tv_nsec >= deadline->tv_nsec)))
+                return false;
+        }
+        struct timespec sleepTime = { 0, 10 * 1000 };
+        NATIVECALL(nanosleep(&sleepTime, NULL));
+    }
+    return true;
+#endif
+}
+
+void ThreadSync::futexWake(std::atomic<uint32_t>* word)
+{
+#ifdef __linux__
+    NATIVECALL(syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0));
+#endif
+}
+
 void ThreadSync::detInit()
 {
     ThreadInfo *current_thread = ThreadManager::getCurrentThread();
-    current_thread->syncEnabled = true;
     current_thread->syncGo = false;
+    current_thread->syncEnabled = true;
 }
 
 void ThreadSync::detWait()
 {
-    bool shouldWait = true;
-
-    while (shouldWait) {
-        shouldWait = false;
+    /* Thread that we are currently waiting for, and until when */
+    ThreadInfo *waited_thread = nullptr;
+    struct timespec deadline;
+
+    while (true) {
+        uint32_t seq = detSeq.load();
+
+        /* Look for a thread that is not stopped, and that either is running
+         * or has not started a new wait since the last frame boundary. This
+         * ensures that a thread that was woken up but did not return
+         * from its wait yet is not considered done for this frame. */
+        ThreadInfo *pending = nullptr;
         /* lock thread list here */
         for (ThreadInfo *thread = ThreadManager::getThreadList(); thread != nullptr; thread = thread->next) {
-            /* Should wait if sync count has increased since last time */
-            if (thread->syncCount > thread->syncOldCount) {
-                // debuglogstdio(LCF_ERROR, "Thread %d has increased sync count %d -> %d", thread->tid, thread->syncOldCount, thread->syncCount.load());
-                thread->syncOldCount = thread->syncCount;
-                shouldWait = true;
+            thread->syncPassCount = thread->syncCount;
+            if (thread->syncEnabled &&
+                (!thread->syncGo || (thread->syncPassCount == thread->syncOldCount))) {
+                pending = thread;
+                break;
             }
+        }
 
-            if (!thread->syncEnabled) continue;
-            if (!thread->syncGo) {
-                shouldWait = true;
-                std::unique_lock<std::mutex> lock(detMutex);
-                bool ret;
-                /* Declare the following NATIVE, because std::condition_variable.wait_for()
-                 * eventually calls clock_gettime() to check for timeout, so it
-                 * must access the real clock time. */
-                NATIVECALL(ret = detCond.wait_for(lock, std::chrono::milliseconds(1000), [thread]{ return (thread->syncGo); }));
-                if (!ret) {
-                    debuglogstdio(LCF_WARNING, "Timeout waiting for loading thread %d", thread->tid);
-                    thread->syncEnabled = false;
-                }
-                thread->syncGo = false;
-            }
+        if (!pending) {
+            /* All threads are waiting. If one of them resumed during our
+             * pass, it may have woken another one, so we check again. */
+            if (detSeq.load() == seq)
+                break;
+            continue;
         }
 
-        if (shouldWait)
-        /* unlock and lock thread list here */
-            NATIVECALL(usleep(100));
-    }
+        if (pending != waited_thread) {
+            waited_thread = pending;
+            NATIVECALL(clock_gettime(CLOCK_MONOTONIC, &deadline));
+            deadline.tv_sec += 1;
+        }
+
+        /* Sleep until a thread changes state */
+        detSleeping.store(true);
+        bool ret = true;
+        if (detSeq.load() == seq)
+            ret = ThreadSync::futexWait(&detSeq, seq, &deadline);
+        detSleeping.store(false);
 
-    /* Reset sync count */
-    for (ThreadInfo *thread = ThreadManager::getThreadList(); thread != nullptr; thread = thread->next) {
-        thread->syncCount = 0;
-        thread->syncOldCount = 0;
+        if (!ret) {
+            debuglogstdio(LCF_WARNING, "Timeout waiting for loading thread %d", pending->tid);
+            pending->syncEnabled = false;
+        }
     }
+
+    /* Each thread must start a new wait before the next frame boundary */
+    for (ThreadInfo *thread = ThreadManager::getThreadList(); thread != nullptr; thread = thread->next)
+        thread->syncOldCount = thread->syncPassCount;
 }
 
 void ThreadSync::detWaitGlobal(int i)
 {
     debuglogstdio(LCF_THREAD, "Wait on global lock %d", i);
-    std::unique_lock<std::mutex> lock(detMutex);
-    NATIVECALL(detCond.wait(lock, [i]{ return (syncGo[i]); }));
-    syncGo[i] = false;
+    while (syncGo[i].exchange(0) == 0)
+        ThreadSync::futexWait(&syncGo[i], 0, nullptr);
     debuglogstdio(LCF_THREAD, "End Wait on global lock %d", i);
 }
 
@@ -171,25 +234,31 @@ void ThreadSync::detSignal(bool stop)
 
     if (!current_thread->syncEnabled)
         return;
-    {
-        std::lock_guard<std::mutex> lock(detMutex);
-        current_thread->syncGo = true;
-        current_thread->syncCount++;
-    }
-    NATIVECALL(detCond.notify_all());
 
+    current_thread->syncGo = true;
+    current_thread->syncCount++;
     if (stop)
         current_thread->syncEnabled = false;
+
+    detNotify();
+}
+
+void ThreadSync::detResume()
+{
+    ThreadInfo *current_thread = ThreadManager::getCurrentThread();
+
+    if (!current_thread->syncEnabled)
+        return;
+
+    current_thread->syncGo = false;
+    detNotify();
 }
 
 void ThreadSync::detSignalGlobal(int i)
 {
     debuglogstdio(LCF_THREAD, "Signal global lock %d", i);
-    {
-        std::lock_guard<std::mutex> lock(detMutex);
-        syncGo[i] = true;
-    }
-    NATIVECALL(detCond.notify_all());
+    syncGo[i].store(1);
+    ThreadSync::futexWake(&syncGo[i]);
 }
 
 }
@@ -22,6 +22,10 @@
 #ifndef LIBTAS_THREAD_SYNC_H
 #define LIBTAS_THREAD_SYNC_H
 
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+
 namespace libtas {
 namespace ThreadSync {
     void acquireLocks();
@@ -31,10 +35,34 @@ namespace ThreadSync {
     void decrementUninitializedThreadCount();
     void wrapperExecutionLockLock();
     void wrapperExecutionLockUnlock();
+
+    /* Wait until the value of `word` is different from `val`, or until the
+     * CLOCK_MONOTONIC time `deadline` if not null. Returns false if the
+     * deadline was reached. */
+    bool futexWait(std::atomic<uint32_t>* word, uint32_t val, const struct timespec* deadline);
+
+    /* Wake the threads waiting on `word`. Can be called from signal handlers. */
+    void futexWake(std::atomic<uint32_t>* word);
+
+    /* Deterministic synchronization: the main thread waits at the frame
+     * boundary until each synchronized thread is waiting or stopped */
+
+    /* Make the main thread wait for the current thread */
     void detInit();
+
+    /* Wait until all synchronized threads are waiting or stopped, and each
+     * waiting thread started a new wait since the previous call */
     void detWait();
+
     void detWaitGlobal(int i);
+
+    /* Indicate that the current thread starts waiting, or stops being
+     * synchronized if `stop` is set */
     void detSignal(bool stop);
+
+    /* Indicate that the current thread is running again after a wait */
+    void detResume();
+
     void detSignalGlobal(int i);
 
 }
@@ -30,7 +30,8 @@
 #endif
 
 #include <cstdlib>
-#include <forward_list>
+#include <unordered_map>
+#include <tuple>
 #include <mutex>
 #include <unistd.h> // lseek
 #include <sys/ioctl.h>
@@ -47,9 +48,10 @@ namespace FileHandleList {
  * constructed (because some other libraries will initialize and open some files),
  * resulting in a crash. Also, we allocate it dynamically and never free it, so
  * that it has a chance to survive every other game code that may use it.
+ * File handles are indexed by their (first) file descriptor.
  */
-static std::forward_list<FileHandle>& getFileList() {
-    static std::forward_list<FileHandle>* filehandles = new std::forward_list<FileHandle>;
+static std::unordered_map<int, FileHandle>& getFileList() {
+    static std::unordered_map<int, FileHandle>* filehandles = new std::unordered_map<int, FileHandle>;
     return *filehandles;
 }
 
@@ -68,14 +70,12 @@ void openFile(const char* file, int fd)
     auto& filehandles = getFileList();
 
     /* Check if we already registered the file */
-    for (const FileHandle &fh : filehandles) {
-        if (fh.fds[0] == fd) {
-            debuglogstdio(LCF_FILEIO | LCF_ERROR, "Opened file descriptor %d was already registered!", fd);
-            return;
-        }
+    if (filehandles.count(fd)) {
+        debuglogstdio(LCF_FILEIO | LCF_ERROR, "Opened file descriptor %d was already registered!", fd);
+        return;
     }
 
-    filehandles.emplace_front(file, fd);
+    filehandles.emplace(std::piecewise_construct, std::forward_as_tuple(fd), std::forward_as_tuple(file, fd));
 }
 
 void openFile(const char* file, FILE* f)
@@ -87,14 +87,13 @@ void openFile(const char* file, FILE* f)
     auto& filehandles = getFileList();
 
     /* Check if we already registered the file */
-    for (const FileHandle &fh : filehandles) {
-        if (fh.stream == f) {
-            debuglogstdio(LCF_FILEIO | LCF_ERROR, "Opened file %p was already registered!", f);
-            return;
-        }
+    int fd = fileno(f);
+    if (filehandles.count(fd)) {
+        debuglogstdio(LCF_FILEIO | LCF_ERROR, "Opened file %p was already registered!", f);
+        return;
     }
 
-    filehandles.emplace_front(file, f);
+    filehandles.emplace(std::piecewise_construct, std::forward_as_tuple(fd), std::forward_as_tuple(file, f));
 }
 
 std::pair<int, int> createPipe(int flags) {
@@ -108,7 +107,7 @@ std::pair<int, int> createPipe(int flags) {
 
     fcntl(fds[1], F_SETFL, O_NONBLOCK);
     std::lock_guard<std::mutex> lock(getFileListMutex());
-    getFileList().emplace_front(fds);
+    getFileList().emplace(std::piecewise_construct, std::forward_as_tuple(fds[0]), std::forward_as_tuple(fds));
     return std::make_pair(fds[0], fds[1]);
 }
 
@@ -121,25 +120,25 @@ bool closeFile(int fd)
     auto& filehandles = getFileList();
 
     /* Check if we track the file */
-    for (auto prev = filehandles.before_begin(), iter = filehandles.begin(); iter != filehandles.end(); prev = iter++) {
-        if (iter->fds[0] == fd) {
-            if (iter->tracked) {
-                /* Just mark the file as closed, and tells to not close the file */
-                iter->closed = true;
+    auto iter = filehandles.find(fd);
+    if (iter != filehandles.end()) {
+        FileHandle &fh = iter->second;
+        if (fh.tracked) {
+            /* Just mark the file as closed, and tells to not close the file */
+            fh.closed = true;
+            return false;
+        }
+        else {
+#ifdef __unix__
+            if (!unref_evdev(fh.fds[0]) || !unref_jsdev(fh.fds[0])) {
                 return false;
             }
-            else {
-#ifdef __unix__
-                if (!unref_evdev(iter->fds[0]) || !unref_jsdev(iter->fds[0])) {
-                    return false;
-                }
 #endif
-                if (iter->isPipe()) {
-                    NATIVECALL(close(iter->fds[1]));
-                }
-                filehandles.erase_after(prev);
-                return true;
+            if (fh.isPipe()) {
+                NATIVECALL(close(fh.fds[1]));
             }
+            filehandles.erase(iter);
+            return true;
         }
     }
 
@@ -152,7 +151,8 @@ void trackAllFiles()
 {
     std::lock_guard<std::mutex> lock(getFileListMutex());
 
-    for (FileHandle &fh : getFileList()) {
+    for (auto &iter : getFileList()) {
+        FileHandle &fh = iter.second;
         debuglogstdio(LCF_FILEIO, "Track file %s (fd=%d,%d)", fh.fileName(), fh.fds[0], fh.fds[1]);
         fh.tracked = true;
         /* Save the file offset */
@@ -187,8 +187,8 @@ void recoverAllFiles()
 {
     std::lock_guard<std::mutex> lock(getFileListMutex());
 
-    for (FileHandle &fh : getFileList()) {
-
+    for (auto &iter : getFileList()) {
+        FileHandle &fh = iter.second;
         if (! fh.tracked) {
             debuglogstdio(LCF_FILEIO | LCF_ERROR, "File %s (fd=%d,%d) not tracked when recovering", fh.fileName(), fh.fds[0], fh.fds[1]);
             continue;
@@ -249,7 +249,8 @@ void closeUntrackedFiles()
 {
     std::lock_guard<std::mutex> lock(getFileListMutex());
 
-    for (FileHandle &fh : getFileList()) {
+    for (auto &iter : getFileList()) {
+        FileHandle &fh = iter.second;
         if (! fh.tracked) {
             if (fh.isPipe()) {
                 NATIVECALL(close(fh.fds[0]));
@@ -57,15 +57,11 @@ SaveFile::~SaveFile() {
     if (Global::shared_config.write_savefiles_on_exit && (fd != 0)) {
         debuglogstdio(LCF_FILEIO, "Save back into file %s", filename.c_str());
         GlobalNative gn;
-        lseek(fd, 0, SEEK_SET);
+        struct stat filestat;
         int file_fd = creat(filename.c_str(), 00777);
         if (file_fd >= 0) {
-            char tmp_buf[4096];
-            ssize_t s;
-            do {
-                s = Utils::readAll(fd, tmp_buf, 4096);
-                Utils::writeAll(file_fd, tmp_buf, s);
-            } while(s > 0);
+            if (fstat(fd, &filestat) == 0)
+                Utils::copyAll(file_fd, fd, filestat.st_size);
             close(file_fd);
         }
     }
@@ -316,18 +312,12 @@ int SaveFile::open(int flags)
             int rv = stat(filename.c_str(), &filestat);
 
             if (rv == 0) {
-                /* The file exists, copying the content to the stream */
-                FILE* f = fopen(filename.c_str(), "rb");
-
-                if (f != nullptr) {
-                    char tmp_buf[4096];
-                    size_t s;
-                    do {
-                        s = fread(tmp_buf, 1, 4096, f);
-                        write(fd, tmp_buf, s);
-                    } while(s != 0);
-
-                    fclose(f);
+                /* The file exists, copying the content to the memfile */
+                int file_fd = ::open(filename.c_str(), O_RDONLY);
+
+                if (file_fd >= 0) {
+                    Utils::copyAll(fd, file_fd, filestat.st_size);
+                    close(file_fd);
                 }
             }
         }
@@ -40,6 +40,12 @@ public:
     bool removed = false;
     bool closed = true;
 
+    /* Reference to the snapshot of the file content taken by the last
+     * savestate. It lives in savestate memory, so loading a state brings back
+     * the reference to the file content at the time of that state. */
+    int snapshot_index = -1;
+    unsigned int snapshot_gen = 0;
+
 
     /* Remove duplicate /, /./ and /../ from a path */
     static char* canonicalizeFile(const char *file);
@@ -23,16 +23,27 @@
 #include "global.h" // Global::shared_config
 #include "GlobalState.h"
 #include "logging.h"
+#include "Utils.h"
+#include "checkpoint/ReservedMemory.h"
+#include "../shared/SharedConfig.h"
 
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <errno.h>
 #include <forward_list>
+#include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <mutex>
 #include <cstring>
 #include <unistd.h>
 #include <algorithm> // remove_if
+#include <cstdint>
+#include <climits> // PATH_MAX
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <sys/mman.h> // MFD_CLOEXEC
+#endif
 
 namespace libtas {
 
@@ -43,23 +54,76 @@ static std::forward_list<std::unique_ptr<SaveFile>>& getSaveFileList() {
     return *savefiles;
 }
 
+/* Index of the savefile list by canonicalized path */
+static std::unordered_map<std::string, SaveFile*>& getSaveFileIndex() {
+    static std::unordered_map<std::string, SaveFile*>* index = new std::unordered_map<std::string, SaveFile*>;
+    return *index;
+}
+
+/* Canonicalized paths that were found by stat() not to be regular files, so
+ * that we don't check them again each time the game opens them. Protected by
+ * the savefile list mutex. */
+static std::unordered_set<std::string>& getNotSaveFileCache() {
+    static std::unordered_set<std::string>* cache = new std::unordered_set<std::string>;
+    return *cache;
+}
+
+/* Key of a path in the cache above, so that all paths of the same file share
+ * the same entry, even if the working directory changes */
+static std::string getNotSaveFileKey(const char *file)
+{
+    char* canonfile = SaveFile::canonicalizeFile(file);
+    if (!canonfile)
+        return std::string(file);
+
+    std::string key(canonfile);
+    free(canonfile);
+    return key;
+}
+
+static const size_t NOT_SAVEFILE_CACHE_SIZE = 256;
+
 /* Mutex to protect the savefile list */
 static std::mutex& getSaveFileListMutex() {
     static std::mutex* mutex = new std::mutex;
     return *mutex;
 }
 
+/* Return the registered savefile corresponding to the file, or nullptr */
+static SaveFile* findSaveFile(const char *file)
+{
+    char* canonfile = SaveFile::canonicalizeFile(file);
+    if (!canonfile)
+        return nullptr;
+
+    auto& index = getSaveFileIndex();
+    auto it = index.find(std::string(canonfile));
+    free(canonfile);
+
+    if (it == index.end())
+        return nullptr;
+    return it->second;
+}
+
+/* Create and register a new savefile */
+static SaveFile* addSaveFile(const char *file)
+{
+    auto& savefiles = getSaveFileList();
+    savefiles.emplace_front(new SaveFile(file));
+
+    SaveFile* savefile = savefiles.front().get();
+    if (!savefile->filename.empty())
+        getSaveFileIndex()[savefile->filename] = savefile;
+    return savefile;
+}
+
 /* Check if the file open permission allows for write operation */
 bool isSaveFile(const char *file, const char *modes)
 {
     std::lock_guard<std::mutex> lock(getSaveFileListMutex());
 
-    const auto& savefiles = getSaveFileList();
-    for (const auto& savefile : savefiles) {
-        if (savefile->isSameFile(file)) {
-            return true;
-        }
-    }
+    if (findSaveFile(file))
+        return true;
 
     if (!(strstr(modes, "w") || strstr(modes, "a") || strstr(modes, "+")))
         return false;
@@ -71,12 +135,8 @@ bool isSaveFile(const char *file, int oflag)
 {
     std::lock_guard<std::mutex> lock(getSaveFileListMutex());
 
-    const auto& savefiles = getSaveFileList();
-    for (const auto& savefile : savefiles) {
-        if (savefile->isSameFile(file)) {
-            return true;
-        }
-    }
+    if (findSaveFile(file))
+        return true;
 
     if ((oflag & 0x3) == O_RDONLY)
         return false;
@@ -102,6 +162,22 @@ bool isSaveFile(const char *file)
     if (!file)
         return false;
 
+    /* Check if the file lies in shared memory */
+    if (strstr(file, "/dev/shm"))
+        return false;
+
+    /* We don't need to keep mesa shader cache files */
+    if (strstr(file, "/.cache/mesa_shader_cache/"))
+        return false;
+
+    auto& notSaveFiles = getNotSaveFileCache();
+    std::string filekey = getNotSaveFileKey(file);
+    {
+        std::lock_guard<std::mutex> lock(getSaveFileListMutex());
+        if (notSaveFiles.count(filekey))
+            return false;
+    }
+
     /* Check if file is a dev file */
     GlobalNative gn;
     struct stat filestat;
@@ -120,21 +196,16 @@ bool isSaveFile(const char *file)
         return false;
     }
 
-    /* Check if the file is a regular file */
-    if (! S_ISREG(filestat.st_mode))
-        return false;
-
-    /* Check if the file is a message queue, semaphore or shared memory object */
-    if (S_TYPEISMQ(&filestat) || S_TYPEISSEM(&filestat) || S_TYPEISSHM(&filestat))
-        return false;
-
-    /* Check if the file lies in shared memory */
-    if (strstr(file, "/dev/shm"))
-        return false;
-
-    /* We don't need to keep mesa shader cache files */
-    if (strstr(file, "/.cache/mesa_shader_cache/"))
+    /* Check if the file is a regular file, and if the file is a message queue,
+     * semaphore or shared memory object */
+    if ((! S_ISREG(filestat.st_mode)) ||
+        S_TYPEISMQ(&filestat) || S_TYPEISSEM(&filestat) || S_TYPEISSHM(&filestat)) {
+        std::lock_guard<std::mutex> lock(getSaveFileListMutex());
+        if (notSaveFiles.size() >= NOT_SAVEFILE_CACHE_SIZE)
+            notSaveFiles.clear();
+        notSaveFiles.insert(filekey);
         return false;
+    }
 
     return true;
 }
@@ -143,30 +214,22 @@ FILE *openSaveFile(const char *file, const char *modes)
 {
     std::lock_guard<std::mutex> lock(getSaveFileListMutex());
 
-    auto& savefiles = getSaveFileList();
-    for (const auto& savefile : savefiles) {
-        if (savefile->isSameFile(file)) {
-            return savefile->open(modes);
-        }
-    }
+    SaveFile* savefile = findSaveFile(file);
+    if (!savefile)
+        savefile = addSaveFile(file);
 
-    savefiles.emplace_front(new SaveFile(file));
-    return savefiles.front()->open(modes);
+    return savefile->open(modes);
 }
 
 int openSaveFile(const char *file, int oflag)
 {
     std::lock_guard<std::mutex> lock(getSaveFileListMutex());
 
-    auto& savefiles = getSaveFileList();
-    for (const auto& savefile : savefiles) {
-        if (savefile->isSameFile(file)) {
-            return savefile->open(oflag);
-        }
-    }
+    SaveFile* savefile = findSaveFile(file);
+    if (!savefile)
+        savefile = addSaveFile(file);
 
-    savefiles.emplace_front(new SaveFile(file));
-    return savefiles.front()->open(oflag);
+    return savefile->open(oflag);
 }
 
 int closeSaveFile(int fd)
@@ -201,17 +264,16 @@ int removeSaveFile(const char *file)
 {
     std::lock_guard<std::mutex> lock(getSaveFileListMutex());
 
-    auto& savefiles = getSaveFileList();
-    for (const auto& savefile : savefiles) {
-        if (savefile->isSameFile(file)) {
-            return savefile->remove();
-        }
-    }
+    /* The path may be reused for a new file */
+    getNotSaveFileCache().erase(getNotSaveFileKey(file));
+
+    SaveFile* savefile = findSaveFile(file);
+    if (savefile)
+        return savefile->remove();
 
     /* If the file is not registered, create a removed savefile */
     if (Global::shared_config.prevent_savefiles) {
-        savefiles.emplace_front(new SaveFile(file));
-        savefiles.front()->remove();
+        addSaveFile(file)->remove();
 
         GlobalNative gn;
         return access(file, W_OK);
@@ -230,22 +292,30 @@ int renameSaveFile(const char *oldfile, const char *newfile)
     std::string newfilestr(canonnewfile);
     free(canonnewfile);
 
+    /* The path may be reused for a new file */
+    getNotSaveFileCache().erase(newfilestr);
+
     /* Remove the newfile if present */
     auto& savefiles = getSaveFileList();
-    savefiles.remove_if([newfile](const std::unique_ptr<SaveFile>& s) { return (s->isSameFile(newfile));});
-
-    for (const auto& savefile : savefiles) {
-        if (savefile->isSameFile(oldfile)) {
-            savefile->filename = newfilestr;
-            return 0;
-        }
+    auto& index = getSaveFileIndex();
+    if (index.erase(newfilestr))
+        savefiles.remove_if([&newfilestr](const std::unique_ptr<SaveFile>& s) { return (s->filename == newfilestr);});
+
+    SaveFile* savefile = findSaveFile(oldfile);
+    if (savefile) {
+        index.erase(savefile->filename);
+        savefile->filename = newfilestr;
+        index[newfilestr] = savefile;
+        return 0;
     }
 
     /* If the file is not registered, create a savefile */
     if (isSaveFile(newfile)) {
-        savefiles.emplace_front(new SaveFile(oldfile));
-        savefiles.front()->open("rb");
-        savefiles.front()->filename = newfilestr;
+        savefile = addSaveFile(oldfile);
+        savefile->open("rb");
+        index.erase(savefile->filename);
+        savefile->filename = newfilestr;
+        index[newfilestr] = savefile;
 
         GlobalNative gn;
         return access(oldfile, W_OK);
@@ -258,12 +328,9 @@ int getSaveFileFd(const char *file)
 {
     std::lock_guard<std::mutex> lock(getSaveFileListMutex());
 
-    auto& savefiles = getSaveFileList();
-    for (const auto& savefile : savefiles) {
-        if (savefile->isSameFile(file)) {
-            return savefile->fd;
-        }
-    }
+    SaveFile* savefile = findSaveFile(file);
+    if (savefile)
+        return savefile->fd;
 
     return 0;
 }
@@ -272,16 +339,311 @@ bool isSaveFileRemoved(const char *file)
 {
     std::lock_guard<std::mutex> lock(getSaveFileListMutex());
 
-    auto& savefiles = getSaveFileList();
-    for (const auto& savefile : savefiles) {
-        if (savefile->isSameFile(file)) {
-            return savefile->removed;
+    SaveFile* savefile = findSaveFile(file);
+    if (savefile)
+        return savefile->removed;
+
+    return true;
+}
+
+#ifdef __linux__
+
+/* Snapshot of the content of a savefile, stored in its own memfd. A snapshot is
+ * shared by all savestates that were taken while the savefile was unmodified,
+ * so savestates only hold a reference to the snapshot and not its content.
+ * The table lives in reserved memory so that it is not overwritten when loading
+ * a savestate, and snapshots are closed when no savestate slot uses them.
+ */
+struct SaveFileSnapshot {
+    /* Memfd holding the content, or 0 if the entry is free */
+    int fd;
+
+    /* Incremented each time the entry is reused */
+    unsigned int gen;
+
+    /* Is the snapshot referenced by the savestate being saved */
+    bool pending;
+
+    /* Inode of the savefile memfd, and its size and stamped modification time
+     * when the snapshot was taken or restored */
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+
+    /* Savestate slots referencing this snapshot */
+    uint64_t slots[(SharedConfig::SAVESTATE_SLOTS + 63) / 64];
+
+    bool hasSlot(int slot) const { return slots[slot/64] & (1ULL << (slot%64)); }
+    void setSlot(int slot) { slots[slot/64] |= (1ULL << (slot%64)); }
+    void clearSlot(int slot) { slots[slot/64] &= ~(1ULL << (slot%64)); }
+    bool hasAnySlot() const {
+        for (uint64_t s : slots)
+            if (s) return true;
+        return false;
+    }
+};
+
+/* Header of the snapshot table, followed by the snapshots */
+struct SaveFileSnapshotHeader {
+    /* Last stamp given to a savefile memfd */
+    uint64_t last_stamp;
+
+    /* Savestates whose savefiles could not all be snapshotted */
+    bool incomplete[SharedConfig::SAVESTATE_SLOTS];
+
+    /* Whether the savestate being saved has all its snapshots */
+    bool pending_incomplete;
+};
+
+/* Snapshots are placed after the header, aligned */
+static const size_t SNAPSHOTS_OFFSET = ((sizeof(SaveFileSnapshotHeader) + alignof(SaveFileSnapshot) - 1) / alignof(SaveFileSnapshot)) * alignof(SaveFileSnapshot);
+static const int MAX_SNAPSHOTS = (ReservedMemory::SAVEFILES_SIZE - SNAPSHOTS_OFFSET) / sizeof(SaveFileSnapshot);
+
+static SaveFileSnapshotHeader* getSnapshotHeader()
+{
+    return static_cast<SaveFileSnapshotHeader*>(ReservedMemory::getAddr(ReservedMemory::SAVEFILES_ADDR));
+}
+
+static SaveFileSnapshot* getSnapshots()
+{
+    return static_cast<SaveFileSnapshot*>(ReservedMemory::getAddr(ReservedMemory::SAVEFILES_ADDR + SNAPSHOTS_OFFSET));
+}
+
+/* Return the snapshot referenced by the savefile, or -1 if the reference is stale */
+static int getSnapshotIndex(const SaveFile* savefile)
+{
+    int index = savefile->snapshot_index;
+    if ((index < 0) || (index >= MAX_SNAPSHOTS))
+        return -1;
+
+    const SaveFileSnapshot& snapshot = getSnapshots()[index];
+    if ((snapshot.fd == 0) || (snapshot.gen != savefile->snapshot_gen))
+        return -1;
+
+    return index;
+}
+
+/* Check if the savefile content is still the one of the snapshot */
+static bool isSnapshotCurrent(const SaveFileSnapshot& snapshot, const struct stat& filestat)
+{
+    return (snapshot.ino == filestat.st_ino) && (snapshot.size == filestat.st_size) &&
+        (snapshot.mtime.tv_sec == filestat.st_mtim.tv_sec) &&
+        (snapshot.mtime.tv_nsec == filestat.st_mtim.tv_nsec);
+}
+
+/* Stamp the modification time of the savefile with a unique value each time
+ * its content is set to a snapshot. Stamps are counted from the epoch, so that
+ * a write to the savefile, which sets the current time, cannot produce one. */
+static void stampSnapshot(SaveFileSnapshot& snapshot, int fd, const struct stat& filestat)
+{
+    uint64_t stamp = ++getSnapshotHeader()->last_stamp;
+
+    struct timespec times[2];
+    times[0].tv_sec = 0;
+    times[0].tv_nsec = UTIME_OMIT;
+    times[1].tv_sec = stamp / 1000000000;
+    times[1].tv_nsec = stamp % 1000000000;
+
+    snapshot.ino = filestat.st_ino;
+    snapshot.size = filestat.st_size;
+    if (futimens(fd, times) == 0) {
+        snapshot.mtime = times[1];
+    }
+    else {
+        /* Never match, so that the next savestate takes a new snapshot */
+        snapshot.mtime.tv_sec = -1;
+        snapshot.mtime.tv_nsec = -1;
+    }
+}
+
+/* Check if the file descriptor is the memfd of the savefile, by looking at its
+ * name which is the savefile path */
+static bool isSaveFileMemfd(const SaveFile* savefile)
+{
+    char fdpath[64];
+    char link[PATH_MAX];
+    snprintf(fdpath, sizeof(fdpath), "/proc/self/fd/%d", savefile->fd);
+    ssize_t len = readlink(fdpath, link, sizeof(link) - 1);
+    if (len < 0)
+        return false;
+    link[len] = '\0';
+
+    std::string name("/memfd:");
+    name += savefile->filename;
+    return (strncmp(link, name.c_str(), name.size()) == 0);
+}
+
+void snapshotSaveFiles()
+{
+    std::lock_guard<std::mutex> lock(getSaveFileListMutex());
+
+    SaveFileSnapshotHeader* header = getSnapshotHeader();
+    SaveFileSnapshot* snapshots = getSnapshots();
+    header->pending_incomplete = false;
+
+    int free_index = 0;
+    for (const auto& savefile : getSaveFileList()) {
+        if (savefile->filename.empty() || (savefile->fd == 0))
+            continue;
+
+        struct stat filestat;
+        if (fstat(savefile->fd, &filestat) != 0) {
+            header->pending_incomplete = true;
+            continue;
+        }
+
+        /* Keep the snapshot if the savefile was not modified since */
+        int index = getSnapshotIndex(savefile.get());
+        if ((index >= 0) && isSnapshotCurrent(snapshots[index], filestat)) {
+            snapshots[index].pending = true;
+            continue;
+        }
+
+        savefile->snapshot_index = -1;
+
+        while ((free_index < MAX_SNAPSHOTS) && (snapshots[free_index].fd != 0))
+            free_index++;
+
+        if (free_index == MAX_SNAPSHOTS) {
+            debuglogstdio(LCF_FILEIO | LCF_ERROR, "No more room to snapshot savefile %s", savefile->filename.c_str());
+            header->pending_incomplete = true;
+            continue;
         }
+
+        int snapshot_fd;
+        NATIVECALL(snapshot_fd = syscall(SYS_memfd_create, "savefile_snapshot", MFD_CLOEXEC));
+        if (snapshot_fd < 0) {
+            header->pending_incomplete = true;
+            continue;
+        }
+
+        if (Utils::copyAll(snapshot_fd, savefile->fd, filestat.st_size) != filestat.st_size) {
+            debuglogstdio(LCF_FILEIO | LCF_ERROR, "Could not snapshot savefile %s", savefile->filename.c_str());
+            NATIVECALL(close(snapshot_fd));
+            header->pending_incomplete = true;
+            continue;
+        }
+
+        SaveFileSnapshot& snapshot = snapshots[free_index];
+        snapshot.fd = snapshot_fd;
+        snapshot.gen++;
+        snapshot.pending = true;
+        memset(snapshot.slots, 0, sizeof(snapshot.slots));
+        stampSnapshot(snapshot, savefile->fd, filestat);
+
+        savefile->snapshot_index = free_index;
+        savefile->snapshot_gen = snapshot.gen;
+
+        debuglogstdio(LCF_FILEIO, "Snapshot savefile %s of size %d", savefile->filename.c_str(), filestat.st_size);
     }
+}
 
-    return true;
+void commitSaveFiles(int slot, bool saved)
+{
+    SaveFileSnapshotHeader* header = getSnapshotHeader();
+    SaveFileSnapshot* snapshots = getSnapshots();
+
+    if ((slot < 0) || (slot >= SharedConfig::SAVESTATE_SLOTS))
+        saved = false;
+
+    if (saved)
+        header->incomplete[slot] = header->pending_incomplete;
+
+    for (int i = 0; i < MAX_SNAPSHOTS; i++) {
+        SaveFileSnapshot& snapshot = snapshots[i];
+        if (snapshot.fd == 0)
+            continue;
+
+        /* The savestate previously in this slot was overwritten only if
+         * saving succeeded. Otherwise, new snapshots are not referenced. */
+        if (saved) {
+            if (snapshot.pending)
+                snapshot.setSlot(slot);
+            else
+                snapshot.clearSlot(slot);
+        }
+        snapshot.pending = false;
+
+        if (!snapshot.hasAnySlot()) {
+            NATIVECALL(close(snapshot.fd));
+            snapshot.fd = 0;
+        }
+    }
+}
+
+bool hasAllSnapshots(int slot)
+{
+    if ((slot < 0) || (slot >= SharedConfig::SAVESTATE_SLOTS))
+        return true;
+    return !getSnapshotHeader()->incomplete[slot];
+}
+
+void restoreSaveFiles()
+{
+    std::lock_guard<std::mutex> lock(getSaveFileListMutex());
+
+    SaveFileSnapshot* snapshots = getSnapshots();
+
+    for (const auto& savefile : getSaveFileList()) {
+        if (savefile->filename.empty() || (savefile->fd == 0))
+            continue;
+
+        /* Loading is refused beforehand if the state misses a snapshot */
+        int index = getSnapshotIndex(savefile.get());
+        if (index < 0) {
+            debuglogstdio(LCF_FILEIO | LCF_ERROR, "No snapshot of savefile %s to restore", savefile->filename.c_str());
+            continue;
+        }
+        SaveFileSnapshot& snapshot = snapshots[index];
+
+        struct stat filestat;
+        if (fstat(savefile->fd, &filestat) != 0) {
+            if (errno != EBADF)
+                continue;
+
+            /* The savefile was removed after the savestate, create it again */
+            int fd;
+            NATIVECALL(fd = syscall(SYS_memfd_create, savefile->filename.c_str(), MFD_CLOEXEC));
+            if (fd < 0)
+                continue;
+            NATIVECALL(dup2(fd, savefile->fd));
+            NATIVECALL(close(fd));
+            if (fstat(savefile->fd, &filestat) != 0)
+                continue;
+        }
+        else if ((filestat.st_ino != snapshot.ino) && !isSaveFileMemfd(savefile.get())) {
+            debuglogstdio(LCF_FILEIO | LCF_ERROR, "File descriptor %d of savefile %s is used by another file", savefile->fd, savefile->filename.c_str());
+            continue;
+        }
+
+        if (isSnapshotCurrent(snapshot, filestat))
+            continue;
+
+        if ((ftruncate(savefile->fd, 0) != 0) ||
+            (Utils::copyAll(savefile->fd, snapshot.fd, snapshot.size) != snapshot.size)) {
+            debuglogstdio(LCF_FILEIO | LCF_ERROR, "Could not restore savefile %s", savefile->filename.c_str());
+            continue;
+        }
+
+        fstat(savefile->fd, &filestat);
+        stampSnapshot(snapshot, savefile->fd, filestat);
+
+        debuglogstdio(LCF_FILEIO, "Restore savefile %s of size %d", savefile->filename.c_str(), filestat.st_size);
+    }
 }
 
+#else
+
+void snapshotSaveFiles() {}
+
+void commitSaveFiles(int slot, bool saved) {}
+
+bool hasAllSnapshots(int slot) { return true; }
+
+void restoreSaveFiles() {}
+
+#endif
+
 std::string getSaveFileInsideDir(std::string dir, int n)
 {
     std::lock_guard<std::mutex> lock(getSaveFileListMutex());
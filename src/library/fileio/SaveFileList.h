@@ -61,6 +61,25 @@ int getSaveFileFd(const char *file);
 /* Get if savefile was removed */
 bool isSaveFileRemoved(const char *file);
 
+/* Take a snapshot of the content of each savefile for the savestate being
+ * saved. Unmodified savefiles share the snapshot taken by a previous savestate.
+ * Must be called when all threads are suspended.
+ */
+void snapshotSaveFiles();
+
+/* Attach the snapshots to the savestate `slot` if it was saved, and release
+ * the snapshots that no savestate references anymore.
+ */
+void commitSaveFiles(int slot, bool saved);
+
+/* Return if the savestate `slot` has the snapshot of all its savefiles */
+bool hasAllSnapshots(int slot);
+
+/* Restore the content of each savefile from the snapshot referenced by the
+ * loaded savestate. Must be called when all threads are suspended.
+ */
+void restoreSaveFiles();
+
 /* Get the n-th save file inside directory `dir`. Returns empty string if not present */
 std::string getSaveFileInsideDir(std::string dir, int n);
 
@@ -38,6 +38,7 @@
 #include "hook.h"
 #include "UnityHacks.h"
 #include "PerfTimer.h"
+#include "FrameTiming.h"
 #include "audio/AudioContext.h"
 #include "sdl/sdlwindows.h"
 #include "sdl/sdlevents.h"
@@ -62,6 +63,7 @@
 
 #include <iomanip>
 #include <stdint.h>
+#include <cmath>
 
 namespace libtas {
 
@@ -79,51 +81,120 @@ static bool didASavestate = false;
 static void receive_messages(std::function<void()> draw, RenderHUD& hud);
 
 /* Deciding if we actually draw the frame */
+/* Estimated cost in seconds of a frame in fast-forward, when its rendering
+ * is skipped or not */
+static double skip_costs[2] = {0, 0};
+
+/* Update the estimated cost of the frame that just ended, or restart the
+ * measure if `measure` is false */
+static void updateFrameCost(bool measure)
+{
+    static double last_active = -1;
+
+    if (!measure) {
+        last_active = -1;
+        return;
+    }
+
+    /* Frame cost is measured using the time spent in the frame, except
+     * sleeping, so that it does not depend on the fast-forward sleep setting */
+    TimeHolder active = perfTimer.activeTime();
+    double t = active.tv_sec + active.tv_nsec / 1000000000.0;
+
+    /* Ignore outliers, such as frames where a savestate was performed */
+    double frame_cost = t - last_active;
+    if (last_active >= 0 && frame_cost > 0 && frame_cost < 1) {
+        /* The frame that just ended was rendered according to the previous
+         * skip decision */
+        double& cost = skip_costs[Global::skipping_draw ? 0 : 1];
+        if (cost == 0)
+            cost = frame_cost;
+        else
+            cost += 0.1 * (frame_cost - cost);
+    }
+    last_active = t;
+}
+
 static bool skipDraw(float fps)
 {
     static unsigned int skip_counter = 0;
 
     /* Don't skip if not fastforwarding */
-    if (!Global::shared_config.fastforward)
+    if (!Global::shared_config.fastforward) {
+        updateFrameCost(false);
         return false;
+    }
 
     /* Don't skip if frame-advancing */
-    if (!Global::shared_config.running)
+    if (!Global::shared_config.running) {
+        updateFrameCost(false);
         return false;
+    }
 
     /* Never skip a draw when encoding. */
-    if (Global::shared_config.av_dumping)
+    if (Global::shared_config.av_dumping) {
+        updateFrameCost(false);
         return false;
+    }
 
     /* Apply the fast-forward render setting */
     switch(Global::shared_config.fastforward_render) {
         case SharedConfig::FF_RENDER_NO:
+            updateFrameCost(false);
             return true;
         case SharedConfig::FF_RENDER_ALL:
+            updateFrameCost(false);
             return false;
         default:
             break;
     }
 
-    unsigned int skip_freq = 1;
-
-    /* I want to display about 8 effective frames per second, so I divide
-     * the fps value by 8 to get the skip frequency.
-     * Moreover, it is better to have bands of the same skip frequency, so
-     * I take the next highest power of 2.
-     * Because the value is already in a float, I can use this neat trick from
-     * http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2
-     */
+    updateFrameCost(true);
 
-    if (fps > 1) {
-        fps--;
-        memcpy(&skip_freq, &fps, sizeof(int));
-        skip_freq = 1U << ((skip_freq >> 23) - 126 - 3); // -3 -> divide by 8
+    unsigned int skip_freq = 1;
+    int display_rate = Global::shared_config.fastforward_display_rate;
+    if (display_rate <= 0)
+        display_rate = 8;
+
+    if (skip_costs[0] > 0 && skip_costs[1] > 0) {
+        /* Rendering one frame every `skip_freq` frames takes
+         * (skip_freq - 1) * skipped + rendered seconds. We choose the highest
+         * frequency that still displays `display_rate` frames per second,
+         * which maximizes the number of emulated frames. */
+        double freq = 1 + (1.0 / display_rate - skip_costs[1]) / skip_costs[0];
+
+        /* If rendering is too expensive to reach the display rate, don't
+         * spend more time on rendering than on emulating frames, which needs
+         * (skip_freq - 1) * skipped >= rendered */
+        double min_freq = std::ceil(1 + skip_costs[1] / skip_costs[0]);
+        if (freq < min_freq)
+            freq = min_freq;
+
+        if (freq < 1)
+            skip_freq = 1;
+        else if (freq > 1024)
+            skip_freq = 1024;
+        else
+            skip_freq = static_cast<unsigned int>(freq);
     }
+    else {
+        /* Until both costs are measured, display about `display_rate` frames
+         * per second based on the game fps value. It is better to have bands
+         * of the same skip frequency, so I take the next highest power of 2.
+         * Because the value is already in a float, I can use this neat trick from
+         * http://graphics.stanford.edu/~seander/bithacks.html#RoundUpPowerOf2
+         */
+        float ratio = fps / display_rate;
+        if (ratio > 2) {
+            ratio--;
+            memcpy(&skip_freq, &ratio, sizeof(int));
+            skip_freq = 1U << ((skip_freq >> 23) - 126);
+        }
 
-    /* At least skip 3 frames out of 4 */
-    if (skip_freq < 4)
-        skip_freq = 4;
+        /* At least skip 3 frames out of 4 */
+        if (skip_freq < 4)
+            skip_freq = 4;
+    }
 
     if (++skip_counter >= skip_freq) {
         skip_counter = 0;
@@ -156,6 +227,7 @@ static void sendFrameCountTime()
 void frameBoundary(std::function<void()> draw, RenderHUD& hud)
 {
     perfTimer.switchTimer(PerfTimer::FrameTimer);
+    FrameTiming::switchPhase(FrameTrace::GAME_SYNC);
 
     static float fps, lfps = 0;
 
@@ -192,10 +264,12 @@ void frameBoundary(std::function<void()> draw, RenderHUD& hud)
     perfTimer.switchTimer(PerfTimer::FrameTimer);
 
     /* Update the deterministic timer, sleep if necessary */
+    FrameTiming::switchPhase(FrameTrace::GAME_TIMER);
     DeterministicTimer& detTimer = DeterministicTimer::get();
     TimeHolder timeIncrement = detTimer.enterFrameBoundary();
 
     /* Mix audio, except if the game opened a loopback context */
+    FrameTiming::switchPhase(FrameTrace::GAME_AUDIO);
     AudioContext& audiocontext = AudioContext::get();
     if (! audiocontext.isLoopback) {
         audiocontext.mixAllSources(timeIncrement);
@@ -239,11 +313,15 @@ void frameBoundary(std::function<void()> draw, RenderHUD& hud)
      */
 
     /* Other threads may send socket messages, so we lock the socket */
+    FrameTiming::switchPhase(FrameTrace::GAME_SEND);
     lockSocket();
 
     /* Send framecount and internal time */    
     sendFrameCountTime();
 
+    /* Send the timeline of the previous frame */
+    FrameTiming::send();
+
     /* Send GameInfo struct if needed */
     if (Global::game_info.tosend) {
         sendMessage(MSGB_GAMEINFO);
@@ -281,6 +359,7 @@ void frameBoundary(std::function<void()> draw, RenderHUD& hud)
 
     /* Receive messages from the program */
     perfTimer.switchTimer(PerfTimer::WaitTimer);                
+    FrameTiming::switchPhase(FrameTrace::GAME_WAIT);
     int message = receiveMessage();
     
     while (message != MSGN_START_FRAMEBOUNDARY) {
@@ -308,6 +387,7 @@ void frameBoundary(std::function<void()> draw, RenderHUD& hud)
         message = receiveMessage();
     }
     perfTimer.switchTimer(PerfTimer::FrameTimer);
+    FrameTiming::switchPhase(FrameTrace::GAME_HUD);
 
     /*** Rendering ***/
     if (!draw)
@@ -350,7 +430,9 @@ void frameBoundary(std::function<void()> draw, RenderHUD& hud)
         }
 
         /* Write the current frame */
+        FrameTiming::startCounter(FrameTiming::COUNTER_ENCODE);
         avencoder->encodeOneFrame(!!draw, timeIncrement);
+        FrameTiming::stopCounter(FrameTiming::COUNTER_ENCODE);
     }
     else {
         /* If there is still an encoder object, it means we just stopped
@@ -384,15 +466,18 @@ void frameBoundary(std::function<void()> draw, RenderHUD& hud)
     if (!Global::skipping_draw && draw) {
         GlobalNoLog gnl;
         perfTimer.switchTimer(PerfTimer::RenderTimer);
+        FrameTiming::switchPhase(FrameTrace::GAME_DRAW);
         NATIVECALL(draw());
         perfTimer.switchTimer(PerfTimer::FrameTimer);
     }
 
     /* Receive messages from the program */
+    FrameTiming::switchPhase(FrameTrace::GAME_RECEIVE);
     receive_messages(draw, hud);
 
     /* No more socket messages here, unlocking the socket. */
     unlockSocket();
+    FrameTiming::switchPhase(FrameTrace::GAME_EVENTS);
 
     /* Some methods of drawing on screen don't always update the full screen.
      * Our current screen may be dirty with OSD, so in that case, we must
@@ -482,6 +567,7 @@ void frameBoundary(std::function<void()> draw, RenderHUD& hud)
     if (!Global::skipping_draw)
         hud.newFrame();
 
+    FrameTiming::endFrame(framecount);
     perfTimer.switchTimer(PerfTimer::GameTimer);
     
     // if ((framecount % 10000) == 9999)
@@ -690,8 +776,14 @@ static void receive_messages(std::function<void()> draw, RenderHUD& hud)
                     screen_redraw(draw, hud, preview_ai, true);
                 }
 
+                FrameTiming::startCounter(FrameTiming::COUNTER_SAVESTATE);
                 status = SaveStateManager::checkpoint(slot);
 
+                /* When loading a state, the timing memory has been restored
+                 * as well, so the duration cannot be computed. */
+                if (!SaveStateManager::isLoading())
+                    FrameTiming::stopCounter(FrameTiming::COUNTER_SAVESTATE);
+
                 if (status == 0) {
                     /* Current savestate is now the parent savestate */
                     Checkpoint::setCurrentToParent();
@@ -742,8 +834,9 @@ static void receive_messages(std::function<void()> draw, RenderHUD& hud)
 
                 }
                 else {
-                    /* A bit hackish, we must send something */
-                    sendMessage(-1);
+                    /* Send the negative error code, which cannot be mistaken
+                     * for a message */
+                    sendMessage(status);
                 }
 
                 break;
@@ -756,10 +849,12 @@ static void receive_messages(std::function<void()> draw, RenderHUD& hud)
 
                 SaveStateManager::printError(status);
 
-                /* If restoring failed, we return here. We still send the
-                 * frame count and time because the program will pull a
-                 * message in either case.
+                /* If restoring failed, we return here. Send the negative
+                 * error code, and we still send the frame count and time
+                 * because the program will pull a message in either case.
                  */
+                if (status < 0)
+                    sendMessage(status);
                 sendFrameCountTime();
                 break;
 
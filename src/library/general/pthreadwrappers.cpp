@@ -191,6 +191,29 @@ static void *pthread_native_start(void *arg)
     return thread_start(thread_arg);
 }
 
+void create_idle_threads(int count)
+{
+    LINK_NAMESPACE(pthread_create, "pthread");
+    LINK_NAMESPACE(pthread_detach, "pthread");
+
+    debuglogstdio(LCF_THREAD, "Creating %d idle threads", count);
+
+    for (int i = 0; i < count; i++) {
+        /* The thread puts itself in the pool of idle threads, and waits for
+         * a routine to execute */
+        ThreadInfo* thread = new ThreadInfo();
+        thread->state = ThreadInfo::ST_IDLE;
+
+        pthread_t pthread_id;
+        if (orig::pthread_create(&pthread_id, nullptr, pthread_start, thread) != 0) {
+            debuglogstdio(LCF_THREAD | LCF_ERROR, "Could not create idle thread");
+            delete thread;
+            return;
+        }
+        orig::pthread_detach(pthread_id);
+    }
+}
+
 
 /* Override */ int pthread_create (pthread_t * tid_p, const pthread_attr_t * attr, void * (* start_routine) (void *), void * arg) __THROW
 {
@@ -229,7 +252,12 @@ static void *pthread_native_start(void *arg)
         debuglogstdio(LCF_THREAD, "Recycling thread %d", thread->tid);
         *tid_p = thread->pthread_id;
 #ifdef __linux__
-        /* Notify the thread that it has a function to execute */
+        /* Notify the thread that it has a function to execute. Taking the
+         * thread mutex ensures that the thread is either waiting or has not
+         * checked its state yet, so that the notification is not lost. */
+        {
+            std::lock_guard<std::mutex> lock(thread->mutex);
+        }
         thread->cv.notify_all();
 #endif
     }
@@ -453,11 +481,15 @@ static std::map<pthread_cond_t*, clockid_t>& getCondClock() {
     if (GlobalState::isNative())
         return orig::pthread_cond_wait(cond, mutex);
 
+    debuglogstdio(LCF_WAIT | LCF_TODO, "%s call with cond %p and mutex %p", __func__, static_cast<void*>(cond), static_cast<void*>(mutex));
+
     if (Global::shared_config.game_specific_sync & SharedConfig::GC_SYNC_CELESTE) {
         ThreadSync::detSignal(false);
+        int ret = orig::pthread_cond_wait(cond, mutex);
+        ThreadSync::detResume();
+        return ret;
     }
 
-    debuglogstdio(LCF_WAIT | LCF_TODO, "%s call with cond %p and mutex %p", __func__, static_cast<void*>(cond), static_cast<void*>(mutex));
     return orig::pthread_cond_wait(cond, mutex);
 }
 
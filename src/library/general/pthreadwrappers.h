@@ -31,6 +31,9 @@
 
 namespace libtas {
 
+/* Create idle threads in advance, to be recycled when the game creates threads */
+void create_idle_threads(int count);
+
 /* Create a new thread, starting with execution of START-ROUTINE
    getting passed ARG.  Creation attributed come from ATTR.  The new
    handle is stored in *NEWTHREAD.  */
@@ -23,6 +23,9 @@
 #include "GlobalState.h"
 
 #include <map>
+#include <mutex>
+#include <vector>
+#include <utility>
 
 namespace libtas {
 
@@ -38,18 +41,37 @@ static std::map<pthread_key_t, void(*)(void*)>& getPthreadKeys() {
     return pthread_keys;
 }
 
+/* Mutex to protect the key map, which is modified by game threads while
+ * recycled threads go through it */
+static std::mutex& getPthreadKeysMutex() {
+    static std::mutex* mutex = new std::mutex;
+    return *mutex;
+}
+
 void clear_pthread_keys()
 {
     LINK_NAMESPACE(pthread_getspecific, "pthread");
     LINK_NAMESPACE(pthread_setspecific, "pthread");
 
-    std::map<pthread_key_t, void(*)(void*)> pthread_keys = getPthreadKeys();
+    /* Only the keys created by the game are registered, so this is much
+     * cheaper than going through all possible keys. */
+    /* Work on a copy of the keys, because destructors may create or delete
+     * keys themselves */
+    std::vector<std::pair<pthread_key_t, void(*)(void*)>> pthread_keys;
+    {
+        std::lock_guard<std::mutex> lock(getPthreadKeysMutex());
+        const std::map<pthread_key_t, void(*)(void*)>& keys = getPthreadKeys();
+        pthread_keys.assign(keys.begin(), keys.end());
+    }
+
     for( const auto& pair : pthread_keys ) {
-        if (orig::pthread_getspecific(pair.first)) {
+        void* value = orig::pthread_getspecific(pair.first);
+        if (value) {
             debuglogstdio(LCF_THREAD, "  removing value from key %d", pair.first);
             orig::pthread_setspecific(pair.first, nullptr);
-            if (orig::pthread_getspecific(pair.first)) {
+            if (pair.second) {
                 debuglogstdio(LCF_THREAD, "  calling destructor for key %d", pair.first);
+                pair.second(value);
             }
         }
     }
@@ -67,7 +89,8 @@ int pthread_key_create (pthread_key_t *key, void (*destr_function) (void *)) __T
 
     debuglogstdio(LCF_THREAD, "   returning %d", *key);
 
-    std::map<pthread_key_t, void(*)(void*)> pthread_keys = getPthreadKeys();
+    std::lock_guard<std::mutex> lock(getPthreadKeysMutex());
+    std::map<pthread_key_t, void(*)(void*)>& pthread_keys = getPthreadKeys();
     pthread_keys.insert(std::pair<pthread_key_t, void(*)(void*)>(*key,destr_function));
 
     return ret;
@@ -83,7 +106,8 @@ int pthread_key_delete (pthread_key_t key) __THROW
     debuglogstdio(LCF_THREAD, "%s called on key %d", __func__, key);
     int ret = orig::pthread_key_delete(key);
 
-    std::map<pthread_key_t, void(*)(void*)> pthread_keys = getPthreadKeys();
+    std::lock_guard<std::mutex> lock(getPthreadKeysMutex());
+    std::map<pthread_key_t, void(*)(void*)>& pthread_keys = getPthreadKeys();
     auto it = pthread_keys.find(key);
     if (it != pthread_keys.end()) {
         pthread_keys.erase (it);
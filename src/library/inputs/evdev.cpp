@@ -36,6 +36,18 @@ namespace libtas {
 /* The tuple contains pipe in fd, pipe out fd, and then refcount. */
 static std::pair<std::pair<int, int>, int> evdevfds[AllInputsFlat::MAXJOYS];
 
+/* Maximum number of events in the pipe, in case the game does not read them */
+static const int EVDEV_MAX_EVENTS = 64;
+
+/* Events generated during the frame, written at once by flush_evdev() */
+static struct input_event evdevqueue[AllInputsFlat::MAXJOYS][EVDEV_MAX_EVENTS];
+static int evdevqueuesize[AllInputsFlat::MAXJOYS];
+
+/* Upper bound of the number of events in each pipe. The game reading events
+ * can only lower the real count, so we only need to query the pipe when the
+ * bound is reached. */
+static int evdevpipelevel[AllInputsFlat::MAXJOYS];
+
 int is_evdev(const char* source)
 {
     /* Extract the ev number from the dev filename */
@@ -73,6 +85,8 @@ int open_evdev(const char* source, int flags)
 
         /* Create an unnamed pipe. */
         evdevfds[evnum].first = FileHandleList::createPipe(flags);
+        evdevqueuesize[evnum] = 0;
+        evdevpipelevel[evnum] = 0;
         
         /* If pipe creation failed (e.g. when opening the dev file in write mode),
          * invalidate the pipe and return -1. */
@@ -91,26 +105,54 @@ void write_evdev(struct input_event ev, int evnum)
     if (evdevfds[evnum].second == 0)
         return;
 
-    /* Check pipe size and don't write if too big */
-    int pipeSize;
-    NATIVECALL(MYASSERT(ioctl(evdevfds[evnum].first.first, FIONREAD, &pipeSize) == 0));
-
-    if (pipeSize < static_cast<int>(64*sizeof(ev)))
-        write(evdevfds[evnum].first.second, &ev, sizeof(ev));
+    if (evdevqueuesize[evnum] < EVDEV_MAX_EVENTS)
+        evdevqueue[evnum][evdevqueuesize[evnum]++] = ev;
     else {
         debuglogstdio(LCF_JOYSTICK | LCF_WARNING, "did not write evdev event, too many already.");
     }
 }
 
+void flush_evdev(int evnum)
+{
+    int count = evdevqueuesize[evnum];
+    if (evdevfds[evnum].second == 0 || count == 0)
+        return;
+
+    evdevqueuesize[evnum] = 0;
+
+    /* Only check the pipe size if the events may not fit */
+    if (evdevpipelevel[evnum] + count > EVDEV_MAX_EVENTS) {
+        int pipeSize;
+        NATIVECALL(MYASSERT(ioctl(evdevfds[evnum].first.first, FIONREAD, &pipeSize) == 0));
+        evdevpipelevel[evnum] = (pipeSize + sizeof(struct input_event) - 1) / sizeof(struct input_event);
+    }
+
+    int room = EVDEV_MAX_EVENTS - evdevpipelevel[evnum];
+    if (count > room) {
+        debuglogstdio(LCF_JOYSTICK | LCF_WARNING, "did not write %d evdev events, too many already.", count - (room > 0 ? room : 0));
+        count = room;
+    }
+
+    if (count <= 0)
+        return;
+
+    ssize_t ret = write(evdevfds[evnum].first.second, evdevqueue[evnum], count * sizeof(struct input_event));
+    if (ret > 0)
+        evdevpipelevel[evnum] += ret / sizeof(struct input_event);
+}
+
 bool sync_evdev(int evnum)
 {
     if (evdevfds[evnum].second == 0)
         return false;
 
+    flush_evdev(evnum);
+
     int attempts = 0, count = 0;
     NATIVECALL(ioctl(evdevfds[evnum].first.first, FIONREAD, &count));
 
-    if (count >= static_cast<int>(64*sizeof(struct input_event)))
+    evdevpipelevel[evnum] = (count + sizeof(struct input_event) - 1) / sizeof(struct input_event);
+    if (evdevpipelevel[evnum] >= EVDEV_MAX_EVENTS)
         return false;
 
     do {
@@ -125,6 +167,7 @@ bool sync_evdev(int evnum)
         }
     } while (count > 0);
 
+    evdevpipelevel[evnum] = 0;
     return true;
 }
 
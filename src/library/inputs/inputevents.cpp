@@ -1168,6 +1168,16 @@ void generateInputEvents(void)
     generateMouseMotionEvents();
     generateMouseButtonEvents();
     generateFocusEvents();    
+
+#ifdef __linux__
+    /* Write the jsdev and evdev events of the frame at once for each device */
+    for (int i = 0; i < Global::shared_config.nb_controllers; i++) {
+        if (Global::game_info.joystick & GameInfo::JSDEV)
+            flush_jsdev(i);
+        if (Global::game_info.joystick & GameInfo::EVDEV)
+            flush_evdev(i);
+    }
+#endif
 }
 
 void syncControllerEvents()
@@ -36,6 +36,18 @@ namespace libtas {
 /* The tuple contains pipe in fd, pipe out fd, and then refcount. */
 static std::pair<std::pair<int, int>, int> jsdevfds[AllInputsFlat::MAXJOYS];
 
+/* Maximum number of events in the pipe, in case the game does not read them */
+static const int JSDEV_MAX_EVENTS = 64;
+
+/* Events generated during the frame, written at once by flush_jsdev() */
+static struct js_event jsdevqueue[AllInputsFlat::MAXJOYS][JSDEV_MAX_EVENTS];
+static int jsdevqueuesize[AllInputsFlat::MAXJOYS];
+
+/* Upper bound of the number of events in each pipe. The game reading events
+ * can only lower the real count, so we only need to query the pipe when the
+ * bound is reached. */
+static int jsdevpipelevel[AllInputsFlat::MAXJOYS];
+
 int is_jsdev(const char* source)
 {
     /* Extract the js number from the dev filename */
@@ -73,6 +85,8 @@ int open_jsdev(const char* source, int flags)
 
         /* Create an unnamed pipe */
         jsdevfds[jsnum].first = FileHandleList::createPipe(flags);
+        jsdevqueuesize[jsnum] = 0;
+        jsdevpipelevel[jsnum] = 0;
 
         /* If pipe creation failed (e.g. when opening the dev file in write mode),
          * invalidate the pipe and return -1. */
@@ -99,6 +113,7 @@ int open_jsdev(const char* source, int flags)
             ev.number = axis;
             write_jsdev(ev, jsnum);
         }
+        flush_jsdev(jsnum);
     }
 
     return jsdevfds[jsnum].first.first;
@@ -109,27 +124,55 @@ void write_jsdev(struct js_event ev, int jsnum)
     if (jsdevfds[jsnum].second == 0)
         return;
 
-    /* Check pipe size and don't write if too big */
-    int pipeSize;
-    NATIVECALL(MYASSERT(ioctl(jsdevfds[jsnum].first.first, FIONREAD, &pipeSize) == 0));
-
-    if (pipeSize < static_cast<int>(64*sizeof(ev)))
-        write(jsdevfds[jsnum].first.second, &ev, sizeof(ev));
+    if (jsdevqueuesize[jsnum] < JSDEV_MAX_EVENTS)
+        jsdevqueue[jsnum][jsdevqueuesize[jsnum]++] = ev;
     else {
         debuglogstdio(LCF_JOYSTICK | LCF_WARNING, "did not write jsdev event, too many already.");
     }
 }
 
+void flush_jsdev(int jsnum)
+{
+    int count = jsdevqueuesize[jsnum];
+    if (jsdevfds[jsnum].second == 0 || count == 0)
+        return;
+
+    jsdevqueuesize[jsnum] = 0;
+
+    /* Only check the pipe size if the events may not fit */
+    if (jsdevpipelevel[jsnum] + count > JSDEV_MAX_EVENTS) {
+        int pipeSize;
+        NATIVECALL(MYASSERT(ioctl(jsdevfds[jsnum].first.first, FIONREAD, &pipeSize) == 0));
+        jsdevpipelevel[jsnum] = (pipeSize + sizeof(struct js_event) - 1) / sizeof(struct js_event);
+    }
+
+    int room = JSDEV_MAX_EVENTS - jsdevpipelevel[jsnum];
+    if (count > room) {
+        debuglogstdio(LCF_JOYSTICK | LCF_WARNING, "did not write %d jsdev events, too many already.", count - (room > 0 ? room : 0));
+        count = room;
+    }
+
+    if (count <= 0)
+        return;
+
+    ssize_t ret = write(jsdevfds[jsnum].first.second, jsdevqueue[jsnum], count * sizeof(struct js_event));
+    if (ret > 0)
+        jsdevpipelevel[jsnum] += ret / sizeof(struct js_event);
+}
+
 bool sync_jsdev(int jsnum)
 {
     if (jsdevfds[jsnum].second == 0)
         return false;
 
+    flush_jsdev(jsnum);
+
     /* Do not attempt to sync if the pipe is already full */
     int attempts = 0, count = 0;
     NATIVECALL(ioctl(jsdevfds[jsnum].first.first, FIONREAD, &count));
 
-    if (count >= static_cast<int>(64*sizeof(struct js_event)))
+    jsdevpipelevel[jsnum] = (count + sizeof(struct js_event) - 1) / sizeof(struct js_event);
+    if (jsdevpipelevel[jsnum] >= JSDEV_MAX_EVENTS)
         return false;
 
     do {
@@ -144,6 +187,7 @@ bool sync_jsdev(int jsnum)
         }
     } while (count > 0);
 
+    jsdevpipelevel[jsnum] = 0;
     return true;
 }
 
@@ -32,9 +32,12 @@ int is_jsdev(const char* source);
 /* Open a fake jsdev file using SYS_memfd_create, and write the init data */
 int open_jsdev(const char* source, int flags);
 
-/* Write an js event in the file */
+/* Queue a js event, to be written in the file by flush_jsdev() */
 void write_jsdev(struct js_event ev, int jsnum);
 
+/* Write all queued js events in the file at once */
+void flush_jsdev(int jsnum);
+
 /* Block, waiting for the js event queue to become empty. Return true if
  * queue is empty. */
 bool sync_jsdev(int jsnum);
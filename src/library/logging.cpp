@@ -18,6 +18,7 @@
  */
 
 #include "logging.h"
+#include "AsyncLog.h"
 #include "checkpoint/ThreadManager.h" // isMainThread()
 #include "frame.h" // For framecount
 #include "global.h" // Global::shared_config
@@ -77,6 +78,21 @@ void debuglogfull(LogCategoryFlag lcf, const char* file, int line, ...)
      */
      GlobalNoLog tnl;
 
+    /* Push the message to the program for asynchronous formatting. Errors,
+     * warnings and alerts are still printed right away, so that they also
+     * appear in the log window. Forked processes must not write into the
+     * rings of the parent threads. */
+    if (Global::shared_config.async_logging && !Global::is_fork &&
+        !(lcf & (LCF_ERROR | LCF_WARNING | LCF_ALERT))) {
+        va_list args;
+        va_start(args, line);
+        char* fmt = va_arg(args, char *);
+        bool pushed = AsyncLog::push(lcf, file, line, fmt, args);
+        va_end(args);
+        if (pushed)
+            return;
+    }
+
     /* Build main log string */
 
     /* We avoid any memory allocation here, because some parts of our code
@@ -86,8 +102,11 @@ void debuglogfull(LogCategoryFlag lcf, const char* file, int line, ...)
     char s[2048] = {'\0'};
     int size = 0;
 
-    /* We only print colors if displayed on a terminal */
-    bool isTerm = isatty(/*cerr*/ 2);
+    /* We only print colors if displayed on a terminal. stderr is set by the
+     * program before launching the game, so we only check it once. */
+    static int isTerm = -1;
+    if (isTerm == -1)
+        isTerm = isatty(/*cerr*/ 2);
     if (isTerm) {
         if (lcf & LCF_ERROR)
             /* Write the header text in red */
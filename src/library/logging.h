@@ -21,6 +21,7 @@
 #define LIBTAS_LOGGING_H_INCL
 
 #include "../shared/lcf.h"
+#include "global.h" // Global::shared_config
 //#include "PerfTimer.h"
 
 #include <string>
@@ -35,10 +36,19 @@ namespace libtas {
 /* Actual implementation with file and line */
 void debuglogfull(LogCategoryFlag lcf, const char* file, int line, ...);
 
+/* Quick check of the log category flags, so that disabled messages in
+ * frequently called functions cost almost nothing */
+inline bool debuglogEnabled(LogCategoryFlag lcf)
+{
+    return (lcf & LCF_ALERT) ||
+        ((lcf & Global::shared_config.includeFlags) && !(lcf & Global::shared_config.excludeFlags));
+}
+
 /* Print the debug message using stdio functions */
 #define debuglogstdio(lcf, ...) do {\
 /*    PerfTimerCall ptc(lcf); */ \
-    debuglogfull(lcf, __FILE__, __LINE__, __VA_ARGS__);\
+    if (debuglogEnabled(lcf)) \
+        debuglogfull(lcf, __FILE__, __LINE__, __VA_ARGS__);\
     } while (0)
 
 /* If we only want to print the function name... */
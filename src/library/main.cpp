@@ -19,6 +19,7 @@
 
 #include "main.h"
 #include "logging.h"
+#include "AsyncLog.h"
 #include "global.h"
 #include "NonDeterministicTimer.h"
 #include "DeterministicTimer.h"
@@ -31,6 +32,7 @@
 #include "steam/isteamuser.h" // SteamSetUserDataFolder
 #include "general/dlhook.h"
 #include "general/monowrappers.h"
+#include "general/pthreadwrappers.h" // create_idle_threads
 #include "steam/isteamremotestorage/isteamremotestorage.h" // SteamSetRemoteStorageFolder
 #include "inputs/inputs.h"
 #include "checkpoint/ThreadManager.h"
@@ -191,6 +193,17 @@ void __attribute__((constructor)) init(void)
         raise(SIGINT);
     }
 
+    /* Send the shared memory object for asynchronous logging. It is
+     * received by the program with the messages of the first frame. */
+    if (Global::shared_config.async_logging) {
+        AsyncLog::init();
+        int log_fd = AsyncLog::getFd();
+        if (log_fd >= 0) {
+            sendMessage(MSGB_LOG_RING);
+            sendData(&log_fd, sizeof(int));
+        }
+    }
+
 
     /* Initialize timers. It uses the initial time set in the config object,
      * so they must be initialized after receiving it.
@@ -201,6 +214,10 @@ void __attribute__((constructor)) init(void)
     /* Initialize sound parameters */
     AudioContext::get().init();
 
+    /* Fill the pool of threads to be recycled */
+    if (Global::shared_config.recycle_threads && Global::shared_config.thread_pool_size > 0)
+        create_idle_threads(Global::shared_config.thread_pool_size);
+
     hook_mono();
 
     Global::is_inited = true;
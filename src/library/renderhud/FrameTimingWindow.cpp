@@ -0,0 +1,80 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "FrameTimingWindow.h"
+
+#include "FrameTiming.h"
+#include "checkpoint/ThreadManager.h"
+#include "global.h"
+#include "../external/imgui/imgui.h"
+
+namespace libtas {
+
+void FrameTimingWindow::draw(bool* p_open = nullptr)
+{
+    if (!ImGui::Begin("Frame Timing", p_open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    if (ImGui::BeginTable("phases", 4, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("Avg (ms)");
+        ImGui::TableSetupColumn("Max (ms)");
+        ImGui::TableSetupColumn("Last frames", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
+
+        for (int p = 0; p < FrameTrace::GAME_PHASES; p++) {
+            int offset;
+            const float* values = FrameTiming::getHistory(p, &offset);
+
+            float sum = 0, max = 0;
+            for (int i = 0; i < FrameTiming::HISTORY_SIZE; i++) {
+                sum += values[i];
+                if (values[i] > max)
+                    max = values[i];
+            }
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(FrameTrace::gamePhaseName(p));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", sum / FrameTiming::HISTORY_SIZE);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", max);
+            ImGui::TableNextColumn();
+            ImGui::PushID(p);
+            ImGui::PlotHistogram("##history", values, FrameTiming::HISTORY_SIZE, offset, nullptr, 0.0f, max, ImVec2(-1.0f, ImGui::GetTextLineHeight()));
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+
+    if (Global::shared_config.recycle_threads) {
+        int idle, hits, misses;
+        ThreadManager::getPoolStats(&idle, &hits, &misses);
+        ImGui::Text("Thread pool: %d idle, %d recycled, %d created", idle, hits, misses);
+    }
+
+    ImGui::End();
+}
+
+}
@@ -0,0 +1,128 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PerformanceWindow.h"
+
+#include "FrameTiming.h"
+#include "../external/imgui/imgui.h"
+
+#include <algorithm>
+
+namespace libtas {
+
+/* Rows of the window, built from the frame phases and counters */
+enum {
+    ROW_GAME, // game code
+    ROW_BOUNDARY, // all phases of the frame boundary
+    ROW_AUDIO, // audio mixing
+    ROW_SOCKET, // communication with the program, without savestates
+    ROW_ENCODE, // audio and video encoding
+    ROW_SAVESTATE, // saving states
+    ROWS,
+};
+
+static const char* rowName(int row)
+{
+    static const char* names[ROWS] = {"Game", "Frame boundary", "Audio mixing",
+        "Socket", "Encoding", "Savestate"};
+    return names[row];
+}
+
+/* Returns the value at a given percentile of a sorted history */
+static float percentile(const float* sorted, float p)
+{
+    return sorted[static_cast<int>(p * (FrameTiming::HISTORY_SIZE - 1) + 0.5f)];
+}
+
+void PerformanceWindow::draw(bool* p_open = nullptr)
+{
+    if (!ImGui::Begin("Performance", p_open))
+    {
+        ImGui::End();
+        return;
+    }
+
+    /* Build the history of each row, from the oldest to the newest frame */
+    static float values[ROWS][FrameTiming::HISTORY_SIZE];
+
+    int offset;
+    const float* phases[FrameTrace::GAME_PHASES];
+    for (int p = 0; p < FrameTrace::GAME_PHASES; p++)
+        phases[p] = FrameTiming::getHistory(p, &offset);
+    const float* encode = FrameTiming::getCounterHistory(FrameTiming::COUNTER_ENCODE, &offset);
+    const float* savestate = FrameTiming::getCounterHistory(FrameTiming::COUNTER_SAVESTATE, &offset);
+
+    for (int i = 0; i < FrameTiming::HISTORY_SIZE; i++) {
+        int f = (offset + i) % FrameTiming::HISTORY_SIZE;
+
+        float boundary = 0;
+        for (int p = 0; p < FrameTrace::GAME_PHASES; p++)
+            if (p != FrameTrace::GAME_RUN)
+                boundary += phases[p][f];
+
+        /* Savestates are performed while processing messages from the program */
+        float socket = phases[FrameTrace::GAME_SEND][f] + phases[FrameTrace::GAME_WAIT][f] +
+            phases[FrameTrace::GAME_RECEIVE][f] - savestate[f];
+
+        values[ROW_GAME][i] = phases[FrameTrace::GAME_RUN][f];
+        values[ROW_BOUNDARY][i] = boundary;
+        values[ROW_AUDIO][i] = phases[FrameTrace::GAME_AUDIO][f];
+        values[ROW_SOCKET][i] = (socket > 0) ? socket : 0;
+        values[ROW_ENCODE][i] = encode[f];
+        values[ROW_SAVESTATE][i] = savestate[f];
+    }
+
+    if (ImGui::BeginTable("performance", 6, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("(ms)");
+        ImGui::TableSetupColumn("p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("Max");
+        ImGui::TableSetupColumn("Last frames", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
+
+        float sorted[FrameTiming::HISTORY_SIZE];
+        for (int r = 0; r < ROWS; r++) {
+            std::copy(values[r], values[r] + FrameTiming::HISTORY_SIZE, sorted);
+            std::sort(sorted, sorted + FrameTiming::HISTORY_SIZE);
+            float max = sorted[FrameTiming::HISTORY_SIZE - 1];
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(rowName(r));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", percentile(sorted, 0.50f));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", percentile(sorted, 0.95f));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", percentile(sorted, 0.99f));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", max);
+            ImGui::TableNextColumn();
+            ImGui::PushID(r);
+            ImGui::PlotLines("##history", values[r], FrameTiming::HISTORY_SIZE, 0, nullptr, 0.0f, max, ImVec2(-1.0f, 2 * ImGui::GetTextLineHeight()));
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+}
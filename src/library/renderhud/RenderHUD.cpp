@@ -26,6 +26,8 @@
 #include "MessageWindow.h"
 #include "WatchesWindow.h"
 #include "AudioDebug.h"
+#include "FrameTimingWindow.h"
+#include "PerformanceWindow.h"
 
 #include "GlobalState.h"
 #include "global.h" // Global::shared_config
@@ -142,6 +144,8 @@ void RenderHUD::drawAll(uint64_t framecount, uint64_t nondraw_framecount, const
     static bool show_crosshair = false;
     static bool show_log = false;
     static bool show_audio = false;
+    static bool show_frame_timing = false;
+    static bool show_performance = false;
     static bool show_demo = false;
     
     if (Global::shared_config.osd) {
@@ -160,6 +164,8 @@ void RenderHUD::drawAll(uint64_t framecount, uint64_t nondraw_framecount, const
             if (ImGui::BeginMenu("Debug")) {
                 ImGui::MenuItem("Log", nullptr, &show_log);
                 ImGui::MenuItem("Audio", nullptr, &show_audio);
+                ImGui::MenuItem("Frame timing", nullptr, &show_frame_timing);
+                ImGui::MenuItem("Performance", nullptr, &show_performance);
                 ImGui::MenuItem("Demo", nullptr, &show_demo);
                 ImGui::EndMenu();
             }
@@ -197,6 +203,12 @@ void RenderHUD::drawAll(uint64_t framecount, uint64_t nondraw_framecount, const
     if (show_audio)
         AudioDebug::draw(framecount, &show_audio);
 
+    if (show_frame_timing)
+        FrameTimingWindow::draw(&show_frame_timing);
+
+    if (show_performance)
+        PerformanceWindow::draw(&show_performance);
+
     if (show_demo)
         ImGui::ShowDemoWindow(&show_demo);
 }
@@ -23,12 +23,42 @@
 #include "Context.h"
 
 #include <iostream>
+#include <thread>
+#include <atomic>
 #include <dirent.h> // scandir
 #include <unistd.h> // unlink
 
 static time_t last_time_saved = time(nullptr);
 static int nb_frame_advance = 0;
 
+/* Thread writing and compressing the autosave, and whether it is still running.
+ * The thread is joined on destruction, so that exiting the program without
+ * calling AutoSave::stop() does not terminate it while the thread is joinable. */
+static struct AutoSaveThread {
+	std::thread thread;
+	~AutoSaveThread() {
+		if (thread.joinable())
+			thread.join();
+	}
+} autosave;
+static std::thread& autosave_thread = autosave.thread;
+static std::atomic<bool> autosave_running(false);
+
+static void autosaveWorker(std::string dir, std::string moviefile,
+	std::string moviename, int count, MovieFileInputs::Snapshot snapshot)
+{
+	/* We remove old saves here while we have the correct movie name */
+	AutoSave::removeOldSaves(dir, moviename.c_str(), count);
+
+	std::string stagingdir = dir + "/autosave";
+	MovieFileInputs::saveSnapshot(snapshot, stagingdir + "/inputs");
+
+	if (MovieFile::archive(moviefile, stagingdir) < 0)
+		std::cerr << "Could not autosave movie to " << moviefile << std::endl;
+
+	autosave_running = false;
+}
+
 void AutoSave::update(Context* context, MovieFile& movie)
 {
 	/* Check if autosave is enabled */
@@ -43,6 +73,13 @@ void AutoSave::update(Context* context, MovieFile& movie)
 	if ((++nb_frame_advance > context->config.autosave_frames) &&
 		(difftime(time(nullptr), last_time_saved) > context->config.autosave_delay_sec))
 	{
+		/* Never wait for the previous autosave, try again on the next frame */
+		if (autosave_running)
+			return;
+
+		if (autosave_thread.joinable())
+			autosave_thread.join();
+
 		nb_frame_advance = 0;
 		time(&last_time_saved);
 
@@ -54,36 +91,52 @@ void AutoSave::update(Context* context, MovieFile& movie)
 			moviename.resize(moviename.size() - 4);
 		}
 
-		/* We remove old saves here while we have the correct movie name */
-		removeOldSaves(context, moviename.c_str());
-
-		moviename = context->config.tempmoviedir + "/" + moviename;
+		std::string moviefile = context->config.tempmoviedir + "/" + moviename;
 
 		char buf[32];
 		strftime(buf, 32, "_%Y%m%d-%H%M%S.ltm", localtime(&last_time_saved));
 
-		moviename += buf;
+		moviefile += buf;
+
+		std::cout << "Autosave movie to " << moviefile << std::endl;
+
+		/* The parameter files are small and read data owned by this thread,
+		 * so they are written here into a separate directory, to not interfere
+		 * with a regular movie save. The inputs snapshot only shares the input
+		 * chunks, so writing and compressing them is done in another thread. */
+		std::string stagingdir = context->config.tempmoviedir + "/autosave";
+		if (create_dir(stagingdir) < 0) {
+			std::cerr << "Could not create directory " << stagingdir << std::endl;
+			return;
+		}
 
-		std::cout << "Autosave movie to " << moviename << std::endl;
+		MovieFileInputs::Snapshot snapshot = movie.saveParameters(stagingdir);
 
-		/* Save the movie */
-		movie.saveMovie(moviename);
+		autosave_running = true;
+		autosave_thread = std::thread(autosaveWorker, context->config.tempmoviedir,
+			moviefile, moviename, context->config.autosave_count, std::move(snapshot));
 
 		movie.inputs->modifiedSinceLastAutoSave = false;
 	}
 }
 
-void AutoSave::removeOldSaves(Context* context, const char* moviename)
+void AutoSave::stop()
+{
+	if (autosave_thread.joinable())
+		autosave_thread.join();
+}
+
+void AutoSave::removeOldSaves(const std::string& dir, const char* moviename, int count)
 {
 	struct dirent **savefiles;
 
 	/* Scanning the directory of savefiles. We can't pass a filter function as
 	 * lambda because only non-capturing lambdas can be converted to function
 	 * pointers. We must filter when iterating. */
-	int nfiles = scandir(context->config.tempmoviedir.c_str(), &savefiles, nullptr, alphasort);
+	int nfiles = scandir(dir.c_str(), &savefiles, nullptr, alphasort);
 
 	if (nfiles < 0) {
-		std::cerr << "Could not scan directory " << context->config.tempmoviedir << std::endl;
+		std::cerr << "Could not scan directory " << dir << std::endl;
 		return;
 	}
 
@@ -95,9 +148,9 @@ void AutoSave::removeOldSaves(Context* context, const char* moviename)
 			(strncmp(file->d_name, moviename, strlen(moviename)) == 0)) {
 			/* We found a matching autosave */
 			matches++;
-			if (matches > context->config.autosave_count) {
+			if (matches > count) {
 				/* Removing the autosave */
-				std::string autosave = context->config.tempmoviedir;
+				std::string autosave = dir;
 				autosave += "/";
 				autosave += file->d_name;
 				std::cout << "Remove autosave movie " << autosave << std::endl;
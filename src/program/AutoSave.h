@@ -28,8 +28,14 @@ class MovieFile;
 struct Context;
 
 namespace AutoSave {
+    /* Check if an autosave must be performed, and start it in the background */
     void update(Context* context, MovieFile& movie);
-    void removeOldSaves(Context* context, const char* moviename);
+
+    /* Wait for the background autosave to finish */
+    void stop();
+
+    /* Remove the oldest autosaves of a movie, keeping the `count` most recent */
+    void removeOldSaves(const std::string& dir, const char* moviename, int count);
 }
 
 #endif
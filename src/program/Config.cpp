@@ -137,7 +137,9 @@ void Config::save(const std::string& gamepath) {
     settings.setValue("speed_divisor", sc.speed_divisor);
     settings.setValue("fastforward_mode", sc.fastforward_mode);
     settings.setValue("fastforward_render", sc.fastforward_render);
+    settings.setValue("fastforward_display_rate", sc.fastforward_display_rate);
     settings.setValue("logging_status", sc.logging_status);
+    settings.setValue("async_logging", sc.async_logging);
     settings.setValue("includeFlags", sc.includeFlags);
     settings.setValue("excludeFlags", sc.excludeFlags);
     settings.setValue("framerate_num", sc.initial_framerate_num);
@@ -152,6 +154,7 @@ void Config::save(const std::string& gamepath) {
     settings.setValue("osd_encode", sc.osd_encode);
     settings.setValue("prevent_savefiles", sc.prevent_savefiles);
     settings.setValue("recycle_threads", sc.recycle_threads);
+    settings.setValue("thread_pool_size", sc.thread_pool_size);
     settings.setValue("audio_bitdepth", sc.audio_bitdepth);
     settings.setValue("audio_channels", sc.audio_channels);
     settings.setValue("audio_frequency", sc.audio_frequency);
@@ -302,7 +305,9 @@ void Config::load(const std::string& gamepath) {
     sc.speed_divisor = settings.value("speed_divisor", sc.speed_divisor).toInt();
     sc.fastforward_mode = settings.value("fastforward_mode", sc.fastforward_mode).toInt();
     sc.fastforward_render = settings.value("fastforward_render", sc.fastforward_render).toInt();
+    sc.fastforward_display_rate = settings.value("fastforward_display_rate", sc.fastforward_display_rate).toInt();
     sc.logging_status = settings.value("logging_status", sc.logging_status).toInt();
+    sc.async_logging = settings.value("async_logging", sc.async_logging).toBool();
     sc.includeFlags = settings.value("includeFlags", sc.includeFlags).toInt();
     sc.excludeFlags = settings.value("excludeFlags", sc.excludeFlags).toInt();
     sc.initial_framerate_num = settings.value("framerate_num", sc.initial_framerate_num).toUInt();
@@ -317,6 +322,7 @@ void Config::load(const std::string& gamepath) {
     sc.osd_encode = settings.value("osd_encode", sc.osd_encode).toBool();
     sc.prevent_savefiles = settings.value("prevent_savefiles", sc.prevent_savefiles).toBool();
     sc.recycle_threads = settings.value("recycle_threads", sc.recycle_threads).toBool();
+    sc.thread_pool_size = settings.value("thread_pool_size", sc.thread_pool_size).toInt();
     sc.audio_bitdepth = settings.value("audio_bitdepth", sc.audio_bitdepth).toInt();
     sc.audio_channels = settings.value("audio_channels", sc.audio_channels).toInt();
     sc.audio_frequency = settings.value("audio_frequency", sc.audio_frequency).toInt();
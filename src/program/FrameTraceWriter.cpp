@@ -0,0 +1,189 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "FrameTraceWriter.h"
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <time.h>
+
+namespace FrameTraceWriter {
+
+static std::ofstream stream;
+static bool enabled = false;
+
+static int current_phase = -1;
+static uint64_t phase_start = 0;
+
+/* Segments of the current frame */
+static uint64_t segment_start[PROGRAM_PHASES];
+static uint64_t segment_duration[PROGRAM_PHASES];
+
+/* Statistics for the summary */
+static uint64_t frame_count = 0;
+static uint64_t first_frame_time = 0;
+static uint64_t last_frame_time = 0;
+static uint64_t program_total[PROGRAM_PHASES];
+static uint64_t game_total[FrameTrace::GAME_PHASES];
+static uint64_t game_record_count = 0;
+
+static const char* programPhaseName(int phase)
+{
+    static const char* names[PROGRAM_PHASES] = {"Wait game", "Start messages",
+        "Lua", "Events", "Inputs", "End messages"};
+    return names[phase];
+}
+
+static uint64_t now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Write a complete event, with timestamps in nanoseconds */
+static void writeEvent(int pid, const char* name, uint64_t start, uint64_t duration, uint64_t framecount)
+{
+    stream << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":1";
+    stream << ",\"ts\":" << start / 1000 << "." << std::setw(3) << std::setfill('0') << start % 1000;
+    stream << ",\"dur\":" << duration / 1000 << "." << std::setw(3) << std::setfill('0') << duration % 1000;
+    stream << ",\"args\":{\"frame\":" << framecount << "}},\n";
+}
+
+bool init()
+{
+    if (enabled)
+        return true;
+
+    const char* path = getenv("LIBTAS_FRAME_TRACE");
+    if (!path || !path[0])
+        return false;
+
+    stream.open(path, std::ofstream::trunc);
+    if (!stream) {
+        std::cerr << "Could not open frame trace file " << path << std::endl;
+        return false;
+    }
+
+    /* The closing bracket is optional in the JSON array format, so that the
+     * file remains valid if the program does not exit cleanly */
+    stream << "[\n";
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"libTAS\"}},\n";
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"game\"}},\n";
+    enabled = true;
+    return true;
+}
+
+void switchPhase(ProgramPhase phase)
+{
+    if (!enabled)
+        return;
+
+    uint64_t t = now();
+
+    if (current_phase >= 0) {
+        if (segment_duration[current_phase] == 0)
+            segment_start[current_phase] = phase_start;
+        segment_duration[current_phase] += t - phase_start;
+    }
+
+    current_phase = phase;
+    phase_start = t;
+}
+
+void endFrame(uint64_t framecount)
+{
+    if (!enabled)
+        return;
+
+    switchPhase(PROGRAM_WAIT);
+
+    for (int p = 0; p < PROGRAM_PHASES; p++) {
+        if (segment_duration[p] == 0)
+            continue;
+        writeEvent(1, programPhaseName(p), segment_start[p], segment_duration[p], framecount);
+        program_total[p] += segment_duration[p];
+        segment_duration[p] = 0;
+    }
+
+    if (frame_count == 0)
+        first_frame_time = phase_start;
+    last_frame_time = phase_start;
+    frame_count++;
+}
+
+void addGameRecord(const FrameTrace::Record& record)
+{
+    if (!enabled)
+        return;
+
+    uint32_t count = record.segment_count;
+    if (count > FrameTrace::MAX_SEGMENTS)
+        count = FrameTrace::MAX_SEGMENTS;
+
+    for (uint32_t s = 0; s < count; s++) {
+        const FrameTrace::Segment& segment = record.segments[s];
+        writeEvent(2, FrameTrace::gamePhaseName(segment.phase), segment.start, segment.duration, record.framecount);
+        if (segment.phase < FrameTrace::GAME_PHASES)
+            game_total[segment.phase] += segment.duration;
+    }
+    game_record_count++;
+}
+
+void stop()
+{
+    if (!enabled)
+        return;
+
+    stream.flush();
+
+    if (frame_count > 1) {
+        double seconds = (last_frame_time - first_frame_time) / 1000000000.0;
+        std::cout << "Frame trace: " << frame_count << " frames in " << seconds << " s, "
+                  << (frame_count - 1) / seconds << " fps" << std::endl;
+
+        std::cout << "  Program phases (average us per frame):" << std::endl;
+        for (int p = 0; p < PROGRAM_PHASES; p++)
+            std::cout << "    " << std::left << std::setw(16) << std::setfill(' ') << programPhaseName(p)
+                      << std::right << program_total[p] / frame_count / 1000.0 << std::endl;
+
+        if (game_record_count > 0) {
+            std::cout << "  Game phases (average us per frame):" << std::endl;
+            for (int p = 0; p < FrameTrace::GAME_PHASES; p++)
+                std::cout << "    " << std::left << std::setw(16) << std::setfill(' ') << FrameTrace::gamePhaseName(p)
+                          << std::right << game_total[p] / game_record_count / 1000.0 << std::endl;
+        }
+    }
+
+    /* Reset statistics for the next execution */
+    frame_count = 0;
+    game_record_count = 0;
+    current_phase = -1;
+    for (int p = 0; p < PROGRAM_PHASES; p++) {
+        program_total[p] = 0;
+        segment_duration[p] = 0;
+    }
+    for (int p = 0; p < FrameTrace::GAME_PHASES; p++)
+        game_total[p] = 0;
+}
+
+}
@@ -0,0 +1,61 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBTAS_FRAMETRACEWRITER_H_INCLUDED
+#define LIBTAS_FRAMETRACEWRITER_H_INCLUDED
+
+#include "../shared/FrameTrace.h"
+
+#include <cstdint>
+
+/* Timeline of the phases of each frame on both the program and the game
+ * side. It is enabled when the LIBTAS_FRAME_TRACE environment variable names
+ * a file, which is written in the Chrome trace event format (it can be opened
+ * with Perfetto or chrome://tracing). A summary of the average duration of
+ * each phase is printed when the game exits. */
+namespace FrameTraceWriter {
+
+    enum ProgramPhase {
+        PROGRAM_WAIT, // waiting for the game to reach the frame boundary
+        PROGRAM_START_MESSAGES, // startFrameMessages() after the game reached the frame boundary
+        PROGRAM_LUA, // lua onFrame callbacks and input search
+        PROGRAM_EVENTS, // hotkeys and pause
+        PROGRAM_INPUTS, // processInputs()
+        PROGRAM_END_MESSAGES, // endFrameMessages()
+        PROGRAM_PHASES,
+    };
+
+    /* Open the trace file if enabled. Returns if frame tracing is enabled */
+    bool init();
+
+    /* Close the current phase and start a new one */
+    void switchPhase(ProgramPhase phase);
+
+    /* Write the program phases of the frame and start waiting for the next one */
+    void endFrame(uint64_t framecount);
+
+    /* Write the game phases received from the game */
+    void addGameRecord(const FrameTrace::Record& record);
+
+    /* Print the summary of the game execution and flush the trace file */
+    void stop();
+}
+
+#endif
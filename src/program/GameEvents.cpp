@@ -21,6 +21,7 @@
 #include "GameEvents.h"
 #include "SaveState.h"
 #include "SaveStateList.h"
+#include "SaveStateStats.h"
 #include "movie/MovieFile.h"
 
 #include "../shared/sockethelpers.h"
@@ -135,32 +136,8 @@ bool GameEvents::processEvent(GameEvents::EventType type, const HotKey &hk)
         case HOTKEY_SAVESTATE8:
         case HOTKEY_SAVESTATE9:
         case HOTKEY_SAVESTATE_BACKTRACK:
-        {
-            /* Perform a savestate:
-             * - save the moviefile if we are recording
-             * - tell the game to save its state
-             */
-
-            /* Saving is not allowed if currently encoding */
-            if (context->config.sc.av_dumping) {
-                emit alertToShow(QString("Saving is not allowed when in the middle of video encoding"));
-                return false;
-            }
-
-            /* Slot number */
-            int statei = hk.type - HOTKEY_SAVESTATE1 + 1;
-
-            /* Perform savestate */
-            int message = SaveStateList::save(statei, context, *movie);
-
-            /* Checking that saving succeeded */
-            if (message == MSGB_SAVING_SUCCEEDED) {
-                didASavestate = true;
-                emit savestatePerformed(statei, context->framecount);
-            }
-
+            saveState(hk.type - HOTKEY_SAVESTATE1 + 1);
             return false;
-        }
 
         case HOTKEY_LOADSTATE1:
         case HOTKEY_LOADSTATE2:
@@ -182,119 +159,14 @@ bool GameEvents::processEvent(GameEvents::EventType type, const HotKey &hk)
         case HOTKEY_LOADBRANCH8:
         case HOTKEY_LOADBRANCH9:
         case HOTKEY_LOADBRANCH_BACKTRACK:
-
-            /* Load a savestate:
-             * - check for an existing savestate in the slot
-             * - if in read-only move, we must check that the movie
-                 associated with the savestate must be a prefix of the
-                 current movie
-             * - tell the game to load its state
-             * - if loading succeeded:
-             * -- send the shared config
-             * -- increment the rerecord count
-             * -- receive the frame count and the current time
-             */
         {
-
-            /* Loading is not allowed if currently encoding */
-            if (context->config.sc.av_dumping) {
-                emit alertToShow(QString("Loading is not allowed when in the middle of video encoding"));
-                return false;
-            }
-
             /* Loading branch? */
             bool load_branch = (hk.type >= HOTKEY_LOADBRANCH1) && (hk.type <= HOTKEY_LOADBRANCH_BACKTRACK);
 
-            /* Check if input editor is visible */
-            bool inputEditor = false;
-            emit isInputEditorVisible(inputEditor);
-
             /* Slot number */
             int statei = hk.type - (load_branch?HOTKEY_LOADBRANCH1:HOTKEY_LOADSTATE1) + 1;
 
-            /* Perform state loading */
-            int error = SaveStateList::load(statei, context, *movie, load_branch, inputEditor);
-
-            /* Handle errors */
-            if (error == SaveState::EINVALID) {
-                if (!(context->config.sc.osd))
-                    emit alertToShow(QString("State invalid because new threads were created"));
-                return false;
-            }
-
-            if (error == SaveState::ENOSTATEMOVIEPREFIX) {
-                /* Ask the user if they want to load the movie, and get the answer.
-                 * Prompting a alert window must be done by the UI thread, so we are
-                 * using std::future/std::promise mechanism.
-                 */
-                std::promise<bool> answer;
-                std::future<bool> future = answer.get_future();
-                emit askToShow(QString("There is a savestate in that slot from a previous game iteration. Do you want to load the associated movie?"), &answer);
-
-                if (! future.get()) {
-                    /* User answered no */
-                    return false;
-                }
-
-                /* Loading the movie */
-                emit inputsToBeChanged();
-                movie->loadSavestateMovie(SaveStateList::get(statei).getMoviePath());
-                emit inputsChanged();
-
-                /* Return if we already are on the correct frame */
-                if (context->framecount == movie->header->savestate_framecount)
-                    return false;
-
-                /* Fast-forward to savestate frame */
-                context->config.sc.recording = SharedConfig::RECORDING_READ;
-                context->config.sc.movie_framecount = movie->inputs->nbFrames();
-                context->seek_frame = movie->header->savestate_framecount;
-                context->config.sc.running = true;
-                context->config.sc_modified = true;
-
-                emit sharedConfigChanged();
-
-                return false;
-            }
-
-            if (error == SaveState::ENOSTATE) {
-                if (!(context->config.sc.osd))
-                    emit alertToShow(QString("There is no savestate to load in this slot"));
-                return false;
-            }
-
-            if (error == SaveState::ENOMOVIE) {
-                emit alertToShow(QString("Could not load the moviefile associated with the savestate"));
-                return false;                
-            }
-
-            if (error == SaveState::EINPUTMISMATCH) {
-                if (!(context->config.sc.osd)) {
-                    emit alertToShow(QString("Trying to load a state in read-only but the inputs mismatch"));
-                }
-                return false;                
-            }
-
-            emit inputsToBeChanged();
-
-            /* Processing after state loading */
-            int message = SaveStateList::postLoad(statei, context, *movie, load_branch, inputEditor);
-
-            /* Handle errors and return values */
-            if (message == SaveState::ENOLOAD) {
-                if (!context->config.sc.opengl_soft) {
-                    emit alertToShow(QString("Crash after loading the savestate. Savestates are unstable unless you check Video>Force software rendering"));
-                }
-
-                return false;
-            }
-
-            if (message == MSGB_LOADING_SUCCEEDED) {
-                emit savestatePerformed(statei, 0);
-            }
-
-            emit inputsChanged();
-
+            loadState(statei, load_branch, true);
             return false;
         }
 
@@ -419,3 +291,145 @@ int GameEvents::handleEvent()
 
     return flags;
 }
+
+int GameEvents::saveState(int slot)
+{
+    /* Perform a savestate:
+     * - save the moviefile if we are recording
+     * - tell the game to save its state
+     */
+
+    /* Saving is not allowed if currently encoding */
+    if (context->config.sc.av_dumping) {
+        emit alertToShow(QString("Saving is not allowed when in the middle of video encoding"));
+        return SaveState::EENCODING;
+    }
+
+    /* Perform savestate */
+    uint64_t start = SaveStateStats::now();
+    int message = SaveStateList::save(slot, context, *movie);
+
+    /* Checking that saving succeeded */
+    if (message != MSGB_SAVING_SUCCEEDED)
+        return (message < 0) ? message : -1;
+
+    SaveStateStats::record(context, "save", slot, start);
+    didASavestate = true;
+    emit savestatePerformed(slot, context->framecount);
+    return 0;
+}
+
+int GameEvents::loadState(int slot, bool branch, bool ask)
+{
+    /* Load a savestate:
+     * - check for an existing savestate in the slot
+     * - if in read-only move, we must check that the movie
+         associated with the savestate must be a prefix of the
+         current movie
+     * - tell the game to load its state
+     * - if loading succeeded:
+     * -- send the shared config
+     * -- increment the rerecord count
+     * -- receive the frame count and the current time
+     */
+
+    /* Loading is not allowed if currently encoding */
+    if (context->config.sc.av_dumping) {
+        emit alertToShow(QString("Loading is not allowed when in the middle of video encoding"));
+        return SaveState::EENCODING;
+    }
+
+    /* Check if input editor is visible */
+    bool inputEditor = false;
+    emit isInputEditorVisible(inputEditor);
+
+    /* Perform state loading */
+    uint64_t start = SaveStateStats::now();
+    int error = SaveStateList::load(slot, context, *movie, branch, inputEditor);
+
+    /* Handle errors */
+    if (error == SaveState::EINVALID) {
+        if (!(context->config.sc.osd))
+            emit alertToShow(QString("State invalid because new threads were created"));
+        return error;
+    }
+
+    if (error == SaveState::ENOSTATEMOVIEPREFIX) {
+        if (!ask)
+            return error;
+
+        /* Ask the user if they want to load the movie, and get the answer.
+         * Prompting a alert window must be done by the UI thread, so we are
+         * using std::future/std::promise mechanism.
+         */
+        std::promise<bool> answer;
+        std::future<bool> future = answer.get_future();
+        emit askToShow(QString("There is a savestate in that slot from a previous game iteration. Do you want to load the associated movie?"), &answer);
+
+        if (! future.get()) {
+            /* User answered no */
+            return error;
+        }
+
+        /* Loading the movie */
+        emit inputsToBeChanged();
+        movie->loadSavestateMovie(SaveStateList::get(slot).getMoviePath());
+        emit inputsChanged();
+
+        /* Return if we already are on the correct frame */
+        if (context->framecount == movie->header->savestate_framecount)
+            return error;
+
+        /* Fast-forward to savestate frame */
+        context->config.sc.recording = SharedConfig::RECORDING_READ;
+        context->config.sc.movie_framecount = movie->inputs->nbFrames();
+        context->seek_frame = movie->header->savestate_framecount;
+        context->config.sc.running = true;
+        context->config.sc_modified = true;
+
+        emit sharedConfigChanged();
+
+        return error;
+    }
+
+    if (error == SaveState::ENOSTATE) {
+        if (!(context->config.sc.osd))
+            emit alertToShow(QString("There is no savestate to load in this slot"));
+        return error;
+    }
+
+    if (error == SaveState::ENOMOVIE) {
+        emit alertToShow(QString("Could not load the moviefile associated with the savestate"));
+        return error;
+    }
+
+    if (error == SaveState::EINPUTMISMATCH) {
+        if (!(context->config.sc.osd)) {
+            emit alertToShow(QString("Trying to load a state in read-only but the inputs mismatch"));
+        }
+        return error;
+    }
+
+    emit inputsToBeChanged();
+
+    /* Processing after state loading */
+    int message = SaveStateList::postLoad(slot, context, *movie, branch, inputEditor);
+
+    /* Handle errors and return values */
+    if (message == SaveState::ENOLOAD) {
+        if (!context->config.sc.opengl_soft) {
+            emit alertToShow(QString("Crash after loading the savestate. Savestates are unstable unless you check Video>Force software rendering"));
+        }
+
+        return message;
+    }
+
+    if (message == MSGB_LOADING_SUCCEEDED) {
+        SaveStateStats::record(context, "load", slot, start);
+        emit savestatePerformed(slot, 0);
+    }
+
+    emit inputsChanged();
+
+    return (message == MSGB_LOADING_SUCCEEDED) ? 0 : message;
+}
@@ -57,6 +57,15 @@ public:
     /* Indicate if at least one savestate was performed, for backtrack savestate */
     bool didASavestate = false;
 
+    /* Save a state in a slot. Returns 0 on success, SaveState::EENCODING if
+     * saving is not allowed, or the negative error code sent by the game */
+    int saveState(int slot);
+
+    /* Load a state from a slot, or from a branch. If `ask` is set, the user
+     * can choose to load the movie of a state from a previous game execution.
+     * Returns 0 on success, or a negative error code from SaveState::Error */
+    int loadState(int slot, bool branch, bool ask);
+
 protected:
     Context* context;
     MovieFile* movie;
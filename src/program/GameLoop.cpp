@@ -34,10 +34,14 @@
 #include "Context.h"
 #include "utils.h"
 #include "AutoSave.h"
+#include "FrameTraceWriter.h"
+#include "InputSearch.h"
+#include "LogReader.h"
 #include "SaveStateList.h"
 #include "lua/Input.h"
 #include "lua/Callbacks.h"
 #include "lua/NamedLuaFunction.h"
+#include "lua/Savestate.h"
 #include "ramsearch/MemAccess.h"
 #include "ramsearch/BaseAddresses.h"
 #include "ui/InputEditorView.h"
@@ -76,6 +80,8 @@ void GameLoop::start()
 
     Lua::Callbacks::call(Lua::NamedLuaFunction::CallbackStartup);
 
+    FrameTraceWriter::switchPhase(FrameTraceWriter::PROGRAM_WAIT);
+
     while (1)
     {
         bool exitMsg = startFrameMessages();
@@ -86,10 +92,29 @@ void GameLoop::start()
 
         emit uiChanged();
 
+        FrameTraceWriter::switchPhase(FrameTraceWriter::PROGRAM_LUA);
+        /* Lua scripts can perform savestates inside onFrame() */
+        Lua::Savestate::registerGameEvents(gameEvents);
         Lua::Callbacks::call(Lua::NamedLuaFunction::CallbackFrame);
+        Lua::Savestate::registerGameEvents(nullptr);
+
+        /* Let the input search choose the next state to load or save */
+        if (InputSearch::onFrame(context, movie)) {
+            if (!context->interactive) {
+                context->status = Context::QUITTING;
+                emit statusChanged(Context::QUITTING);
+            } else {
+                /* Pause and disable fast-forward */
+                context->config.sc.running = false;
+                context->config.sc.fastforward = false;
+                context->config.sc_modified = true;
+                emit sharedConfigChanged();
+            }
+        }
 
         /* We are at a frame boundary */
         /* If we did not yet receive the game window id, just make the game running */
+        FrameTraceWriter::switchPhase(FrameTraceWriter::PROGRAM_EVENTS);
         bool endInnerLoop = false;
         if (context->game_window ) do {
 
@@ -111,12 +136,16 @@ void GameLoop::start()
                 (context->status == Context::QUITTING);
 
             if (!endInnerLoop) {
+                /* Persist input editor changes while paused */
+                movie.flushJournal();
                 sleepSendPreview();
             }
         } while (!endInnerLoop);
 
+        FrameTraceWriter::switchPhase(FrameTraceWriter::PROGRAM_INPUTS);
         AllInputs ai;
         processInputs(ai);
+        movie.flushJournal();
 
         /* Set the status to restart */
         if (ai.misc && (ai.misc->flags & (1 << SingleInput::FLAG_RESTART))) {
@@ -166,7 +195,9 @@ void GameLoop::start()
             emit sharedConfigChanged();
         }
 
+        FrameTraceWriter::switchPhase(FrameTraceWriter::PROGRAM_END_MESSAGES);
         endFrameMessages(ai);
+        FrameTraceWriter::endFrame(context->framecount);
 
         if (shouldQuit) {
             context->status = Context::QUITTING;
@@ -210,7 +241,7 @@ void GameLoop::init()
     /* Remove the file socket */
     int err = removeSocket();
     if (err != 0)
-        emit alertToShow(QString("Could not remove socket file /tmp/libTAS.socket: %2").arg(strerror(err)));
+        emit alertToShow(QString("Could not remove socket file %1: %2").arg(getSocketPath()).arg(strerror(err)));
 
     /* Clear addresses of loaded files */
     BaseAddresses::clear();
@@ -232,13 +263,20 @@ void GameLoop::init()
         /* Opening a movie, which imports the inputs and parameters if in read mode,
          * or prepare a movie if in write mode.
          */
+        bool from_moviefile = false;
         if (context->config.sc.recording == SharedConfig::RECORDING_READ) {
             int ret = movie.loadMovie();
-            if (ret < 0) {
+            if ((ret == MovieFile::ENOMOVIE) && movie.hasJournal()) {
+                /* The movie was never saved, but an interrupted recording
+                 * left a journal of its inputs, which is recovered below */
+                movie.clear();
+            }
+            else if (ret < 0) {
                 emit alertToShow(MovieFile::errorString(ret));
                 context->config.sc.recording = SharedConfig::NO_RECORDING;
             }
             else {
+                from_moviefile = true;
                 /* Update the UI accordingly */
                 emit configChanged();
             }
@@ -251,6 +289,12 @@ void GameLoop::init()
         else {
             movie.clear();
         }
+
+        /* Journal the input changes of the recording, to recover them after a crash */
+        if ((context->config.sc.recording != SharedConfig::NO_RECORDING) &&
+            !context->config.moviefile.empty()) {
+            movie.openJournal(from_moviefile, context->config.sc.recording == SharedConfig::RECORDING_READ);
+        }
     }
 
     /* Detect common game engines and load some known settings. This is done
@@ -289,6 +333,9 @@ void GameLoop::init()
         context->new_realtime_nsec = context->current_realtime_nsec;
     }
 
+    /* Enable frame tracing if requested */
+    context->config.sc.frame_trace = FrameTraceWriter::init();
+
     /* If auto-restart is set, write back savefiles on game exit */
     context->config.sc.write_savefiles_on_exit =
         (context->config.sc.recording != SharedConfig::NO_RECORDING) &&
@@ -460,6 +507,7 @@ bool GameLoop::startFrameMessages()
     
     /* Wait for frame boundary */
     int message = receiveMessage();
+    FrameTraceWriter::switchPhase(FrameTraceWriter::PROGRAM_START_MESSAGES);
 
     while (message != MSGB_START_FRAMEBOUNDARY) {
         GameInfo game_info;
@@ -484,6 +532,22 @@ bool GameLoop::startFrameMessages()
             context->config.sc_modified = true;
             emit sharedConfigChanged();
             break;
+        case MSGB_LOG_RING:
+        {
+            /* Get the shared memory object of asynchronous logging */
+            int log_fd;
+            receiveData(&log_fd, sizeof(int));
+            LogReader::init(context->game_pid, log_fd,
+                context->config.sc.logging_status == SharedConfig::NO_LOGGING);
+            break;
+        }
+        case MSGB_FRAME_TRACE:
+        {
+            FrameTrace::Record record;
+            receiveData(&record, sizeof(FrameTrace::Record));
+            FrameTraceWriter::addGameRecord(record);
+            break;
+        }
         case MSGB_FRAMECOUNT_TIME:
             receiveData(&context->framecount, sizeof(uint64_t));
             receiveData(&context->current_time_sec, sizeof(uint64_t));
@@ -576,8 +640,10 @@ bool GameLoop::startFrameMessages()
             receiveData(&type, sizeof(int));
             uint64_t hash;
             receiveData(&hash, sizeof(uint64_t));
+            unsigned int count;
+            receiveData(&count, sizeof(unsigned int));
             std::string trace = receiveString();
-            emit getTimeTrace(type, static_cast<unsigned long long>(hash), trace);
+            emit getTimeTrace(type, static_cast<unsigned long long>(hash), count, trace);
         }
         break;
         case MSGB_NONDRAW_FRAME:
@@ -757,6 +823,9 @@ void GameLoop::processInputs(AllInputs &ai)
             Lua::Input::registerInputs(&ai);
             Lua::Callbacks::call(Lua::NamedLuaFunction::CallbackInput);
 
+            /* The input search overrides inputs during its runs */
+            InputSearch::onInput(context, ai);
+
             if (context->config.sc.recording == SharedConfig::RECORDING_WRITE) {
                 /* If the input editor is visible, we should keep future inputs.
                  * If not, we truncate inputs if necessary.
@@ -920,6 +989,15 @@ void GameLoop::endFrameMessages(AllInputs &ai)
 
 void GameLoop::loopExit()
 {
+    /* Print the remaining log messages while the game memory is readable */
+    LogReader::stop();
+
+    /* Print the frame timing summary */
+    FrameTraceWriter::stop();
+
+    /* Wait for the autosave in progress */
+    AutoSave::stop();
+
     /* Unvalidate the game pid */
     context->game_pid = 0;
 
@@ -100,7 +100,7 @@ signals:
     
     void getMarkerText(std::string &text);
 
-    void getTimeTrace(int type, unsigned long long hash, std::string stacktrace);
+    void getTimeTrace(int type, unsigned long long hash, unsigned int count, std::string stacktrace);
     
     /* Savestates have been invalidated by thread change */
     void invalidateSavestates();
@@ -0,0 +1,480 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "InputSearch.h"
+
+#include "Context.h"
+#include "SaveState.h"
+#include "SaveStateList.h"
+#include "movie/MovieFile.h"
+#include "movie/MovieFileInputs.h"
+#include "ramsearch/MemAccess.h"
+#include "../shared/inputs/AllInputs.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+#include <stdint.h>
+
+namespace InputSearch {
+
+/* A value in game memory that contributes to the fitness */
+struct Watch {
+    uintptr_t address;
+    int size;
+    int type;
+    double weight;
+};
+
+enum WatchType {
+    WATCH_INT8,
+    WATCH_UINT8,
+    WATCH_INT16,
+    WATCH_UINT16,
+    WATCH_INT32,
+    WATCH_UINT32,
+    WATCH_INT64,
+    WATCH_UINT64,
+    WATCH_FLOAT,
+    WATCH_DOUBLE,
+};
+
+/* An action, which is a set of inputs held during `frames` frames */
+struct Action {
+    std::string name;
+    std::string line;
+    AllInputs ai;
+};
+
+/* A sequence of actions and its fitness */
+struct Branch {
+    std::vector<int> actions;
+    double score;
+};
+
+/* Type of the current run, which loads a state and plays actions */
+enum RunType {
+    RUN_REPLAY, // Replay a branch from the base state and save it in the work slot
+    RUN_TRY, // Try one action and score the result
+    RUN_FINAL, // Replay the best branch when the search is finished
+};
+
+enum Phase {
+    PHASE_INACTIVE,
+    PHASE_WAIT_START,
+    PHASE_RUNNING,
+    PHASE_DONE,
+};
+
+/* Search parameters */
+static int base_slot = 1;
+static int work_slot = 9;
+static uint64_t start_frame = 0;
+static bool has_start_frame = false;
+static int frames = 1;
+static int depth = 1;
+static size_t width = 1;
+static int search_part = 0;
+static int search_nbparts = 1;
+static std::vector<Action> actions;
+static std::vector<Watch> watches;
+static std::string output_file;
+
+static Phase phase = PHASE_INACTIVE;
+
+/* Current run */
+static RunType run_type;
+static int run_slot;
+static std::vector<int> run_actions;
+static int run_frame;
+static int run_length;
+
+/* Search state */
+static int step;
+static std::vector<Branch> beam;
+static std::vector<Branch> candidates;
+static size_t beam_index;
+static size_t action_index;
+static bool need_replay;
+static int nb_tries;
+
+static bool parseWatchType(const std::string& str, Watch& watch)
+{
+    static const char* names[] = {"int8", "uint8", "int16", "uint16", "int32", "uint32", "int64", "uint64", "float", "double"};
+    static const int sizes[] = {1, 1, 2, 2, 4, 4, 8, 8, 4, 8};
+
+    for (int t = WATCH_INT8; t <= WATCH_DOUBLE; t++) {
+        if (str == names[t]) {
+            watch.type = t;
+            watch.size = sizes[t];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool load(const std::string& file, int part, int nbparts)
+{
+    std::ifstream stream(file);
+    if (!stream) {
+        std::cerr << "Could not open search file " << file << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int linenum = 0;
+    while (std::getline(stream, line)) {
+        linenum++;
+
+        /* Skip comments and empty lines */
+        size_t first = line.find_first_not_of(" \t");
+        if ((first == std::string::npos) || (line[first] == '#'))
+            continue;
+
+        std::istringstream iss(line);
+        std::string key;
+        iss >> key;
+
+        bool ok = true;
+        if (key == "base") {
+            ok = static_cast<bool>(iss >> base_slot) && (base_slot >= 1) && (base_slot <= 9);
+        }
+        else if (key == "work") {
+            ok = static_cast<bool>(iss >> work_slot) && (work_slot >= 1) && (work_slot <= 9);
+        }
+        else if (key == "start") {
+            ok = static_cast<bool>(iss >> start_frame);
+            has_start_frame = true;
+        }
+        else if (key == "frames") {
+            ok = static_cast<bool>(iss >> frames) && (frames > 0);
+        }
+        else if (key == "depth") {
+            ok = static_cast<bool>(iss >> depth) && (depth > 0);
+        }
+        else if (key == "width") {
+            ok = static_cast<bool>(iss >> width) && (width > 0);
+        }
+        else if (key == "action") {
+            Action action;
+            ok = static_cast<bool>(iss >> action.name);
+            std::getline(iss, action.line);
+            size_t pos = action.line.find('|');
+            if (pos == std::string::npos)
+                ok = false;
+            else
+                action.line = action.line.substr(pos);
+            actions.push_back(std::move(action));
+        }
+        else if (key == "watch") {
+            Watch watch;
+            std::string address, type;
+            ok = static_cast<bool>(iss >> watch.weight >> address >> type);
+            if (ok) {
+                watch.address = std::strtoull(address.c_str(), nullptr, 0);
+                ok = parseWatchType(type, watch);
+            }
+            watches.push_back(watch);
+        }
+        else if (key == "output") {
+            ok = static_cast<bool>(iss >> output_file);
+        }
+        else {
+            ok = false;
+        }
+
+        if (!ok) {
+            std::cerr << "Search file " << file << ", line " << linenum << ": could not parse '" << line << "'" << std::endl;
+            return false;
+        }
+    }
+
+    if (actions.empty()) {
+        std::cerr << "Search file " << file << " does not define any action" << std::endl;
+        return false;
+    }
+
+    if (watches.empty()) {
+        std::cerr << "Search file " << file << " does not define any watch" << std::endl;
+        return false;
+    }
+
+    if (base_slot == work_slot) {
+        std::cerr << "Search file " << file << " uses the same slot for base and work states" << std::endl;
+        return false;
+    }
+
+    search_part = part;
+    search_nbparts = nbparts;
+    phase = PHASE_WAIT_START;
+    return true;
+}
+
+bool isActive()
+{
+    return (phase == PHASE_WAIT_START) || (phase == PHASE_RUNNING);
+}
+
+/* Compute the fitness of the current game state, reading all watches at once */
+static double computeScore()
+{
+    std::vector<uint64_t> values(watches.size(), 0);
+    std::vector<void*> locals(watches.size());
+    std::vector<void*> remotes(watches.size());
+    std::vector<size_t> sizes(watches.size());
+    size_t total = 0;
+
+    for (size_t i = 0; i < watches.size(); i++) {
+        locals[i] = &values[i];
+        remotes[i] = reinterpret_cast<void*>(watches[i].address);
+        sizes[i] = watches[i].size;
+        total += watches[i].size;
+    }
+
+    if (MemAccess::readBatch(locals.data(), remotes.data(), sizes.data(), watches.size()) != total)
+        return -std::numeric_limits<double>::infinity();
+
+    double score = 0;
+    for (size_t i = 0; i < watches.size(); i++) {
+        const void* v = &values[i];
+        double value = 0;
+        switch (watches[i].type) {
+            case WATCH_INT8: value = *static_cast<const int8_t*>(v); break;
+            case WATCH_UINT8: value = *static_cast<const uint8_t*>(v); break;
+            case WATCH_INT16: value = *static_cast<const int16_t*>(v); break;
+            case WATCH_UINT16: value = *static_cast<const uint16_t*>(v); break;
+            case WATCH_INT32: value = *static_cast<const int32_t*>(v); break;
+            case WATCH_UINT32: value = *static_cast<const uint32_t*>(v); break;
+            case WATCH_INT64: value = *static_cast<const int64_t*>(v); break;
+            case WATCH_UINT64: value = *static_cast<const uint64_t*>(v); break;
+            case WATCH_FLOAT: value = *static_cast<const float*>(v); break;
+            case WATCH_DOUBLE: value = *static_cast<const double*>(v); break;
+        }
+        score += watches[i].weight * value;
+    }
+
+    if (std::isnan(score))
+        return -std::numeric_limits<double>::infinity();
+    return score;
+}
+
+/* Load a state and prepare to play a list of actions */
+static void startRun(Context* context, RunType type, int slot, const std::vector<int>& list)
+{
+    context->hotkey_pressed_queue.push(HOTKEY_LOADSTATE1 + (slot-1));
+    run_type = type;
+    run_slot = slot;
+    run_actions = list;
+    run_frame = 0;
+    run_length = list.size() * frames;
+}
+
+/* Is the action tried by this instance */
+static bool isActionAllowed(size_t action)
+{
+    /* Instances only split the search on the first step */
+    if (step > 0)
+        return true;
+    return (static_cast<int>(action % search_nbparts) == search_part);
+}
+
+/* Write the best branch to the output file */
+static void writeResult(MovieFile& movie, const Branch& best)
+{
+    std::cout << "Search finished after " << nb_tries << " tries, best score " << best.score << ":";
+    for (int a : best.actions)
+        std::cout << " " << actions[a].name;
+    std::cout << std::endl;
+
+    if (output_file.empty())
+        return;
+
+    std::ofstream stream(output_file, std::ofstream::trunc);
+    if (!stream) {
+        std::cerr << "Could not write search output " << output_file << std::endl;
+        return;
+    }
+
+    stream << "# score " << best.score << std::endl;
+    stream << "# actions";
+    for (int a : best.actions)
+        stream << " " << actions[a].name;
+    stream << std::endl;
+
+    /* Inputs in the movie format, one line per frame */
+    for (int a : best.actions)
+        for (int f = 0; f < frames; f++)
+            movie.inputs->writeFrame(stream, actions[a].ai);
+}
+
+/* Choose and start the next run. Returns true if the search is finished */
+static bool nextRun(Context* context, MovieFile& movie)
+{
+    while (true) {
+        if (beam_index >= beam.size()) {
+            /* All branches were expanded, keep the best ones */
+            std::stable_sort(candidates.begin(), candidates.end(),
+                [](const Branch& a, const Branch& b) { return a.score > b.score; });
+            if (candidates.size() > width)
+                candidates.resize(width);
+            beam.swap(candidates);
+            candidates.clear();
+            step++;
+
+            if (beam.empty()) {
+                std::cerr << "Search has no branch left" << std::endl;
+                phase = PHASE_DONE;
+                return true;
+            }
+
+            std::cout << "Search step " << step << "/" << depth << ", best score " << beam[0].score << std::endl;
+
+            if (step == depth) {
+                /* Replay the best branch, so that the movie contains it */
+                writeResult(movie, beam[0]);
+                startRun(context, RUN_FINAL, base_slot, beam[0].actions);
+                return false;
+            }
+
+            beam_index = 0;
+            action_index = 0;
+            need_replay = true;
+        }
+
+        const Branch& branch = beam[beam_index];
+
+        /* Bring the branch into the work slot */
+        if (need_replay) {
+            need_replay = false;
+            if (!branch.actions.empty()) {
+                startRun(context, RUN_REPLAY, base_slot, branch.actions);
+                return false;
+            }
+        }
+
+        while ((action_index < actions.size()) && !isActionAllowed(action_index))
+            action_index++;
+
+        if (action_index < actions.size()) {
+            std::vector<int> list(1, action_index++);
+            startRun(context, RUN_TRY, branch.actions.empty() ? base_slot : work_slot, list);
+            return false;
+        }
+
+        beam_index++;
+        action_index = 0;
+        need_replay = true;
+    }
+}
+
+bool onFrame(Context* context, MovieFile& movie)
+{
+    if (!isActive())
+        return false;
+
+    /* Hotkeys are only processed once the game window is known */
+    if (!context->game_window)
+        return false;
+
+    if (phase == PHASE_WAIT_START) {
+        if (has_start_frame && (context->framecount < start_frame))
+            return false;
+
+        /* Parse the action inputs */
+        for (Action& action : actions) {
+            if (movie.inputs->readFrame(action.line, action.ai) < 0) {
+                std::cerr << "Could not parse inputs of action " << action.name << std::endl;
+                phase = PHASE_DONE;
+                return true;
+            }
+        }
+
+        /* Tries are recorded, and run as fast as possible */
+        context->config.sc.recording = SharedConfig::RECORDING_WRITE;
+        context->config.sc.running = true;
+        context->config.sc.fastforward = true;
+        context->config.sc_modified = true;
+
+        if (has_start_frame)
+            context->hotkey_pressed_queue.push(HOTKEY_SAVESTATE1 + (base_slot-1));
+
+        step = 0;
+        nb_tries = 0;
+        beam.assign(1, Branch{std::vector<int>(), 0});
+        candidates.clear();
+        beam_index = 0;
+        action_index = 0;
+        need_replay = true;
+        phase = PHASE_RUNNING;
+
+        return nextRun(context, movie);
+    }
+
+    /* Still playing the current run */
+    if (run_frame < run_length)
+        return false;
+
+    switch (run_type) {
+        case RUN_REPLAY:
+            context->hotkey_pressed_queue.push(HOTKEY_SAVESTATE1 + (work_slot-1));
+            break;
+        case RUN_TRY:
+        {
+            Branch branch;
+            branch.actions = beam[beam_index].actions;
+            branch.actions.push_back(run_actions[0]);
+            branch.score = computeScore();
+            candidates.push_back(std::move(branch));
+            nb_tries++;
+            break;
+        }
+        case RUN_FINAL:
+            phase = PHASE_DONE;
+            return true;
+    }
+
+    return nextRun(context, movie);
+}
+
+void onInput(Context* context, AllInputs& ai)
+{
+    if (phase != PHASE_RUNNING)
+        return;
+
+    if (run_frame >= run_length)
+        return;
+
+    /* Check that the state was loaded */
+    if ((run_frame == 0) && (context->framecount != SaveStateList::get(run_slot).framecount)) {
+        std::cerr << "Search could not load state " << run_slot << ", stopping" << std::endl;
+        phase = PHASE_DONE;
+        return;
+    }
+
+    ai = actions[run_actions[run_frame / frames]].ai;
+    run_frame++;
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBTAS_INPUTSEARCH_H_INCLUDED
+#define LIBTAS_INPUTSEARCH_H_INCLUDED
+
+#include <string>
+
+/* Forward declaration */
+class MovieFile;
+class AllInputs;
+struct Context;
+
+/* Search of the input sequence that maximizes a fitness over game memory.
+ * Starting from a base savestate, the search tries each action of a list for
+ * a fixed number of frames, scores the result using weighted RAM values, and
+ * keeps the best branches for the next step (beam search). Each try restarts
+ * from a savestate, so the search can run headless and unattended.
+ *
+ * The search is defined in a text file, with one parameter per line:
+ *   base SLOT            savestate slot of the base state (default 1)
+ *   work SLOT            savestate slot used as scratch (default 9)
+ *   start FRAME          frame at which the base state is saved. If not set,
+ *                        the base state must already exist
+ *   frames N             number of frames each action is held (default 1)
+ *   depth N              number of successive actions to search (default 1)
+ *   width N              number of branches kept after each step (default 1)
+ *   action NAME INPUTS   an action, with inputs in the movie format (e.g. |Kff53|)
+ *   watch WEIGHT ADDR TYPE   add WEIGHT * value to the fitness, where TYPE is
+ *                        one of int8, uint8, int16, uint16, int32, uint32,
+ *                        int64, uint64, float or double
+ *   output FILE          file where the best branch is written
+ *
+ * Multiple instances can split the search by only trying a subset of the
+ * actions at the first step.
+ */
+namespace InputSearch {
+
+    /* Load the search definition file. `part` and `nbparts` select the subset
+     * of first actions this instance tries. Returns false on error */
+    bool load(const std::string& file, int part, int nbparts);
+
+    /* Returns if a search is defined and not finished */
+    bool isActive();
+
+    /* Called at each frame boundary before hotkeys are processed. It pushes
+     * the savestate hotkeys needed by the search. Returns true when the search
+     * has just finished */
+    bool onFrame(Context* context, MovieFile& movie);
+
+    /* Called when building the inputs of the next frame, to set the inputs
+     * of the current try */
+    void onInput(Context* context, AllInputs& ai);
+}
+
+#endif
@@ -0,0 +1,366 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "LogReader.h"
+#include "ramsearch/MemAccess.h"
+#include "../shared/LogRing.h"
+#include "../shared/lcf.h"
+
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <cinttypes>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define ANSI_COLOR_RED           "\x1b[31m"
+#define ANSI_COLOR_LIGHT_RED     "\x1b[91m"
+#define ANSI_COLOR_LIGHT_GRAY    "\x1b[97m"
+#define ANSI_COLOR_RESET         "\x1b[0m"
+
+static LogRing::Layout* layout = nullptr;
+static size_t layout_size = 0;
+static int out_fd = -1;
+static bool is_term = false;
+static bool discard_records = false;
+
+static std::thread reader_thread;
+static std::atomic<bool> running(false);
+
+/* Strings read from the game memory, indexed by their address. Format strings
+ * and source file names are literals, so they never change. */
+static std::unordered_map<uint64_t, std::string> string_cache;
+
+static const std::string& readGameString(uint64_t addr)
+{
+    auto it = string_cache.find(addr);
+    if (it != string_cache.end())
+        return it->second;
+
+    std::string str;
+    char buf[256];
+    while (true) {
+        size_t ret = MemAccess::read(buf, reinterpret_cast<void*>(addr + str.size()), sizeof(buf));
+        if ((ret == static_cast<size_t>(-1)) || (ret == 0))
+            break;
+        size_t len = strnlen(buf, ret);
+        str.append(buf, len);
+        if (len < ret || str.size() >= 4096)
+            break;
+    }
+
+    return string_cache.emplace(addr, str).first->second;
+}
+
+/* Read the next argument of the record payload, checking its type */
+static bool readArg(const LogRing::Record& rec, size_t& pos, int type, void* data, size_t size)
+{
+    if ((pos + 1 + size > rec.payload_size) || (rec.payload[pos] != type))
+        return false;
+    memcpy(data, rec.payload + pos + 1, size);
+    pos += 1 + size;
+    return true;
+}
+
+static bool readString(const LogRing::Record& rec, size_t& pos, std::string& str)
+{
+    uint16_t len;
+    if (!readArg(rec, pos, LogRing::ARG_STRING, &len, sizeof(uint16_t)))
+        return false;
+    if (pos + len > rec.payload_size)
+        return false;
+    str.assign(reinterpret_cast<const char*>(rec.payload + pos), len);
+    pos += len;
+    return true;
+}
+
+/* Rebuild the message from the format string and the encoded arguments */
+static void formatMessage(const LogRing::Record& rec, const char* fmt, std::string& out)
+{
+    size_t pos = 0;
+    char buf[512];
+    LogRing::Conversion c;
+
+    while (LogRing::nextConversion(fmt, c)) {
+        /* Copy the literal part, unescaping "%%" */
+        for (const char* p = fmt; p < c.begin; p++) {
+            out += *p;
+            if ((p[0] == '%') && (p[1] == '%'))
+                p++;
+        }
+        fmt = c.end;
+
+        if (c.conv == 'n')
+            continue;
+
+        /* Build a new conversion specification, with the values of '*'
+         * inserted and the length modifier adjusted to the encoded type */
+        std::string spec = "%";
+        bool ok = true;
+        for (const char* p = c.begin + 1; p < c.end - 1; p++) {
+            if (*p == '*') {
+                int64_t v;
+                ok = ok && readArg(rec, pos, LogRing::ARG_INT, &v, sizeof(v));
+                spec += std::to_string(v);
+            }
+            else if (!strchr("hlLqjzt", *p)) {
+                spec += *p;
+            }
+        }
+
+        int type = LogRing::argType(c);
+        switch (type) {
+            case LogRing::ARG_INT: {
+                int64_t v = 0;
+                ok = ok && readArg(rec, pos, type, &v, sizeof(v));
+                if (!ok) break;
+                if (c.conv == 'c') {
+                    spec += 'c';
+                    snprintf(buf, sizeof(buf), spec.c_str(), static_cast<int>(v));
+                }
+                else {
+                    spec += "ll";
+                    spec += c.conv;
+                    snprintf(buf, sizeof(buf), spec.c_str(), static_cast<long long>(v));
+                }
+                out += buf;
+                break;
+            }
+            case LogRing::ARG_UINT: {
+                uint64_t v = 0;
+                ok = ok && readArg(rec, pos, type, &v, sizeof(v));
+                if (!ok) break;
+                spec += "ll";
+                spec += c.conv;
+                snprintf(buf, sizeof(buf), spec.c_str(), static_cast<unsigned long long>(v));
+                out += buf;
+                break;
+            }
+            case LogRing::ARG_DOUBLE: {
+                double v = 0;
+                ok = ok && readArg(rec, pos, type, &v, sizeof(v));
+                if (!ok) break;
+                spec += c.conv;
+                snprintf(buf, sizeof(buf), spec.c_str(), v);
+                out += buf;
+                break;
+            }
+            case LogRing::ARG_STRING: {
+                std::string v;
+                ok = ok && readString(rec, pos, v);
+                if (!ok) break;
+                spec += 's';
+                snprintf(buf, sizeof(buf), spec.c_str(), v.c_str());
+                out += buf;
+                break;
+            }
+            case LogRing::ARG_POINTER: {
+                uint64_t v = 0;
+                ok = ok && readArg(rec, pos, type, &v, sizeof(v));
+                if (!ok) break;
+                snprintf(buf, sizeof(buf), "0x%" PRIx64, v);
+                out += buf;
+                break;
+            }
+            default:
+                ok = false;
+                break;
+        }
+
+        if (!ok) {
+            /* Missing or unknown argument, print the rest of the format
+             * string as is */
+            out.append(c.begin);
+            return;
+        }
+    }
+
+    for (const char* p = fmt; *p; p++) {
+        out += *p;
+        if ((p[0] == '%') && (p[1] == '%'))
+            p++;
+    }
+
+    if (rec.flags & LogRing::REC_TRUNCATED)
+        out += " [truncated]";
+}
+
+/* Build the full log line, with the same layout as messages printed
+ * directly by the game */
+static void formatRecord(const LogRing::Record& rec, std::string& out)
+{
+    char header[128];
+
+    if (is_term) {
+        if (rec.lcf & LCF_ERROR)
+            out += ANSI_COLOR_RED;
+        else if (rec.lcf & LCF_WARNING)
+            out += ANSI_COLOR_LIGHT_RED;
+        else
+            out += ANSI_COLOR_LIGHT_GRAY;
+    }
+
+    snprintf(header, sizeof(header), "[f:%" PRIu64 " t:%d%s] ", rec.framecount, rec.tid, (rec.flags & LogRing::REC_MAINTHREAD)?"M":"");
+    out += header;
+
+    if (is_term)
+        out += ANSI_COLOR_RESET;
+
+    if (rec.lcf & LCF_ERROR) {
+        snprintf(header, sizeof(header), "ERROR (%s:%d): ", readGameString(rec.file).c_str(), rec.line);
+        out += header;
+    }
+
+    formatMessage(rec, readGameString(rec.fmt).c_str(), out);
+    out += '\n';
+}
+
+/* Consume all available records. Returns if any record was found */
+static bool drainRings()
+{
+    bool found = false;
+    std::string out;
+
+    for (uint32_t r = 0; r < layout->ring_count; r++) {
+        LogRing::Ring& ring = layout->rings[r];
+        uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+        uint32_t head = ring.head.load(std::memory_order_acquire);
+
+        if (tail == head)
+            continue;
+
+        found = true;
+        for (; tail != head; tail++) {
+            if (!discard_records)
+                formatRecord(ring.records[tail & (LogRing::RING_RECORDS - 1)], out);
+        }
+        ring.tail.store(tail, std::memory_order_release);
+    }
+
+    /* Print everything with a single write */
+    size_t written = 0;
+    while (written < out.size()) {
+        ssize_t ret = write(out_fd, out.data() + written, out.size() - written);
+        if (ret <= 0)
+            break;
+        written += ret;
+    }
+
+    return found;
+}
+
+/* Wake the reader thread, from the program side */
+static void wakeReader()
+{
+    layout->wake_seq.fetch_add(1);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&layout->wake_seq), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+static void readerLoop()
+{
+    while (running) {
+        if (drainRings())
+            continue;
+
+        /* Nothing to read, sleep until a thread of the game pushes a record.
+         * The rings are checked again after raising the flag, because
+         * threads only wake us when they see it. */
+        uint32_t seq = layout->wake_seq.load();
+        layout->reader_waiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        /* The mapping is shared with the game, so the futex is not private.
+         * stop() also bumps the word, so we cannot miss its wake. */
+        if (!drainRings() && running)
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&layout->wake_seq), FUTEX_WAIT, seq, nullptr, nullptr, 0);
+
+        layout->reader_waiting.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LogReader::init(pid_t pid, int fd, bool discard)
+{
+    stop();
+
+    std::string path = "/proc/" + std::to_string(pid) + "/fd/" + std::to_string(fd);
+    int ring_fd = open(path.c_str(), O_RDWR);
+    if (ring_fd < 0) {
+        std::cerr << "Could not open the log rings of the game" << std::endl;
+        return;
+    }
+
+    layout_size = (sizeof(LogRing::Layout) + 4095) & ~static_cast<size_t>(4095);
+    void* addr = mmap(nullptr, layout_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring_fd, 0);
+    close(ring_fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Could not map the log rings of the game" << std::endl;
+        return;
+    }
+
+    layout = static_cast<LogRing::Layout*>(addr);
+    if ((layout->magic != LogRing::MAGIC) ||
+        (layout->ring_count != LogRing::RING_COUNT) ||
+        (layout->ring_records != LogRing::RING_RECORDS) ||
+        (layout->record_size != sizeof(LogRing::Record))) {
+        std::cerr << "Log rings layout mismatch between program and library!" << std::endl;
+        munmap(layout, layout_size);
+        layout = nullptr;
+        return;
+    }
+
+    /* Print to the same output as the game */
+    path = "/proc/" + std::to_string(pid) + "/fd/2";
+    out_fd = open(path.c_str(), O_WRONLY | O_APPEND);
+    if (out_fd < 0)
+        out_fd = dup(2);
+    is_term = isatty(out_fd);
+
+    discard_records = discard;
+    string_cache.clear();
+
+    running = true;
+    reader_thread = std::thread(readerLoop);
+}
+
+void LogReader::stop()
+{
+    if (!layout)
+        return;
+
+    running = false;
+    wakeReader();
+    if (reader_thread.joinable())
+        reader_thread.join();
+
+    /* Print the last records */
+    drainRings();
+
+    munmap(layout, layout_size);
+    layout = nullptr;
+    close(out_fd);
+    out_fd = -1;
+}
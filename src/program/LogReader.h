@@ -0,0 +1,40 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBTAS_LOGREADER_H_INCLUDED
+#define LIBTAS_LOGREADER_H_INCLUDED
+
+#include <sys/types.h>
+
+/* Drain the asynchronous log rings of the game process, format the records
+ * and print them to the game stderr. */
+namespace LogReader {
+
+    /* Map the shared memory object at file descriptor `fd` of the game
+     * process and start the reader thread. If `discard` is set, records are
+     * consumed without being formatted. */
+    void init(pid_t pid, int fd, bool discard);
+
+    /* Print all remaining records and stop the reader thread. Must be called
+     * before the game process memory becomes unavailable. */
+    void stop();
+}
+
+#endif
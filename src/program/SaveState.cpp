@@ -23,9 +23,11 @@
 #include "../shared/sockethelpers.h"
 #include "../shared/SharedConfig.h"
 #include "../shared/messages.h"
+#include "../shared/SaveStateStatus.h"
 
 #include <iostream>
 #include <unistd.h> // access()
+#include <sys/stat.h>
 
 void SaveState::init(Context* context, int i)
 {
@@ -100,6 +102,17 @@ const std::string& SaveState::getMoviePath() const
     return movie_path;
 }
 
+uint64_t SaveState::getSize() const
+{
+    uint64_t size = 0;
+    struct stat st;
+    if (stat(pagemap_path.c_str(), &st) == 0)
+        size += st.st_size;
+    if (stat(pages_path.c_str(), &st) == 0)
+        size += st.st_size;
+    return size;
+}
+
 int SaveState::save(Context* context, const MovieFile& m)
 {    
     /* Save the movie file */
@@ -227,6 +240,17 @@ int SaveState::postLoad(Context* context, MovieFile& m, bool branch, bool inputE
      * only be done if it's the case.
      */
     bool didLoad = message == MSGB_LOADING_SUCCEEDED;
+
+    /* Get the reason why the game could not restore the state */
+    int error = ERESTORE;
+    if (message < 0) {
+        if (message == SaveStateStatus::ESTATE_NOFILE)
+            error = ENOFILE;
+        else if (message == SaveStateStatus::ESTATE_NOSAVEFILE)
+            error = ENOSAVEFILE;
+        message = receiveMessage();
+    }
+
     if (didLoad) {
         /* The copy of SharedConfig that the game stores may not
          * be the same as this one due to memory loading, so we
@@ -282,7 +306,7 @@ int SaveState::postLoad(Context* context, MovieFile& m, bool branch, bool inputE
     if (didLoad)
         return MSGB_LOADING_SUCCEEDED;
     
-    return 0;
+    return error;
 }
 
 void SaveState::backupMovie()
@@ -42,6 +42,10 @@ public:
         EINPUTMISMATCH = -4, // Mistmatch inputs
         ENOLOAD = -5, // State loading failed
         EINVALID = -6, // State invalid
+        EENCODING = -7, // Not allowed while encoding
+        ERESTORE = -8, // Game could not restore the state
+        ENOFILE = -9, // A file mapped in the state was removed or replaced
+        ENOSAVEFILE = -10, // Savefile content of the state is missing
     };
 
     /* Savestate number */
@@ -72,6 +76,9 @@ public:
     /* Return the savestate movie path */
     const std::string& getMoviePath() const;
 
+    /* Return the size of the savestate files in bytes */
+    uint64_t getSize() const;
+
     /* Save state. Return the received message */
     int save(Context* context, const MovieFile& movie);
 
@@ -25,7 +25,11 @@
 
 #include <iostream>
 
-#define NB_STATES 11
+#define NB_STATES SharedConfig::SAVESTATE_SLOTS
+
+/* Number of states that can be accessed with hotkeys, the other ones are
+ * only used by lua scripts */
+#define NB_HOTKEY_STATES 11
 
 /* Array of savestates */
 static SaveState states[NB_STATES];
@@ -115,7 +119,7 @@ void SaveStateList::invalidate()
 
 int SaveStateList::stateAtFrame(uint64_t frame)
 {
-    for (int i = 0; i < NB_STATES; i++) {
+    for (int i = 0; i < NB_HOTKEY_STATES; i++) {
         if ((states[i].framecount == frame) && !states[i].invalid)
             return states[i].id;
     }
@@ -152,7 +156,7 @@ int SaveStateList::nearestState(uint64_t framecount)
     int parent_id = last_state_id;
     
     while (parent_id != -1) {
-        if (states[parent_id].framecount <= framecount)
+        if ((parent_id < NB_HOTKEY_STATES) && (states[parent_id].framecount <= framecount))
             return parent_id;
         parent_id = states[parent_id].parent;
     }
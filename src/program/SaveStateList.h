@@ -48,7 +48,7 @@ namespace SaveStateList {
     /* Invalidate all savestates. Used when threads have changed */
     void invalidate();
 
-    /* Returns one state id that was performed on that specific frame, or -1 */
+    /* Returns one hotkey state id that was performed on that specific frame, or -1 */
     int stateAtFrame(uint64_t frame);
 
     /* Returns the framecount of the root state, or -1 if already root */
@@ -57,7 +57,7 @@ namespace SaveStateList {
     /* Returns the previous framecount of the root state */
     uint64_t oldRootStateFramecount();
 
-    /* Returns the nearest state id in current branch before framecount */
+    /* Returns the nearest hotkey state id in current branch before framecount */
     int nearestState(uint64_t framecount);
 
     /* Save movies on disk when exiting */
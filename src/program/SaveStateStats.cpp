@@ -0,0 +1,79 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "SaveStateStats.h"
+#include "SaveState.h"
+#include "SaveStateList.h"
+#include "Context.h"
+
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <time.h>
+
+static std::ofstream& getStream()
+{
+    static std::ofstream stream;
+    static bool opened = false;
+
+    if (!opened) {
+        opened = true;
+        const char* path = getenv("LIBTAS_SAVESTATE_STATS");
+        if (path && path[0])
+            stream.open(path, std::ofstream::app);
+    }
+    return stream;
+}
+
+/* Returns the peak resident set size of a process in kB, or 0 if unknown */
+static uint64_t getPeakRSS(pid_t pid)
+{
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 7, "VmHWM:\t") == 0)
+            return std::strtoull(line.c_str() + 7, nullptr, 10);
+    }
+    return 0;
+}
+
+uint64_t SaveStateStats::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void SaveStateStats::record(Context* context, const char* op, int slot, uint64_t start)
+{
+    uint64_t elapsed = now() - start;
+
+    std::ofstream& stream = getStream();
+    if (!stream.is_open())
+        return;
+
+    stream << "{\"op\":\"" << op << "\",\"slot\":" << slot;
+    stream << ",\"frame\":" << context->framecount;
+    stream << ",\"flags\":" << context->config.sc.savestate_settings;
+    stream << ",\"us\":" << elapsed;
+    stream << ",\"size\":" << SaveStateList::get(slot).getSize();
+    stream << ",\"rss_kb\":" << getPeakRSS(context->game_pid);
+    stream << "}" << std::endl;
+}
@@ -0,0 +1,46 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBTAS_SAVESTATESTATS_H_INCLUDED
+#define LIBTAS_SAVESTATESTATS_H_INCLUDED
+
+#include <stdint.h>
+
+/* Forward declaration */
+struct Context;
+
+/* Records the cost of each savestate operation, so that checkpoint
+ * performance can be compared across settings and versions. Records are only
+ * written when the LIBTAS_SAVESTATE_STATS environment variable names a file,
+ * as one JSON object per line:
+ *   {"op":"save","slot":1,"frame":120,"flags":9,"us":5230,"size":1048576,"rss_kb":204800}
+ * `size` is the size of the savestate files (0 when stored in RAM, and may
+ * be incomplete when saving in a forked process), and `rss_kb` is the peak
+ * resident set size of the game. */
+namespace SaveStateStats {
+
+    /* Returns a timestamp in microseconds to be passed to record() */
+    uint64_t now();
+
+    /* Write a record for a successful save or load of `slot`, which started at `start` */
+    void record(Context* context, const char* op, int slot, uint64_t start);
+}
+
+#endif
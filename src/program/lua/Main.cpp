@@ -25,6 +25,7 @@
 #include "Memory.h"
 #include "Print.h"
 #include "Runtime.h"
+#include "Savestate.h"
 #include "Callbacks.h"
 
 #include <iostream>
@@ -56,6 +57,7 @@ lua_State* Lua::Main::new_state()
     Lua::Callbacks::registerFunctions(lua_state);
     Lua::Print::init(lua_state);
     Lua::Runtime::registerFunctions(lua_state, context);
+    Lua::Savestate::registerFunctions(lua_state);
     
     return lua_state;
 }
@@ -23,6 +23,10 @@
 #include "ramsearch/BaseAddresses.h"
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <new>
+#include <cstring>
 extern "C" {
 #include <lua.h>
 #include <lauxlib.h>
@@ -49,6 +53,48 @@ static const luaL_Reg memory_functions[] =
     { "writef", Lua::Memory::writef},
     { "writed", Lua::Memory::writed},
     { "baseAddress", Lua::Memory::baseAddress},
+    { "readBlock", Lua::Memory::readBlock},
+    { "writeBlock", Lua::Memory::writeBlock},
+    { "readArray", Lua::Memory::readArray},
+    { "readMany", Lua::Memory::readMany},
+    { "watchSet", Lua::Memory::watchSet},
+    { NULL, NULL }
+};
+
+/* Types of values read in bulk, named as the suffix of read functions */
+enum ValueType {
+    TYPE_U8, TYPE_U16, TYPE_U32, TYPE_U64,
+    TYPE_S8, TYPE_S16, TYPE_S32, TYPE_S64,
+    TYPE_F, TYPE_D,
+};
+
+static const char* const value_type_names[] = {"u8", "u16", "u32", "u64", "s8", "s16", "s32", "s64", "f", "d", nullptr};
+static const size_t value_type_sizes[] = {1, 2, 4, 8, 1, 2, 4, 8, 4, 8};
+
+/* List of values that are read together. Each value is stored in 8 bytes */
+struct WatchSet {
+    std::vector<uintptr_t> addrs;
+    std::vector<int> types;
+    std::vector<uint64_t> values;
+};
+
+static const char* watchset_metatable = "libTAS.WatchSet";
+
+static int watchset_add(lua_State *L);
+static int watchset_refresh(lua_State *L);
+static int watchset_get(lua_State *L);
+static int watchset_values(lua_State *L);
+static int watchset_len(lua_State *L);
+static int watchset_gc(lua_State *L);
+
+static const luaL_Reg watchset_methods[] =
+{
+    { "add", watchset_add},
+    { "refresh", watchset_refresh},
+    { "get", watchset_get},
+    { "values", watchset_values},
+    { "__len", watchset_len},
+    { "__gc", watchset_gc},
     { NULL, NULL }
 };
 
@@ -56,6 +102,12 @@ void Lua::Memory::registerFunctions(lua_State *L)
 {
     luaL_newlib(L, memory_functions);
     lua_setglobal(L, "memory");
+
+    luaL_newmetatable(L, watchset_metatable);
+    luaL_setfuncs(L, watchset_methods, 0);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
 }
 
 bool Lua::Memory::read(uintptr_t addr, void* return_value, int size)
@@ -162,3 +214,232 @@ int Lua::Memory::baseAddress(lua_State *L)
     lua_pushinteger(L, static_cast<lua_Integer>(addr));
     return 1;
 }
+
+/* Get the value type from its name at the given stack index */
+static int checkType(lua_State *L, int index)
+{
+    const char* name = luaL_checkstring(L, index);
+    for (int t = 0; value_type_names[t]; t++)
+        if (strcmp(name, value_type_names[t]) == 0)
+            return t;
+    return luaL_error(L, "unknown value type '%s'", name);
+}
+
+/* Push a value of a given type stored at the start of a buffer */
+static void pushValue(lua_State *L, int type, const void* data)
+{
+#define PUSHINT(TYPE) { TYPE v; memcpy(&v, data, sizeof(TYPE)); lua_pushinteger(L, static_cast<lua_Integer>(v)); break; }
+#define PUSHNUMBER(TYPE) { TYPE v; memcpy(&v, data, sizeof(TYPE)); lua_pushnumber(L, static_cast<lua_Number>(v)); break; }
+    switch (type) {
+        case TYPE_U8: PUSHINT(uint8_t)
+        case TYPE_U16: PUSHINT(uint16_t)
+        case TYPE_U32: PUSHINT(uint32_t)
+        case TYPE_U64: PUSHINT(uint64_t)
+        case TYPE_S8: PUSHINT(int8_t)
+        case TYPE_S16: PUSHINT(int16_t)
+        case TYPE_S32: PUSHINT(int32_t)
+        case TYPE_S64: PUSHINT(int64_t)
+        case TYPE_F: PUSHNUMBER(float)
+        case TYPE_D: PUSHNUMBER(double)
+    }
+#undef PUSHINT
+#undef PUSHNUMBER
+}
+
+/* Read a list of values in a single batch. Values that could not be read are
+ * set to 0, like the scalar read functions */
+static void readValues(const std::vector<uintptr_t>& addrs, const std::vector<int>& types, std::vector<uint64_t>& values)
+{
+    int count = addrs.size();
+    values.assign(count, 0);
+
+    std::vector<void*> locals(count);
+    std::vector<void*> remotes(count);
+    std::vector<size_t> sizes(count);
+    for (int i = 0; i < count; i++) {
+        locals[i] = &values[i];
+        remotes[i] = reinterpret_cast<void*>(addrs[i]);
+        sizes[i] = value_type_sizes[types[i]];
+    }
+
+    /* A batch stops at the first value that cannot be read, so we clear that
+     * value and read the remaining ones in a new batch */
+    int first = 0;
+    while (first < count) {
+        size_t total = MemAccess::readBatch(&locals[first], &remotes[first], &sizes[first], count - first);
+        while ((first < count) && (total >= sizes[first])) {
+            total -= sizes[first];
+            first++;
+        }
+        if (first < count) {
+            values[first] = 0;
+            first++;
+        }
+    }
+}
+
+int Lua::Memory::readBlock(lua_State *L)
+{
+    uintptr_t addr = static_cast<uintptr_t>(lua_tointeger(L, 1));
+    lua_Integer size = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, size >= 0, 2, "negative size");
+
+    std::string buf(size, '\0');
+    ssize_t ret = MemAccess::read(&buf[0], reinterpret_cast<void*>(addr), size);
+
+    /* Only return the bytes that could be read */
+    buf.resize(ret > 0 ? ret : 0);
+    lua_pushlstring(L, buf.data(), buf.size());
+    return 1;
+}
+
+int Lua::Memory::writeBlock(lua_State *L)
+{
+    uintptr_t addr = static_cast<uintptr_t>(lua_tointeger(L, 1));
+    size_t size;
+    const char* data = luaL_checklstring(L, 2, &size);
+
+    ssize_t ret = MemAccess::write(const_cast<char*>(data), reinterpret_cast<void*>(addr), size);
+    lua_pushinteger(L, static_cast<lua_Integer>(ret > 0 ? ret : 0));
+    return 1;
+}
+
+int Lua::Memory::readArray(lua_State *L)
+{
+    int type = checkType(L, 1);
+    uintptr_t addr = static_cast<uintptr_t>(lua_tointeger(L, 2));
+    lua_Integer count = luaL_checkinteger(L, 3);
+    luaL_argcheck(L, count >= 0, 3, "negative count");
+    size_t size = value_type_sizes[type];
+    lua_Integer stride = luaL_optinteger(L, 4, size);
+
+    if (stride == static_cast<lua_Integer>(size)) {
+        /* Contiguous values are read at once */
+        std::vector<char> buf(count * size, 0);
+        MemAccess::read(buf.data(), reinterpret_cast<void*>(addr), buf.size());
+
+        lua_createtable(L, count, 0);
+        for (lua_Integer i = 0; i < count; i++) {
+            pushValue(L, type, &buf[i * size]);
+            lua_rawseti(L, -2, i + 1);
+        }
+        return 1;
+    }
+
+    std::vector<uintptr_t> addrs(count);
+    std::vector<int> types(count, type);
+    std::vector<uint64_t> values;
+    for (lua_Integer i = 0; i < count; i++)
+        addrs[i] = addr + i * stride;
+    readValues(addrs, types, values);
+
+    lua_createtable(L, count, 0);
+    for (lua_Integer i = 0; i < count; i++) {
+        pushValue(L, type, &values[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    return 1;
+}
+
+int Lua::Memory::readMany(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_Integer count = luaL_len(L, 1);
+
+    std::vector<uintptr_t> addrs(count);
+    std::vector<int> types(count);
+    std::vector<uint64_t> values;
+
+    /* Each element is a {type, address} pair */
+    for (lua_Integer i = 0; i < count; i++) {
+        lua_rawgeti(L, 1, i + 1);
+        luaL_checktype(L, -1, LUA_TTABLE);
+        lua_rawgeti(L, -1, 1);
+        types[i] = checkType(L, -1);
+        lua_rawgeti(L, -2, 2);
+        addrs[i] = static_cast<uintptr_t>(lua_tointeger(L, -1));
+        lua_pop(L, 3);
+    }
+
+    readValues(addrs, types, values);
+
+    lua_createtable(L, count, 0);
+    for (lua_Integer i = 0; i < count; i++) {
+        pushValue(L, types[i], &values[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    return 1;
+}
+
+int Lua::Memory::watchSet(lua_State *L)
+{
+    void* ptr = lua_newuserdata(L, sizeof(WatchSet));
+    new (ptr) WatchSet();
+    luaL_setmetatable(L, watchset_metatable);
+    return 1;
+}
+
+static WatchSet* checkWatchSet(lua_State *L)
+{
+    return static_cast<WatchSet*>(luaL_checkudata(L, 1, watchset_metatable));
+}
+
+/* Add a value to the watch set, and return its index */
+static int watchset_add(lua_State *L)
+{
+    WatchSet* ws = checkWatchSet(L);
+    int type = checkType(L, 2);
+    uintptr_t addr = static_cast<uintptr_t>(lua_tointeger(L, 3));
+
+    ws->types.push_back(type);
+    ws->addrs.push_back(addr);
+    ws->values.push_back(0);
+    lua_pushinteger(L, static_cast<lua_Integer>(ws->addrs.size()));
+    return 1;
+}
+
+/* Read all values of the watch set */
+static int watchset_refresh(lua_State *L)
+{
+    WatchSet* ws = checkWatchSet(L);
+    readValues(ws->addrs, ws->types, ws->values);
+    return 0;
+}
+
+/* Get a value from the last refresh */
+static int watchset_get(lua_State *L)
+{
+    WatchSet* ws = checkWatchSet(L);
+    lua_Integer index = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, (index >= 1) && (index <= static_cast<lua_Integer>(ws->values.size())), 2, "index out of range");
+
+    pushValue(L, ws->types[index-1], &ws->values[index-1]);
+    return 1;
+}
+
+/* Get all values from the last refresh */
+static int watchset_values(lua_State *L)
+{
+    WatchSet* ws = checkWatchSet(L);
+
+    lua_createtable(L, ws->values.size(), 0);
+    for (size_t i = 0; i < ws->values.size(); i++) {
+        pushValue(L, ws->types[i], &ws->values[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    return 1;
+}
+
+static int watchset_len(lua_State *L)
+{
+    WatchSet* ws = checkWatchSet(L);
+    lua_pushinteger(L, static_cast<lua_Integer>(ws->values.size()));
+    return 1;
+}
+
+static int watchset_gc(lua_State *L)
+{
+    WatchSet* ws = checkWatchSet(L);
+    ws->~WatchSet();
+    return 0;
+}
@@ -91,6 +91,21 @@ namespace Memory {
     
     /* Returns base address of a file */
     int baseAddress(lua_State *L);
+
+    /* Read a memory block into a string */
+    int readBlock(lua_State *L);
+
+    /* Write a string into memory */
+    int writeBlock(lua_State *L);
+
+    /* Read an array of values of the same type */
+    int readArray(lua_State *L);
+
+    /* Read a list of values of any type, in a single batch */
+    int readMany(lua_State *L);
+
+    /* Create a watch set, a list of values that are all read in a single batch */
+    int watchSet(lua_State *L);
 }
 }
 
@@ -0,0 +1,198 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Savestate.h"
+
+#include "../GameEvents.h"
+#include "../SaveState.h"
+#include "../SaveStateList.h"
+#include "../SaveStateStats.h"
+#include "../../shared/SharedConfig.h"
+#include "../../shared/SaveStateStatus.h"
+
+#include <map>
+#include <string>
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+static GameEvents* gameEvents = nullptr;
+
+/* Slots allocated to named states, starting after the hotkey slots */
+static std::map<std::string, int> named_slots;
+static int next_named_slot = 11;
+
+/* Time of the last save of each slot, in microseconds */
+static std::map<int, uint64_t> save_times;
+
+/* List of functions to register */
+static const luaL_Reg savestate_functions[] =
+{
+    { "save", Lua::Savestate::save},
+    { "load", Lua::Savestate::load},
+    { "info", Lua::Savestate::info},
+    { NULL, NULL }
+};
+
+void Lua::Savestate::registerFunctions(lua_State *L)
+{
+    luaL_newlib(L, savestate_functions);
+    lua_setglobal(L, "savestate");
+}
+
+void Lua::Savestate::registerGameEvents(GameEvents* ge)
+{
+    gameEvents = ge;
+}
+
+/* Get the slot from the first argument, either a hotkey slot number or a
+ * name. If `create` is not set, returns -1 for an unknown name. */
+static int checkSlot(lua_State *L, bool create)
+{
+    /* Slot 10 is the backtrack savestate, which can be loaded but not
+     * overwritten */
+    if (lua_type(L, 1) == LUA_TNUMBER) {
+        int slot = static_cast<int>(lua_tointeger(L, 1));
+        if (create && (slot < 1 || slot > 9))
+            luaL_error(L, "savestate slot must be between 1 and 9");
+        if (slot < 1 || slot > 10)
+            luaL_error(L, "savestate slot must be between 1 and 10");
+        return slot;
+    }
+
+    std::string name = luaL_checkstring(L, 1);
+    auto it = named_slots.find(name);
+    if (it != named_slots.end())
+        return it->second;
+
+    if (!create)
+        return -1;
+
+    if (next_named_slot >= SharedConfig::SAVESTATE_SLOTS)
+        luaL_error(L, "too many named savestates");
+
+    named_slots[name] = next_named_slot;
+    return next_named_slot++;
+}
+
+/* Saving only fails in the program when encoding, otherwise the status is the
+ * one returned by the game */
+static const char* saveError(int error)
+{
+    switch (error) {
+        case SaveState::EENCODING:
+            return "Saving is not allowed when in the middle of video encoding";
+        case SaveStateStatus::ESTATE_NOMEM:
+            return "Not enough memory to perform the savestate";
+        case SaveStateStatus::ESTATE_NOTSAMETHREADS:
+            return "Thread list has changed";
+        case SaveStateStatus::ESTATE_NOTCOMPLETE:
+            return "Previous state is still being saved";
+        default:
+            return "Unknown error";
+    }
+}
+
+static const char* loadError(int error)
+{
+    switch (error) {
+        case SaveState::ENOSTATEMOVIEPREFIX:
+        case SaveState::ENOSTATE:
+            return "There is no savestate to load in this slot";
+        case SaveState::ENOMOVIE:
+            return "Could not load the moviefile associated with the savestate";
+        case SaveState::EINPUTMISMATCH:
+            return "Trying to load a state in read-only but the inputs mismatch";
+        case SaveState::ENOLOAD:
+            return "Crash after loading the savestate";
+        case SaveState::EINVALID:
+            return "State invalid because new threads were created";
+        case SaveState::EENCODING:
+            return "Loading is not allowed when in the middle of video encoding";
+        case SaveState::ENOFILE:
+            return "A file mapped in the savestate was removed or replaced";
+        case SaveState::ENOSAVEFILE:
+            return "The savestate is missing savefile content";
+        default:
+            return "Game could not restore the state";
+    }
+}
+
+int Lua::Savestate::save(lua_State *L)
+{
+    if (!gameEvents)
+        return luaL_error(L, "savestate.save() can only be called inside onFrame()");
+
+    int slot = checkSlot(L, true);
+    uint64_t start = SaveStateStats::now();
+    int status = gameEvents->saveState(slot);
+
+    lua_pushinteger(L, static_cast<lua_Integer>(status));
+    if (status == 0) {
+        save_times[slot] = SaveStateStats::now() - start;
+        lua_pushnil(L);
+    }
+    else
+        lua_pushstring(L, saveError(status));
+    return 2;
+}
+
+int Lua::Savestate::load(lua_State *L)
+{
+    if (!gameEvents)
+        return luaL_error(L, "savestate.load() can only be called inside onFrame()");
+
+    int slot = checkSlot(L, false);
+    int status = (slot < 0) ? SaveState::ENOSTATE : gameEvents->loadState(slot, false, false);
+
+    lua_pushinteger(L, static_cast<lua_Integer>(status));
+    if (status == 0)
+        lua_pushnil(L);
+    else
+        lua_pushstring(L, loadError(status));
+    return 2;
+}
+
+int Lua::Savestate::info(lua_State *L)
+{
+    int slot = checkSlot(L, false);
+    if (slot < 0) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    const SaveState& ss = SaveStateList::get(slot);
+
+    /* A framecount of 0 indicates that there is no state */
+    if (ss.framecount == 0 || ss.invalid) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, static_cast<lua_Integer>(ss.framecount));
+    lua_setfield(L, -2, "frame");
+    lua_pushinteger(L, static_cast<lua_Integer>(ss.getSize()));
+    lua_setfield(L, -2, "size");
+    auto it = save_times.find(slot);
+    lua_pushinteger(L, static_cast<lua_Integer>((it != save_times.end()) ? it->second : 0));
+    lua_setfield(L, -2, "time");
+    return 1;
+}
@@ -0,0 +1,52 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBTAS_LUASAVESTATE_H_INCLUDED
+#define LIBTAS_LUASAVESTATE_H_INCLUDED
+
+extern "C" {
+#include <lua.h>
+}
+
+class GameEvents;
+
+namespace Lua {
+
+namespace Savestate {
+
+    /* Register all functions */
+    void registerFunctions(lua_State *L);
+
+    /* Pass the GameEvents object used to perform savestates. Savestates can
+     * only be performed synchronously inside the onFrame callback, so this is
+     * set just before calling it, and reset to nullptr after. */
+    void registerGameEvents(GameEvents* ge);
+
+    /* Save a state in a slot (number slot or string name) -> number status, string error */
+    int save(lua_State *L);
+
+    /* Load a state from a slot (number slot or string name) -> number status, string error */
+    int load(lua_State *L);
+
+    /* Get info on a saved slot (number slot or string name) -> table or nil */
+    int info(lua_State *L);
+}
+}
+
+#endif
@@ -25,6 +25,7 @@
 #include "lua/Callbacks.h"
 #include "KeyMapping.h"
 #include "ramsearch/MemScanner.h"
+#include "InputSearch.h"
 #ifdef __unix__
 #include "KeyMappingXcb.h"
 #elif defined(__APPLE__) && defined(__MACH__)
@@ -38,6 +39,8 @@
 #include <signal.h> // kill
 #include <unistd.h>
 #include <string.h>
+#include <stdio.h> // sscanf
+#include <stdlib.h> // strtoull
 #include <string>
 #include <fstream>
 #include <iostream>
@@ -67,6 +70,13 @@ static void print_usage(void)
     std::cout << "  -w, --write MOVIE       Record game inputs into the specified MOVIE file" << std::endl;
     std::cout << "  -l, --lua FILE          Start the specified FILE lua script" << std::endl;
     std::cout << "  -n, --non-interactive   Don't offer any interactive choice, so that it can run headless" << std::endl;
+    std::cout << "  -i, --instance NAME     Use separate socket, temporary and working directories" << std::endl;
+    std::cout << "                          for this instance, so that multiple games can run concurrently" << std::endl;
+    std::cout << "      --pause-frame N     Pause at frame N, or quit in non-interactive mode" << std::endl;
+    std::cout << "      --fast-forward[=R]  Start the game running in fast-forward. R sets the rendering" << std::endl;
+    std::cout << "                          while fast-forwarding: all, some or no" << std::endl;
+    std::cout << "  -s, --search FILE       Search for the best inputs as described in FILE" << std::endl;
+    std::cout << "      --search-part I/N   Only explore the I-th of N parts of the search" << std::endl;
     std::cout << "      --libtas-so-path    Path to libtas.so (equivalent to setting LIBTAS_SO_PATH)" << std::endl;
     std::cout << "      --libtas32-so-path  Path to libtas32.so (equivalent to setting LIBTAS32_SO_PATH)" << std::endl;
     std::cout << "  -h, --help              Show this message" << std::endl;
@@ -93,7 +103,13 @@ int main(int argc, char **argv)
     std::string moviefile;
     std::string dumpfile;
     std::string luafile;
+    std::string instance;
+    std::string searchfile;
+    int searchpart = 0;
+    int searchnbparts = 1;
     int recordingmode = SharedConfig::RECORDING_WRITE;
+    bool fastforward = false;
+    int fastforwardrender = -1;
 
     static struct option long_options[] =
     {
@@ -102,6 +118,11 @@ int main(int argc, char **argv)
         {"dump", required_argument, nullptr, 'd'},
         {"lua", required_argument, nullptr, 'l'},
         {"non-interactive", no_argument, nullptr, 'n'},
+        {"instance", required_argument, nullptr, 'i'},
+        {"search", required_argument, nullptr, 's'},
+        {"search-part", required_argument, nullptr, 'S'},
+        {"pause-frame", required_argument, nullptr, 'F'},
+        {"fast-forward", optional_argument, nullptr, 'f'},
         {"libtas-so-path", required_argument, nullptr, 'p'},
         {"libtas32-so-path", required_argument, nullptr, 'P'},
         {"help", no_argument, nullptr, 'h'},
@@ -110,7 +131,7 @@ int main(int argc, char **argv)
     int option_index = 0;
 
     // std::string libname;
-    while ((c = getopt_long (argc, argv, "+r:w:d:l:nh", long_options, &option_index)) != -1) {
+    while ((c = getopt_long (argc, argv, "+r:w:d:l:ni:s:h", long_options, &option_index)) != -1) {
         switch (c) {
             case 'r':
             case 'w':
@@ -138,6 +159,40 @@ int main(int argc, char **argv)
             case 'n':
                 context.interactive = false;
                 break;
+            case 'i':
+                instance = optarg;
+                break;
+            case 's':
+                abspath = realpath_nonexist(optarg);
+                if (!abspath.empty()) {
+                    searchfile = abspath;
+                }
+                break;
+            case 'S':
+                if ((sscanf(optarg, "%d/%d", &searchpart, &searchnbparts) != 2) ||
+                    (searchnbparts < 1) || (searchpart < 0) || (searchpart >= searchnbparts)) {
+                    std::cerr << "Invalid search part " << optarg << std::endl;
+                    return -1;
+                }
+                break;
+            case 'F':
+                context.pause_frame = strtoull(optarg, nullptr, 10);
+                break;
+            case 'f':
+                fastforward = true;
+                if (optarg) {
+                    if (strcmp(optarg, "all") == 0)
+                        fastforwardrender = SharedConfig::FF_RENDER_ALL;
+                    else if (strcmp(optarg, "some") == 0)
+                        fastforwardrender = SharedConfig::FF_RENDER_SOME;
+                    else if (strcmp(optarg, "no") == 0)
+                        fastforwardrender = SharedConfig::FF_RENDER_NO;
+                    else {
+                        std::cerr << "Invalid fast-forward rendering " << optarg << std::endl;
+                        return -1;
+                    }
+                }
+                break;
             case 'p':
                 abspath = realpath_nonexist(optarg);
                 if (!abspath.empty()) {
@@ -272,6 +327,28 @@ int main(int argc, char **argv)
         }
     }
 
+    /* Each instance gets its own temporary directory, holding the socket file
+     * and the scratch files of the game. Paths are passed to the game through
+     * environment variables, which are not overwritten if already set. */
+    if (!instance.empty()) {
+        std::string tmpdir;
+        char *tmpdir_from_env = getenv("TMPDIR");
+        if (tmpdir_from_env && tmpdir_from_env[0])
+            tmpdir = tmpdir_from_env;
+        else
+            tmpdir = "/tmp";
+        tmpdir += "/libTAS-";
+        tmpdir += instance;
+
+        if (create_dir(tmpdir) < 0) {
+            std::cerr << "Cannot create dir " << tmpdir << std::endl;
+            return -1;
+        }
+
+        setenv("LIBTAS_TMPDIR", tmpdir.c_str(), 0);
+        setenv("LIBTAS_SOCKET", (tmpdir + "/libTAS.socket").c_str(), 0);
+    }
+
     /* Create the working directories */
     char *path = getenv("XDG_CONFIG_HOME");
     if (path) {
@@ -299,6 +376,14 @@ int main(int argc, char **argv)
         context.config.sc.recording = recordingmode;
     }
 
+    /* Start running in fast-forward if specified in commandline */
+    if (fastforward) {
+        context.config.sc.running = true;
+        context.config.sc.fastforward = true;
+        if (fastforwardrender >= 0)
+            context.config.sc.fastforward_render = fastforwardrender;
+    }
+
     /* Overwrite the dump path if specified in commandline */
     if (! dumpfile.empty()) {
         context.config.dumpfile = dumpfile;
@@ -335,6 +420,9 @@ int main(int argc, char **argv)
     if (context.config.tempmoviedir.empty()) {
         context.config.tempmoviedir = data_dir + "/movie";
     }
+    if (!instance.empty()) {
+        context.config.tempmoviedir += "/" + instance;
+    }
     if (create_dir(context.config.tempmoviedir) < 0) {
         std::cerr << "Cannot create dir " << context.config.tempmoviedir << std::endl;
         return -1;
@@ -343,6 +431,9 @@ int main(int argc, char **argv)
     if (context.config.savestatedir.empty()) {
         context.config.savestatedir = data_dir + "/states";
     }
+    if (!instance.empty()) {
+        context.config.savestatedir += "/" + instance;
+    }
     if (create_dir(context.config.savestatedir) < 0) {
         std::cerr << "Cannot create dir " << context.config.savestatedir << std::endl;
         return -1;
@@ -351,6 +442,9 @@ int main(int argc, char **argv)
     if (context.config.ramsearchdir.empty()) {
         context.config.ramsearchdir = data_dir + "/ramsearch";
     }
+    if (!instance.empty()) {
+        context.config.ramsearchdir += "/" + instance;
+    }
     if (create_dir(context.config.ramsearchdir) < 0) {
         std::cerr << "Cannot create dir " << context.config.ramsearchdir << std::endl;
         return -1;
@@ -374,6 +468,11 @@ int main(int argc, char **argv)
     
     MemScanner::init(context.config.ramsearchdir);
 
+    if (!searchfile.empty()) {
+        if (!InputSearch::load(searchfile, searchpart, searchnbparts))
+            return -1;
+    }
+
     /* Store current content of LD_PRELOAD/DYLD_INSERT_LIBRARIES */
 
 #ifdef __unix__
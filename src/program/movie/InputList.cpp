@@ -0,0 +1,138 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "InputList.h"
+
+#include <algorithm>
+#include <atomic>
+
+const AllInputs& InputList::operator[](uint64_t pos) const
+{
+    return (*chunks[pos / CHUNK_SIZE])[pos % CHUNK_SIZE];
+}
+
+AllInputs& InputList::at(uint64_t pos)
+{
+    return ownChunk(pos / CHUNK_SIZE)[pos % CHUNK_SIZE];
+}
+
+InputList::Chunk& InputList::ownChunk(uint64_t index)
+{
+    /* Chunks are only shared by copies made from this thread, so a count of
+     * one cannot grow behind our back. A count that drops concurrently only
+     * makes us duplicate a chunk for nothing. */
+    if (chunks[index].use_count() > 1) {
+        std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+        chunk->reserve(CHUNK_SIZE);
+        chunk->insert(chunk->end(), chunks[index]->begin(), chunks[index]->end());
+        chunks[index] = chunk;
+    }
+    else {
+        /* use_count() is a relaxed load. If another thread just released
+         * its copy, its reads of the chunk must happen before our writes,
+         * which this fence ensures by pairing with the release of the
+         * reference count decrement. */
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *chunks[index];
+}
+
+void InputList::push_back(const AllInputs& inputs)
+{
+    if ((count % CHUNK_SIZE) == 0) {
+        chunks.push_back(std::make_shared<Chunk>());
+        chunks.back()->reserve(CHUNK_SIZE);
+    }
+    ownChunk(chunks.size() - 1).push_back(inputs);
+    count++;
+}
+
+void InputList::truncate(uint64_t size)
+{
+    if (size >= count)
+        return;
+
+    chunks.resize((size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    if (size % CHUNK_SIZE) {
+        Chunk& chunk = ownChunk(chunks.size() - 1);
+        chunk.erase(chunk.begin() + (size % CHUNK_SIZE), chunk.end());
+    }
+    count = size;
+}
+
+std::vector<AllInputs> InputList::cut(uint64_t pos)
+{
+    std::vector<AllInputs> tail;
+    tail.reserve(count - pos);
+    for (uint64_t i = pos; i < count; i++)
+        tail.push_back((*this)[i]);
+    truncate(pos);
+    return tail;
+}
+
+void InputList::insert(uint64_t pos, const AllInputs inputs[], uint64_t n)
+{
+    std::vector<AllInputs> tail = cut(pos);
+    for (uint64_t i = 0; i < n; i++)
+        push_back(inputs[i]);
+    for (const AllInputs& ai : tail)
+        push_back(ai);
+}
+
+void InputList::insert(uint64_t pos, const AllInputs& inputs, uint64_t n)
+{
+    std::vector<AllInputs> tail = cut(pos);
+    for (uint64_t i = 0; i < n; i++)
+        push_back(inputs);
+    for (const AllInputs& ai : tail)
+        push_back(ai);
+}
+
+void InputList::erase(uint64_t pos, uint64_t n)
+{
+    std::vector<AllInputs> tail = cut(pos + n);
+    truncate(pos);
+    for (const AllInputs& ai : tail)
+        push_back(ai);
+}
+
+void InputList::clear()
+{
+    chunks.clear();
+    count = 0;
+}
+
+uint64_t InputList::commonPrefix(const InputList& other) const
+{
+    uint64_t size = std::min(count, other.count);
+    uint64_t pos = 0;
+
+    for (uint64_t c = 0; (c < chunks.size()) && (c < other.chunks.size()); c++) {
+        if (chunks[c] != other.chunks[c])
+            break;
+        pos += chunks[c]->size();
+    }
+
+    pos = std::min(pos, size);
+    while ((pos < size) && ((*this)[pos] == other[pos]))
+        pos++;
+
+    return pos;
+}
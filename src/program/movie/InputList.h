@@ -0,0 +1,81 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBTAS_INPUTLIST_H_INCLUDED
+#define LIBTAS_INPUTLIST_H_INCLUDED
+
+#include "../shared/inputs/AllInputs.h"
+
+#include <vector>
+#include <memory>
+#include <stdint.h>
+
+/* List of movie inputs, stored as fixed-size chunks that are shared between
+ * copies. Copying the list only copies the chunk pointers, and a chunk is
+ * duplicated the first time it is modified while being shared. This allows
+ * taking a snapshot of the whole movie in a frame and saving it from another
+ * thread, while the main thread keeps modifying its own copy. */
+class InputList {
+public:
+    /* Number of frames in a chunk */
+    static const uint64_t CHUNK_SIZE = 1024;
+
+    uint64_t size() const {return count;}
+    bool empty() const {return count == 0;}
+
+    /* Read-only access to a frame, which must be inside the list */
+    const AllInputs& operator[](uint64_t pos) const;
+
+    /* Writable access to a frame, which must be inside the list. The chunk
+     * containing the frame is duplicated if it is shared. */
+    AllInputs& at(uint64_t pos);
+
+    void push_back(const AllInputs& inputs);
+
+    /* Shrink the list to a number of frames */
+    void truncate(uint64_t size);
+
+    /* Insert frames before the requested pos */
+    void insert(uint64_t pos, const AllInputs inputs[], uint64_t n);
+    void insert(uint64_t pos, const AllInputs& inputs, uint64_t n);
+
+    /* Remove frames starting at the requested pos */
+    void erase(uint64_t pos, uint64_t n);
+
+    void clear();
+
+    /* Number of identical frames at the start of both lists. Shared chunks
+     * are skipped without comparing their frames. */
+    uint64_t commonPrefix(const InputList& other) const;
+
+private:
+    typedef std::vector<AllInputs> Chunk;
+
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    uint64_t count = 0;
+
+    /* Return a chunk that is not shared with another list */
+    Chunk& ownChunk(uint64_t index);
+
+    /* Remove and return all frames from pos to the end of the list */
+    std::vector<AllInputs> cut(uint64_t pos);
+};
+
+#endif
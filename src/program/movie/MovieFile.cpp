@@ -34,6 +34,7 @@ MovieFile::MovieFile(Context* c) : context(c)
     inputs = new MovieFileInputs(c);
     annotations = new MovieFileAnnotations(c);
     editor = new MovieFileEditor(c);
+    journal = new MovieFileJournal(c);
 }
 
 const char* MovieFile::errorString(int error_code) {
@@ -162,16 +163,30 @@ int MovieFile::saveMovie(const std::string& moviefile, uint64_t nb_frames)
         return ENOMOVIE;
 
     inputs->save();
-    header->save(inputs->nbFrames(), nb_frames);
-    annotations->save();
-    editor->save();
+    header->save(context->config.tempmoviedir, inputs->nbFrames(), nb_frames);
+    annotations->save(context->config.tempmoviedir);
+    editor->save(context->config.tempmoviedir);
 
+    return archive(moviefile, context->config.tempmoviedir);
+}
+
+MovieFileInputs::Snapshot MovieFile::saveParameters(const std::string& dir)
+{
+    MovieFileInputs::Snapshot snapshot = inputs->snapshot();
+    header->save(dir, snapshot.inputs.size(), snapshot.inputs.size());
+    annotations->save(dir);
+    editor->save(dir);
+    return snapshot;
+}
+
+int MovieFile::archive(const std::string& moviefile, const std::string& dir)
+{
     /* Build the tar command */
     std::ostringstream oss;
     oss << "tar -czUf \"";
     oss << moviefile;
     oss << "\" -C ";
-    oss << context->config.tempmoviedir;
+    oss << dir;
     oss << " inputs config.ini editor.ini annotations.txt";
 
     /* Execute the tar command */
@@ -186,7 +201,13 @@ int MovieFile::saveMovie(const std::string& moviefile, uint64_t nb_frames)
 
 int MovieFile::saveMovie(const std::string& moviefile)
 {
-    return saveMovie(moviefile, inputs->nbFrames());
+    int ret = saveMovie(moviefile, inputs->nbFrames());
+
+    /* The journal restarts from the saved movie */
+    if ((ret == 0) && (moviefile == context->config.moviefile))
+        journal->reset();
+
+    return ret;
 }
 
 int MovieFile::saveMovie()
@@ -224,10 +245,33 @@ bool MovieFile::isPrefix(const MovieFile& movie) const
     return inputs->isPrefix(movie.inputs, movie.header->savestate_framecount);
 }
 
+void MovieFile::openJournal(bool from_moviefile, bool recover)
+{
+    if (journal->open(from_moviefile, recover) < 0)
+        return;
+
+    uint64_t nb_changes = inputs->attachJournal(journal);
+    if (nb_changes > 0) {
+        std::cout << "Recovered " << nb_changes << " input changes from the journal of an interrupted recording" << std::endl;
+        updateLength();
+    }
+}
+
+bool MovieFile::hasJournal() const
+{
+    return MovieFileJournal::exists(context->config.moviefile);
+}
+
+void MovieFile::flushJournal()
+{
+    journal->flush();
+}
+
 void MovieFile::close()
 {
     inputs->close();
     editor->close();
+    journal->close();
 }
 
 void MovieFile::updateLength()
@@ -24,6 +24,7 @@
 #include "MovieFileEditor.h"
 #include "MovieFileHeader.h"
 #include "MovieFileInputs.h"
+#include "MovieFileJournal.h"
 
 #include <string>
 #include <stdint.h>
@@ -38,6 +39,7 @@ public:
     MovieFileInputs* inputs;
     MovieFileAnnotations* annotations;
     MovieFileEditor* editor;
+    MovieFileJournal* journal;
 
     /* List of error codes */
     enum Error {
@@ -78,6 +80,14 @@ public:
     /* Write only the n first frames of input into the movie file. Used for savestate movies */
     int saveMovie(const std::string& moviefile, uint64_t frame_nb);
 
+    /* Write the parameter files of the movie into a directory, and return a
+     * snapshot of the inputs. The inputs can then be written into the same
+     * directory and archived from another thread. */
+    MovieFileInputs::Snapshot saveParameters(const std::string& dir);
+
+    /* Compress the movie files of a directory into a movie file */
+    static int archive(const std::string& moviefile, const std::string& dir);
+
     /* Copy movie to another one */
     void copyTo(MovieFile& movie) const;
 
@@ -86,6 +96,17 @@ public:
 
     bool isPrefix(const MovieFile& movie) const;
 
+    /* Start journaling the input changes of the movie being recorded, based
+     * on the inputs loaded from the movie file or on empty inputs. If
+     * `recover` is set, recover the changes of an interrupted recording */
+    void openJournal(bool from_moviefile, bool recover);
+
+    /* Is there a journal left by an interrupted recording of the movie */
+    bool hasJournal() const;
+
+    /* Write the pending input changes into the journal */
+    void flushJournal();
+
     /* Close the moviefile */
     void close();
 
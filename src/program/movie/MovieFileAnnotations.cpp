@@ -44,10 +44,10 @@ void MovieFileAnnotations::load()
     }
 }
 
-void MovieFileAnnotations::save()
+void MovieFileAnnotations::save(const std::string& dir)
 {
     /* Save annotations */
-    std::string annotations_file = context->config.tempmoviedir + "/annotations.txt";
+    std::string annotations_file = dir + "/annotations.txt";
     std::ofstream annotations_stream(annotations_file);
     annotations_stream << text;
     annotations_stream.close();
@@ -40,7 +40,7 @@ public:
     void load();
 
     /* Write the inputs into a file and compress to the whole moviefile */
-    void save();
+    void save(const std::string& dir);
 
 private:
     Context* context;
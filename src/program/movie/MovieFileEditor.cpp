@@ -98,10 +98,10 @@ void MovieFileEditor::load()
     config.endArray();
 }
 
-void MovieFileEditor::save()
+void MovieFileEditor::save(const std::string& dir)
 {
     /* Save some parameters into the editor file */
-    QString editorfile = context->config.tempmoviedir.c_str();
+    QString editorfile = dir.c_str();
     editorfile += "/editor.ini";
 
     QSettings config(editorfile, QSettings::IniFormat);
@@ -23,6 +23,7 @@
 #include "../shared/inputs/SingleInput.h"
 
 #include <vector>
+#include <string>
 #include <set>
 #include <map>
 #include <stdint.h>
@@ -55,7 +56,7 @@ public:
     void load();
 
     /* Write the inputs into a file and compress to the whole moviefile */
-    void save();
+    void save(const std::string& dir);
 
     /* Copy locked inputs from the current inputs to the inputs in argument */
     void setLockedInputs(AllInputs& inputs, const AllInputs& movie_inputs);
@@ -119,12 +119,12 @@ void MovieFileHeader::loadSavestate()
     savestate_framecount = config.value("savestate_frame_count").toULongLong();
 }
 
-void MovieFileHeader::save(uint64_t tot_frames, uint64_t nb_frames)
+void MovieFileHeader::save(const std::string& dir, uint64_t tot_frames, uint64_t nb_frames)
 {
     savestate_framecount = nb_frames;
     
     /* Save some parameters into the config file */
-    QString configfile = context->config.tempmoviedir.c_str();
+    QString configfile = dir.c_str();
     configfile += "/config.ini";
 
     QSettings config(configfile, QSettings::IniFormat);
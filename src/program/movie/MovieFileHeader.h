@@ -41,7 +41,7 @@ public:
     void loadSavestate();
 
     /* Write only the n first frames of input into the movie file. Used for savestate movies */
-    void save(uint64_t tot_frames, uint64_t frame_nb);
+    void save(const std::string& dir, uint64_t tot_frames, uint64_t frame_nb);
 
     /* Initial framerate values */
     unsigned int framerate_num, framerate_den;
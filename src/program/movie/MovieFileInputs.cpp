@@ -18,6 +18,7 @@
  */
 
 #include "MovieFileInputs.h"
+#include "MovieFileJournal.h"
 
 #include "utils.h"
 #include "Context.h"
@@ -32,7 +33,7 @@
 #include <sstream>
 #include <algorithm>
 
-MovieFileInputs::MovieFileInputs(Context* c) : context(c)
+MovieFileInputs::MovieFileInputs(Context* c) : context(c), pending_count(0)
 {    
     clear();
 }
@@ -43,6 +44,8 @@ void MovieFileInputs::clear()
     modifiedSinceLastAutoSave = false;
     modifiedSinceLastStateLoad = false;
     input_list.clear();
+    if (journal)
+        journal->truncate(0);
 }
 
 void MovieFileInputs::load()
@@ -75,13 +78,49 @@ void MovieFileInputs::save()
     std::string input_file = context->config.tempmoviedir + "/inputs";
     std::ofstream input_stream(input_file, std::ofstream::trunc);
 
-    for (auto it = input_list.begin(); it != input_list.end(); ++it) {
-        writeFrame(input_stream, *it);
+    FrameFormat format = frameFormat();
+    for (uint64_t i = 0; i < input_list.size(); i++) {
+        writeFrame(input_stream, input_list[i], format);
+    }
+    input_stream.close();
+}
+
+MovieFileInputs::FrameFormat MovieFileInputs::frameFormat() const
+{
+    FrameFormat format;
+    format.mouse_support = context->config.sc.mouse_support;
+    format.nb_controllers = context->config.sc.nb_controllers;
+    format.framerate_num = framerate_num;
+    format.framerate_den = framerate_den;
+    return format;
+}
+
+MovieFileInputs::Snapshot MovieFileInputs::snapshot()
+{
+    std::unique_lock<std::mutex> lock(input_list_mutex);
+
+    Snapshot snapshot;
+    snapshot.inputs = input_list;
+    snapshot.format = frameFormat();
+    return snapshot;
+}
+
+void MovieFileInputs::saveSnapshot(const Snapshot& snapshot, const std::string& input_file)
+{
+    std::ofstream input_stream(input_file, std::ofstream::trunc);
+
+    for (uint64_t i = 0; i < snapshot.inputs.size(); i++) {
+        writeFrame(input_stream, snapshot.inputs[i], snapshot.format);
     }
     input_stream.close();
 }
 
 int MovieFileInputs::writeFrame(std::ostream& input_stream, const AllInputs& inputs)
+{
+    return writeFrame(input_stream, inputs, frameFormat());
+}
+
+int MovieFileInputs::writeFrame(std::ostream& input_stream, const AllInputs& inputs, const FrameFormat& format)
 {
     /* Write keyboard inputs */
     input_stream.put('|');
@@ -93,7 +132,7 @@ int MovieFileInputs::writeFrame(std::ostream& input_stream, const AllInputs& inp
     }
 
     /* Write mouse inputs */
-    if (context->config.sc.mouse_support && inputs.pointer) {
+    if (format.mouse_support && inputs.pointer) {
         input_stream.put('|');
         input_stream.put('M');
         input_stream << std::dec;
@@ -108,7 +147,7 @@ int MovieFileInputs::writeFrame(std::ostream& input_stream, const AllInputs& inp
     }
 
     /* Write controller inputs */
-    for (int joy=0; joy<context->config.sc.nb_controllers; joy++) {
+    for (int joy=0; joy<format.nb_controllers; joy++) {
         if (inputs.isDefaultController(joy))
             continue;
         /* Previous test ensures that there is an allocated ControllerInputs object */
@@ -151,20 +190,20 @@ int MovieFileInputs::writeFrame(std::ostream& input_stream, const AllInputs& inp
         
         /* Write framerate inputs */
         /* Only store framerate if different from initial framerate */
-        if ((inputs.misc->framerate_num && (inputs.misc->framerate_num != framerate_num)) ||
-            (inputs.misc->framerate_den && (inputs.misc->framerate_den != framerate_den))) {
+        if ((inputs.misc->framerate_num && (inputs.misc->framerate_num != format.framerate_num)) ||
+            (inputs.misc->framerate_den && (inputs.misc->framerate_den != format.framerate_den))) {
             input_stream.put('|');
             input_stream.put('T');
             input_stream << std::dec;
             if (inputs.misc->framerate_num)
             input_stream << inputs.misc->framerate_num;
             else
-            input_stream << framerate_num;
+            input_stream << format.framerate_num;
             input_stream << ':';
             if (inputs.misc->framerate_den)
             input_stream << inputs.misc->framerate_den;
             else
-            input_stream << framerate_den;
+            input_stream << format.framerate_den;
         }
         
         /* Write realtime inputs */
@@ -404,6 +443,8 @@ int MovieFileInputs::setInputs(const AllInputs& inputs, uint64_t pos, bool keep_
     /* Check that we are writing to the next frame */
     if (pos == input_list.size()) {
         input_list.push_back(inputs);
+        if (journal)
+            journal->setFrame(pos, inputs);
         wasModified();
         return 0;
     }
@@ -413,12 +454,16 @@ int MovieFileInputs::setInputs(const AllInputs& inputs, uint64_t pos, bool keep_
          * the end.
          */
         if (keep_inputs) {
-            input_list[pos] = inputs;
+            input_list.at(pos) = inputs;
         }
         else {
-            input_list.resize(pos);
+            input_list.truncate(pos);
             input_list.push_back(inputs);
+            if (journal)
+                journal->truncate(pos);
         }
+        if (journal)
+            journal->setFrame(pos, inputs);
         wasModified();
         return 0;
     }
@@ -470,18 +515,22 @@ const AllInputs& MovieFileInputs::getInputs(uint64_t pos)
     std::unique_lock<std::mutex> lock(input_list_mutex);
 
     if (pos >= input_list.size()) {
-        pos = input_list.size();
+        blank_inputs.clear();
+        return blank_inputs;
     }
 
     /* Special case for zero framerate */
-    if (input_list[pos].misc) {
-        if (!input_list[pos].misc->framerate_num)
-            input_list[pos].misc->framerate_num = framerate_num;
-        if (!input_list[pos].misc->framerate_den)
-            input_list[pos].misc->framerate_den = framerate_den;
+    const AllInputs& inputs = input_list[pos];
+    if (inputs.misc && (!inputs.misc->framerate_num || !inputs.misc->framerate_den)) {
+        AllInputs& ai = input_list.at(pos);
+        if (!ai.misc->framerate_num)
+            ai.misc->framerate_num = framerate_num;
+        if (!ai.misc->framerate_den)
+            ai.misc->framerate_den = framerate_den;
+        return ai;
     }
 
-    return input_list[pos];
+    return inputs;
 }
 
 void MovieFileInputs::clearInputs(uint64_t pos)
@@ -489,7 +538,10 @@ void MovieFileInputs::clearInputs(uint64_t pos)
     std::unique_lock<std::mutex> lock(input_list_mutex);
 
     if (pos < input_list.size()) {
-        input_list[pos].clear();
+        AllInputs& ai = input_list.at(pos);
+        ai.clear();
+        if (journal)
+            journal->setFrame(pos, ai);
         wasModified();
     }
 }
@@ -504,7 +556,9 @@ void MovieFileInputs::insertInputsBefore(uint64_t pos, int count)
     AllInputs ai;
     ai.clear();
 
-    input_list.insert(input_list.begin() + pos, count, ai);
+    input_list.insert(pos, ai, count);
+    if (journal)
+        journal->insert(pos, count);
     wasModified();
 }
 
@@ -515,7 +569,12 @@ void MovieFileInputs::insertInputsBefore(const AllInputs inputs[], uint64_t pos,
     if (pos > input_list.size())
         return;
 
-    input_list.insert(input_list.begin() + pos, inputs, inputs + count);
+    input_list.insert(pos, inputs, count);
+    if (journal) {
+        journal->insert(pos, count);
+        for (int i = 0; i < count; i++)
+            journal->setFrame(pos + i, inputs[i]);
+    }
     wasModified();
 }
 
@@ -526,7 +585,9 @@ void MovieFileInputs::deleteInputs(uint64_t pos, int count)
     if ((pos + count) > input_list.size())
         return;
 
-    input_list.erase(input_list.begin() + pos, input_list.begin() + pos + count);
+    input_list.erase(pos, count);
+    if (journal)
+        journal->erase(pos, count);
     wasModified();
 }
 
@@ -534,16 +595,38 @@ void MovieFileInputs::extractInputs(std::set<SingleInput> &set)
 {
     std::unique_lock<std::mutex> lock(input_list_mutex);
 
-    for (const AllInputs &ai : input_list) {
-        ai.extractInputs(set);
+    for (uint64_t i = 0; i < input_list.size(); i++) {
+        input_list[i].extractInputs(set);
     }
 }
 
 
 void MovieFileInputs::copyTo(MovieFileInputs* movie_inputs) const
 {
-    movie_inputs->input_list.resize(input_list.size());
-    std::copy(input_list.begin(), input_list.end(), movie_inputs->input_list.begin());
+    /* Only journal the frames that differ, which is usually none when
+     * loading a savestate of the same recording */
+    if (movie_inputs->journal) {
+        uint64_t prefix = input_list.commonPrefix(movie_inputs->input_list);
+        if (prefix < movie_inputs->input_list.size())
+            movie_inputs->journal->truncate(prefix);
+        for (uint64_t i = prefix; i < input_list.size(); i++)
+            movie_inputs->journal->setFrame(i, input_list[i]);
+    }
+
+    /* Chunks are shared until one of the lists is modified */
+    movie_inputs->input_list = input_list;
+}
+
+uint64_t MovieFileInputs::attachJournal(MovieFileJournal* j)
+{
+    std::unique_lock<std::mutex> lock(input_list_mutex);
+
+    uint64_t nb_changes = j->replay(input_list);
+    if (nb_changes > 0)
+        wasModified();
+
+    journal = j;
+    return nb_changes;
 }
 
 // void MovieFileInputs::truncateInputs(uint64_t size)
@@ -555,15 +638,20 @@ void MovieFileInputs::copyTo(MovieFileInputs* movie_inputs) const
 void MovieFileInputs::close()
 {
     input_list.clear();
+    journal = nullptr;
 }
 
 bool MovieFileInputs::isPrefix(const MovieFileInputs* movie, unsigned int frame) const
 {
     /* Not a prefix if the size is greater */
-    if (frame > input_list.size())
+    if ((frame > input_list.size()) || (frame > movie->input_list.size()))
         return false;
 
-    return std::equal(movie->input_list.begin(), movie->input_list.begin() + frame, input_list.begin());
+    for (unsigned int i = 0; i < frame; i++) {
+        if (!(movie->input_list[i] == input_list[i]))
+            return false;
+    }
+    return true;
 }
 
 void MovieFileInputs::wasModified()
@@ -573,12 +661,61 @@ void MovieFileInputs::wasModified()
     modifiedSinceLastStateLoad = true;
 }
 
+void MovieFileInputs::queueEvent(const InputEvent& ie)
+{
+    /* Register the pending input before pushing the event, so that the main
+     * thread always finds it when processing the event */
+    {
+        std::unique_lock<std::mutex> lock(pending_mutex);
+        auto it = pending_inputs[ie.framecount].emplace(ie.si, PendingInput{ie.value, 0}).first;
+        it->second.value = ie.value;
+        it->second.count++;
+        pending_count++;
+    }
+
+    input_event_queue.push(ie);
+}
+
+bool MovieFileInputs::getPendingInput(uint64_t framecount, const SingleInput& si, int& value)
+{
+    if (pending_count.load() == 0)
+        return false;
+
+    std::unique_lock<std::mutex> lock(pending_mutex);
+
+    auto frame_it = pending_inputs.find(framecount);
+    if (frame_it == pending_inputs.end())
+        return false;
+
+    auto it = frame_it->second.find(si);
+    if (it == frame_it->second.end())
+        return false;
+
+    value = it->second.value;
+    return true;
+}
+
 uint64_t MovieFileInputs::processEvent()
 {
     /* Process input events */
     while (!input_event_queue.empty()) {
         InputEvent ie;
         input_event_queue.pop(ie);
+
+        /* Remove the event from the pending index */
+        {
+            std::unique_lock<std::mutex> lock(pending_mutex);
+            auto frame_it = pending_inputs.find(ie.framecount);
+            if (frame_it != pending_inputs.end()) {
+                auto it = frame_it->second.find(ie.si);
+                if ((it != frame_it->second.end()) && (--it->second.count == 0)) {
+                    frame_it->second.erase(it);
+                    if (frame_it->second.empty())
+                        pending_inputs.erase(frame_it);
+                }
+            }
+            pending_count--;
+        }
         
         /* Check for setting inputs before current framecount */
         if (ie.framecount < context->framecount)
@@ -589,8 +726,10 @@ uint64_t MovieFileInputs::processEvent()
         if (ie.framecount >= input_list.size())
             continue;
 
-        AllInputs& ai = input_list[ie.framecount];        
+        AllInputs& ai = input_list.at(ie.framecount);        
         ai.setInput(ie.si, ie.value);
+        if (journal)
+            journal->setInput(ie.framecount, ie.si, ie.value);
         wasModified();
         return ie.framecount;
     }
@@ -21,16 +21,21 @@
 #define LIBTAS_MOVIEFILEINPUTS_H_INCLUDED
 
 #include "ConcurrentQueue.h"
+#include "InputList.h"
 #include "../shared/inputs/AllInputs.h"
 
 #include <fstream>
 #include <string>
 #include <vector>
 #include <set>
+#include <map>
+#include <unordered_map>
 #include <mutex>
+#include <atomic>
 #include <stdint.h>
 
 struct Context;
+class MovieFileJournal;
 
 /* Struct to push movie changes from the UI to the main thread. UI thread should
  * never modify the movie */
@@ -43,6 +48,19 @@ struct InputEvent {
 class MovieFileInputs {
 public:
 
+    /* Parameters used to format the input frames */
+    struct FrameFormat {
+        bool mouse_support;
+        int nb_controllers;
+        unsigned int framerate_num, framerate_den;
+    };
+
+    /* Copy of the inputs that can be saved from another thread */
+    struct Snapshot {
+        InputList inputs;
+        FrameFormat format;
+    };
+
     /* Flag storing if the movie has been modified since last save.
      * Used for prompting a message when the game exits if the user wants
      * to save.
@@ -59,8 +77,12 @@ public:
     /* Initial framerate values */
     unsigned int framerate_num, framerate_den;
 
-    /* Queue of movie input changes that where pushed by the UI, to process by the main thread */
-    ConcurrentQueue<InputEvent> input_event_queue;
+    /* Push an input change from the UI thread, to be processed by the main thread */
+    void queueEvent(const InputEvent& ie);
+
+    /* Get the value of the last input change of a single input at a frame
+     * that was not processed yet. Returns false if there is none. */
+    bool getPendingInput(uint64_t framecount, const SingleInput& si, int& value);
 
     /* Prepare a movie file from the context */
     MovieFileInputs(Context* c);
@@ -75,8 +97,16 @@ public:
     /* Write the inputs into a file and compress to the whole moviefile */
     void save();
 
+    /* Take a snapshot of the inputs. This only copies the chunk pointers of
+     * the input list, so it can be called in any frame. */
+    Snapshot snapshot();
+
+    /* Write the inputs of a snapshot into a file. Can be called from any thread */
+    static void saveSnapshot(const Snapshot& snapshot, const std::string& input_file);
+
     /* Write a single frame of inputs into the input stream */
     int writeFrame(std::ostream& input_stream, const AllInputs& inputs);
+    static int writeFrame(std::ostream& input_stream, const AllInputs& inputs, const FrameFormat& format);
 
     /* Read a single frame of inputs from the line of inputs */
     int readFrame(const std::string& line, AllInputs& inputs);
@@ -116,6 +146,11 @@ public:
     /* Copy inputs to another one */
     void copyTo(MovieFileInputs* movie_inputs) const;
 
+    /* Record all following changes to the inputs into a journal, after
+     * applying the changes of a recovered journal. Returns the number of
+     * recovered changes */
+    uint64_t attachJournal(MovieFileJournal* j);
+
     /* Truncate inputs to a frame number */
     // void truncateInputs(uint64_t size);
 
@@ -138,12 +173,41 @@ private:
     Context* context;
 
     /* The list of inputs */
-    std::vector<AllInputs> input_list;
+    InputList input_list;
+
+    /* Journal of input changes, only for the movie being recorded */
+    MovieFileJournal* journal = nullptr;
+
+    /* Blank inputs returned when reading past the end of the list */
+    AllInputs blank_inputs;
+
+    /* Get the current parameters used to format the input frames */
+    FrameFormat frameFormat() const;
 
     /* We need to protect the input list access, because both the main and UI
      * threads can read and write to the list */
     std::mutex input_list_mutex;
 
+    /* Value of the last queued input change of a single input, and the number
+     * of queued changes for that input */
+    struct PendingInput {
+        int value;
+        int count;
+    };
+
+    /* Queue of movie input changes that where pushed by the UI, to process by the main thread */
+    ConcurrentQueue<InputEvent> input_event_queue;
+
+    /* Index of the input changes that are still in the queue, by frame and
+     * single input, so that the UI does not have to scan the queue */
+    std::unordered_map<uint64_t, std::map<SingleInput, PendingInput>> pending_inputs;
+
+    /* Protect the pending index access */
+    std::mutex pending_mutex;
+
+    /* Number of input changes in the queue, to skip locking when empty */
+    std::atomic<int> pending_count;
+
     /* Read the keyboard input string */
     int readKeyboardFrame(std::istringstream& input_string, AllInputs& inputs);
 
@@ -0,0 +1,391 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "MovieFileJournal.h"
+#include "InputList.h"
+
+#include "Context.h"
+#include "../shared/inputs/AllInputs.h"
+#include "../shared/inputs/ControllerInputs.h"
+#include "../shared/inputs/MiscInputs.h"
+#include "../shared/inputs/MouseInputs.h"
+
+#include <iostream>
+#include <cstring>
+#include <fcntl.h> // O_RDWR, O_CREAT
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const char journal_magic[4] = {'L', 'T', 'M', 'J'};
+static const uint32_t journal_version = 1;
+
+MovieFileJournal::MovieFileJournal(Context* c) : context(c) {}
+
+void MovieFileJournal::baseHeader(Header& header, bool from_moviefile)
+{
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, journal_magic, sizeof(header.magic));
+    header.version = journal_version;
+
+    struct stat st;
+    if (from_moviefile && (stat(context->config.moviefile.c_str(), &st) == 0)) {
+        header.base_size = st.st_size;
+        header.base_mtime_sec = st.st_mtim.tv_sec;
+        header.base_mtime_nsec = st.st_mtim.tv_nsec;
+    }
+}
+
+int MovieFileJournal::open(bool from_moviefile, bool recover)
+{
+    path = context->config.moviefile + ".journal";
+
+    if (access(path.c_str(), F_OK) != 0)
+        return create(from_moviefile);
+
+    /* The movie is recorded from scratch, so the inputs of an interrupted
+     * recording would be overwritten right away */
+    if (!recover) {
+        moveAside("is not recovered when recording a new movie");
+        return create(from_moviefile);
+    }
+
+    /* Check for a journal left by an interrupted recording */
+    int oldfd = ::open(path.c_str(), O_RDONLY);
+    if (oldfd >= 0) {
+        struct stat st;
+        Header header, base;
+        baseHeader(base, from_moviefile);
+
+        bool valid = (fstat(oldfd, &st) == 0) &&
+            (read(oldfd, &header, sizeof(Header)) == sizeof(Header)) &&
+            (memcmp(&header, &base, sizeof(Header)) == 0);
+
+        if (valid && (st.st_size > static_cast<off_t>(sizeof(Header)))) {
+            recovered.resize(st.st_size - sizeof(Header));
+            ssize_t size = read(oldfd, recovered.data(), recovered.size());
+            recovered.resize(size > 0 ? size : 0);
+        }
+        ::close(oldfd);
+
+        if (valid) {
+            fd = ::open(path.c_str(), O_WRONLY | O_APPEND);
+            if (fd >= 0)
+                return 0;
+        }
+        else {
+            /* Keep it aside, we don't know which inputs it applies to */
+            moveAside("does not match the movie");
+        }
+    }
+
+    return create(from_moviefile);
+}
+
+bool MovieFileJournal::exists(const std::string& moviefile)
+{
+    if (moviefile.empty())
+        return false;
+
+    std::string journalpath = moviefile + ".journal";
+    return access(journalpath.c_str(), F_OK) == 0;
+}
+
+void MovieFileJournal::moveAside(const char* reason)
+{
+    std::string oldpath = path + ".old";
+    std::cerr << "Movie journal " << path << " " << reason << ", moved to " << oldpath << std::endl;
+    rename(path.c_str(), oldpath.c_str());
+}
+
+int MovieFileJournal::create(bool from_moviefile)
+{
+    if (fd >= 0)
+        ::close(fd);
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Could not create movie journal " << path << std::endl;
+        return -1;
+    }
+
+    Header header;
+    baseHeader(header, from_moviefile);
+    if (write(fd, &header, sizeof(Header)) != sizeof(Header)) {
+        std::cerr << "Could not write movie journal " << path << std::endl;
+        ::close(fd);
+        fd = -1;
+        return -1;
+    }
+    fdatasync(fd);
+    return 0;
+}
+
+uint64_t MovieFileJournal::replay(InputList& input_list)
+{
+    uint64_t nb_records = 0;
+    size_t off = 0;
+
+    while (off + sizeof(Record) <= recovered.size()) {
+        Record record;
+        memcpy(&record, &recovered[off], sizeof(Record));
+        size_t next = off + sizeof(Record);
+        bool valid = true;
+
+        switch (record.type) {
+            case RECORD_FRAME: {
+                AllInputs ai;
+                ai.clear();
+
+                size_t size = sizeof(uint32_t) * AllInputs::MAXKEYS;
+                if (record.flags & FRAME_POINTER)
+                    size += sizeof(MouseInputs);
+                if (record.flags & FRAME_MISC)
+                    size += sizeof(MiscInputs);
+                for (int j = 0; j < AllInputs::MAXJOYS; j++)
+                    if (record.flags & (FRAME_CONTROLLER1 << j))
+                        size += sizeof(ControllerInputs);
+
+                if ((next + size > recovered.size()) || (record.pos > input_list.size())) {
+                    valid = false;
+                    break;
+                }
+
+                memcpy(ai.keyboard.data(), &recovered[next], sizeof(uint32_t) * AllInputs::MAXKEYS);
+                next += sizeof(uint32_t) * AllInputs::MAXKEYS;
+                if (record.flags & FRAME_POINTER) {
+                    ai.pointer.reset(new MouseInputs{});
+                    memcpy(static_cast<void*>(ai.pointer.get()), &recovered[next], sizeof(MouseInputs));
+                    next += sizeof(MouseInputs);
+                }
+                if (record.flags & FRAME_MISC) {
+                    ai.misc.reset(new MiscInputs{});
+                    memcpy(static_cast<void*>(ai.misc.get()), &recovered[next], sizeof(MiscInputs));
+                    next += sizeof(MiscInputs);
+                }
+                for (int j = 0; j < AllInputs::MAXJOYS; j++) {
+                    if (record.flags & (FRAME_CONTROLLER1 << j)) {
+                        ai.controllers[j].reset(new ControllerInputs{});
+                        memcpy(static_cast<void*>(ai.controllers[j].get()), &recovered[next], sizeof(ControllerInputs));
+                        next += sizeof(ControllerInputs);
+                    }
+                }
+
+                if (record.pos == input_list.size())
+                    input_list.push_back(ai);
+                else
+                    input_list.at(record.pos) = ai;
+                break;
+            }
+            case RECORD_INPUT: {
+                if (record.pos >= input_list.size()) {
+                    valid = false;
+                    break;
+                }
+                SingleInput si;
+                si.type = record.input_type;
+                si.value = record.input_value;
+                input_list.at(record.pos).setInput(si, record.value);
+                break;
+            }
+            case RECORD_TRUNCATE:
+                input_list.truncate(record.count);
+                break;
+            case RECORD_INSERT: {
+                if (record.pos > input_list.size()) {
+                    valid = false;
+                    break;
+                }
+                AllInputs ai;
+                ai.clear();
+                input_list.insert(record.pos, ai, record.count);
+                break;
+            }
+            case RECORD_ERASE:
+                if (record.pos + record.count > input_list.size()) {
+                    valid = false;
+                    break;
+                }
+                input_list.erase(record.pos, record.count);
+                break;
+            default:
+                valid = false;
+                break;
+        }
+
+        if (!valid)
+            break;
+
+        off = next;
+        nb_records++;
+    }
+
+    /* Drop a record that was partially written when the recording was
+     * interrupted, so that new records follow the last valid one */
+    if (fd >= 0) {
+        if (ftruncate(fd, sizeof(Header) + off) == 0)
+            lseek(fd, 0, SEEK_END);
+    }
+
+    recovered.clear();
+    recovered.shrink_to_fit();
+    return nb_records;
+}
+
+void MovieFileJournal::reset()
+{
+    if (fd < 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(buffer_mutex);
+        buffer.clear();
+    }
+    unsynced = false;
+    create(true);
+}
+
+void MovieFileJournal::flush()
+{
+    if (fd < 0)
+        return;
+
+    std::vector<char> pending;
+    {
+        std::lock_guard<std::mutex> lock(buffer_mutex);
+        if (buffer.empty() && !unsynced)
+            return;
+        pending.swap(buffer);
+    }
+
+    if (!pending.empty()) {
+        size_t off = 0;
+        while (off < pending.size()) {
+            ssize_t ret = write(fd, pending.data() + off, pending.size() - off);
+            if (ret <= 0) {
+                std::cerr << "Could not write movie journal " << path << std::endl;
+                break;
+            }
+            off += ret;
+        }
+        unsynced = true;
+    }
+
+    /* Writing each frame survives a crash of the program, syncing in batches
+     * survives a crash of the system without a sync per frame */
+    time_t now = time(nullptr);
+    if (difftime(now, last_sync) >= SYNC_PERIOD_SEC) {
+        fdatasync(fd);
+        last_sync = now;
+        unsynced = false;
+    }
+}
+
+void MovieFileJournal::close()
+{
+    if (fd < 0)
+        return;
+
+    ::close(fd);
+    fd = -1;
+    unlink(path.c_str());
+
+    std::lock_guard<std::mutex> lock(buffer_mutex);
+    buffer.clear();
+}
+
+void MovieFileJournal::append(const void* data, size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+void MovieFileJournal::appendRecord(const Record& record)
+{
+    if (fd < 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(buffer_mutex);
+    append(&record, sizeof(Record));
+}
+
+void MovieFileJournal::setFrame(uint64_t pos, const AllInputs& inputs)
+{
+    if (fd < 0)
+        return;
+
+    Record record = {};
+    record.type = RECORD_FRAME;
+    record.pos = pos;
+    if (inputs.pointer)
+        record.flags |= FRAME_POINTER;
+    if (inputs.misc)
+        record.flags |= FRAME_MISC;
+    for (int j = 0; j < AllInputs::MAXJOYS; j++)
+        if (inputs.controllers[j])
+            record.flags |= (FRAME_CONTROLLER1 << j);
+
+    std::lock_guard<std::mutex> lock(buffer_mutex);
+    append(&record, sizeof(Record));
+    append(inputs.keyboard.data(), sizeof(uint32_t) * AllInputs::MAXKEYS);
+    if (inputs.pointer)
+        append(inputs.pointer.get(), sizeof(MouseInputs));
+    if (inputs.misc)
+        append(inputs.misc.get(), sizeof(MiscInputs));
+    for (int j = 0; j < AllInputs::MAXJOYS; j++)
+        if (inputs.controllers[j])
+            append(inputs.controllers[j].get(), sizeof(ControllerInputs));
+}
+
+void MovieFileJournal::setInput(uint64_t pos, const SingleInput& si, int value)
+{
+    Record record = {};
+    record.type = RECORD_INPUT;
+    record.pos = pos;
+    record.input_type = si.type;
+    record.input_value = si.value;
+    record.value = value;
+    appendRecord(record);
+}
+
+void MovieFileJournal::truncate(uint64_t size)
+{
+    Record record = {};
+    record.type = RECORD_TRUNCATE;
+    record.count = size;
+    appendRecord(record);
+}
+
+void MovieFileJournal::insert(uint64_t pos, uint64_t count)
+{
+    Record record = {};
+    record.type = RECORD_INSERT;
+    record.pos = pos;
+    record.count = count;
+    appendRecord(record);
+}
+
+void MovieFileJournal::erase(uint64_t pos, uint64_t count)
+{
+    Record record = {};
+    record.type = RECORD_ERASE;
+    record.pos = pos;
+    record.count = count;
+    appendRecord(record);
+}
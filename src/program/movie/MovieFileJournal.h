@@ -0,0 +1,144 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBTAS_MOVIEFILEJOURNAL_H_INCLUDED
+#define LIBTAS_MOVIEFILEJOURNAL_H_INCLUDED
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <ctime>
+#include <stdint.h>
+
+class AllInputs;
+class SingleInput;
+class InputList;
+struct Context;
+
+/* Append-only binary journal of the changes made to the movie inputs since
+ * the movie file was last saved. It is stored next to the movie file, so that
+ * a recording interrupted by a crash can be recovered when opening the movie
+ * again. Persisting a frame only costs the changes made in that frame, the
+ * whole movie is only written on explicit save. */
+class MovieFileJournal {
+public:
+    MovieFileJournal(Context* c);
+
+    /* Open the journal of the current movie file, based on the inputs that were
+     * loaded from the movie file, or on empty inputs. If `recover` is set, a
+     * journal left by an interrupted recording is kept if it has the same
+     * base, and must be applied with replay(). Otherwise it is moved aside
+     * and a new journal is started.
+     * Returns 0 on success, or -1 if the journal could not be opened */
+    int open(bool from_moviefile, bool recover);
+
+    /* Is there a journal left by an interrupted recording of the movie file */
+    static bool exists(const std::string& moviefile);
+
+    /* Apply the changes of a journal left by an interrupted recording to the
+     * input list. Returns the number of applied changes */
+    uint64_t replay(InputList& input_list);
+
+    /* Start an empty journal, after the movie file was saved */
+    void reset();
+
+    /* Write pending changes to the journal, and sync them to disk at most
+     * once per SYNC_PERIOD_SEC */
+    void flush();
+
+    /* Remove the journal when the movie is closed normally */
+    void close();
+
+    /* Record changes to the inputs */
+    void setFrame(uint64_t pos, const AllInputs& inputs);
+    void setInput(uint64_t pos, const SingleInput& si, int value);
+    void truncate(uint64_t size);
+    void insert(uint64_t pos, uint64_t count);
+    void erase(uint64_t pos, uint64_t count);
+
+private:
+    Context* context;
+
+    static const int SYNC_PERIOD_SEC = 1;
+
+    enum RecordType {
+        RECORD_FRAME = 1, // full frame at pos, followed by the frame data
+        RECORD_INPUT, // single input of frame pos
+        RECORD_TRUNCATE, // shrink the list to count frames
+        RECORD_INSERT, // insert count blank frames before pos
+        RECORD_ERASE, // remove count frames starting at pos
+    };
+
+    /* Objects of the frame that follow a frame record */
+    enum FrameFlag {
+        FRAME_POINTER = 0x01,
+        FRAME_MISC = 0x02,
+        FRAME_CONTROLLER1 = 0x04, // next flags are for the other controllers
+    };
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        /* Identify the movie file that the journal applies to, zero if the
+         * journal applies to empty inputs */
+        int64_t base_size;
+        int64_t base_mtime_sec;
+        int64_t base_mtime_nsec;
+    };
+
+    struct Record {
+        uint32_t type;
+        uint32_t flags;
+        uint64_t pos;
+        uint64_t count;
+        int32_t input_type;
+        uint32_t input_value;
+        int32_t value;
+        uint32_t padding;
+    };
+
+    std::string path;
+    int fd = -1;
+
+    /* Records that were not written yet. Inputs can be modified by both the
+     * main and UI threads */
+    std::vector<char> buffer;
+    std::mutex buffer_mutex;
+
+    /* Content of a journal to replay */
+    std::vector<char> recovered;
+
+    bool unsynced = false;
+    time_t last_sync = 0;
+
+    /* Fill the header from the current movie file */
+    void baseHeader(Header& header, bool from_moviefile);
+
+    /* Move the existing journal aside, so that it is not overwritten */
+    void moveAside(const char* reason);
+
+    /* Create the journal file with a new header */
+    int create(bool from_moviefile);
+
+    void append(const void* data, size_t size);
+    void appendRecord(const Record& record);
+};
+
+#endif
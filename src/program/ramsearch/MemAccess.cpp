@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 #include <iostream>
+#include <algorithm>
 #ifdef __unix__
 #include <sys/uio.h>
 #elif defined(__APPLE__) && defined(__MACH__)
@@ -82,6 +83,47 @@ size_t MemAccess::read(void* local_addr, void* remote_addr, size_t size)
 #endif
 }
 
+size_t MemAccess::readBatch(void* const local_addrs[], void* const remote_addrs[], const size_t sizes[], int count)
+{
+    if (!game_pid)
+        return 0;
+
+#ifdef __unix__
+    /* process_vm_readv() accepts at most IOV_MAX vectors per call */
+    const int batch = 1024;
+    size_t total = 0;
+    struct iovec local[batch], remote[batch];
+    for (int i = 0; i < count; i += batch) {
+        int n = std::min(batch, count - i);
+        size_t expected = 0;
+        for (int j = 0; j < n; j++) {
+            local[j].iov_base = local_addrs[i+j];
+            local[j].iov_len = sizes[i+j];
+            remote[j].iov_base = remote_addrs[i+j];
+            remote[j].iov_len = sizes[i+j];
+            expected += sizes[i+j];
+        }
+
+        ssize_t ret = process_vm_readv(game_pid, local, n, remote, n, 0);
+        if (ret <= 0)
+            return total;
+        total += ret;
+        if (static_cast<size_t>(ret) != expected)
+            return total;
+    }
+    return total;
+#elif defined(__APPLE__) && defined(__MACH__)
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        size_t ret = read(local_addrs[i], remote_addrs[i], sizes[i]);
+        total += ret;
+        if (ret != sizes[i])
+            return total;
+    }
+    return total;
+#endif
+}
+
 uintptr_t MemAccess::readAddr(void* remote_addr, bool* valid)
 {
     if (game_addr_size == 4) {
@@ -35,6 +35,10 @@ namespace MemAccess {
     size_t read(void* local_addr, void* remote_addr, size_t size);
     size_t readAddr(void* local_addr, bool* valid);
 
+    /* Read `count` areas of game memory at once. Returns the total number of
+     * bytes read, which stops at the first area that could not be read */
+    size_t readBatch(void* const local_addrs[], void* const remote_addrs[], const size_t sizes[], int count);
+
     size_t write(void* local_addr, void* remote_addr, size_t size);    
 }
 
@@ -148,32 +148,23 @@ QVariant InputEditorModel::data(const QModelIndex &index, int role) const
         const SingleInput si = movie->editor->input_set[index.column()-COLUMN_SPECIAL_SIZE];
 
         /* Show inputs with transparancy when they are pending due to rewind */
-        bool pending_input = false;
-        movie->inputs->input_event_queue.lock();
-        for (auto it = movie->inputs->input_event_queue.begin(); it != movie->inputs->input_event_queue.end(); it++) {
-            if (it->framecount != row)
-                continue;
-
-            if (si == it->si) {
-                pending_input = true;
-                /* For analog, use half-transparancy. Otherwise,
-                 * use strong/weak transparancy of set/clear input */
-                if (si.isAnalog()) {
-                    color.setAlpha(128);
+        int pending_value;
+        bool pending_input = movie->inputs->getPendingInput(row, si, pending_value);
+        if (pending_input) {
+            /* For analog, use half-transparancy. Otherwise,
+             * use strong/weak transparancy of set/clear input */
+            if (si.isAnalog()) {
+                color.setAlpha(128);
+            }
+            else {
+                if (pending_value) {
+                    color.setAlpha(192);
                 }
                 else {
-                    if (it->value) {
-                        color.setAlpha(192);
-                    }
-                    else {
-                        color.setAlpha(64);
-                    }
+                    color.setAlpha(64);
                 }
-                /* We don't return the brush immediatly, because users may change
-                 * multiple times the same input. */
             }
         }
-        movie->inputs->input_event_queue.unlock();
 
         /* If hovering on the cell, show a preview of the input for the following:
          * - the cell is blank
@@ -313,23 +304,18 @@ QVariant InputEditorModel::data(const QModelIndex &index, int role) const
         }
 
         /* If the value is currently being modified, load the new value */
-        movie->inputs->input_event_queue.lock();
-        for (auto it = movie->inputs->input_event_queue.begin(); it != movie->inputs->input_event_queue.end(); it++) {
-            if (it->framecount != row)
-                continue;
-            if (si == it->si) {
-                if (si.isAnalog()) {
-                    value = it->value;
-                }
-                else {
-                    /* For non-analog values, always print the value, and the
-                     * transparancy value will indicate if the value is being
-                     * cleared or set. */
-                    value = 1;
-                }
+        int pending_value;
+        if (movie->inputs->getPendingInput(row, si, pending_value)) {
+            if (si.isAnalog()) {
+                value = pending_value;
+            }
+            else {
+                /* For non-analog values, always print the value, and the
+                 * transparancy value will indicate if the value is being
+                 * cleared or set. */
+                value = 1;
             }
         }
-        movie->inputs->input_event_queue.unlock();
 
         if (si.isAnalog()) {
             /* Default framerate has a value of 0, which may be confusing,
@@ -425,7 +411,7 @@ bool InputEditorModel::setData(const QModelIndex &index, const QVariant &value,
         ie.framecount = row;
         ie.si = si;
         ie.value = value.toInt();
-        movie->inputs->input_event_queue.push(ie);
+        movie->inputs->queueEvent(ie);
         emit dataChanged(index, index, {role});
         return true;
     }
@@ -512,7 +498,7 @@ bool InputEditorModel::toggleInput(const QModelIndex &index)
     ie.framecount = row;
     ie.si = si;
     ie.value = !ai.getInput(si);
-    movie->inputs->input_event_queue.push(ie);
+    movie->inputs->queueEvent(ie);
     emit dataChanged(index, index);
     return ie.value;
 }
@@ -830,7 +816,7 @@ void InputEditorModel::clearUniqueInput(int column)
         ie.framecount = f;
         ie.si = si;
         ie.value = 0;
-        movie->inputs->input_event_queue.push(ie);
+        movie->inputs->queueEvent(ie);
     }
 }
 
@@ -851,7 +837,7 @@ bool InputEditorModel::removeUniqueInput(int column)
         ie.framecount = f;
         ie.si = si;
         ie.value = 0;
-        movie->inputs->input_event_queue.push(ie);
+        movie->inputs->queueEvent(ie);
     }
 
     /* Remove clear locked state */
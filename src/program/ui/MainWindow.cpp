@@ -588,6 +588,14 @@ void MainWindow::createActions()
     addActionCheckable(fastforwardRenderGroup, tr("Skipping no rendering"), SharedConfig::FF_RENDER_ALL);
     addActionCheckable(fastforwardRenderGroup, tr("Skipping most rendering"), SharedConfig::FF_RENDER_SOME);
     addActionCheckable(fastforwardRenderGroup, tr("Skipping all rendering"), SharedConfig::FF_RENDER_NO);
+
+    fastforwardRateGroup = new QActionGroup(this);
+    connect(fastforwardRateGroup, &QActionGroup::triggered, this, LAMBDARADIOSLOT(fastforwardRateGroup, context->config.sc.fastforward_display_rate));
+
+    addActionCheckable(fastforwardRateGroup, tr("Displaying 4 frames per second"), 4);
+    addActionCheckable(fastforwardRateGroup, tr("Displaying 8 frames per second"), 8);
+    addActionCheckable(fastforwardRateGroup, tr("Displaying 15 frames per second"), 15);
+    addActionCheckable(fastforwardRateGroup, tr("Displaying 30 frames per second"), 30);
 }
 
 void MainWindow::createMenus()
@@ -662,6 +670,8 @@ void MainWindow::createMenus()
     fastforwardMenu->addActions(fastforwardGroup->actions());
     fastforwardMenu->addSeparator();
     fastforwardMenu->addActions(fastforwardRenderGroup->actions());
+    fastforwardMenu->addSeparator();
+    fastforwardMenu->addActions(fastforwardRateGroup->actions());
 
     toolsMenu->addSeparator();
 
@@ -1009,6 +1019,7 @@ void MainWindow::updateUIFromConfig()
 
     setCheckboxesFromMask(fastforwardGroup, context->config.sc.fastforward_mode);
     setRadioFromList(fastforwardRenderGroup, context->config.sc.fastforward_render);
+    setRadioFromList(fastforwardRateGroup, context->config.sc.fastforward_display_rate);
 
     switch (context->config.debugger) {
     case Config::DEBUGGER_GDB:
@@ -116,6 +116,7 @@ public:
     QActionGroup *slowdownGroup;
     QActionGroup *fastforwardGroup;
     QActionGroup *fastforwardRenderGroup;
+    QActionGroup *fastforwardRateGroup;
 
     QAction *mouseModeAction;
 
@@ -33,8 +33,13 @@
 
 TimeTraceModel::TimeTraceModel(Context* c, QObject *parent) : QAbstractTableModel(parent), context(c) {}
 
-void TimeTraceModel::addCall(int type, unsigned long long hash, std::string stacktrace)
+void TimeTraceModel::addCall(int type, unsigned long long hash, unsigned int count, std::string stacktrace)
 {
+    if (stacktrace.empty())
+        stacktrace = stacktraces[hash];
+    else
+        stacktraces[hash] = stacktrace;
+
     auto it = time_calls_map.find(hash);
     if (it != time_calls_map.end()) {
         if ((!stacktrace.empty()) && stacktrace.compare(it->second.stacktrace) != 0) {
@@ -44,13 +49,13 @@ void TimeTraceModel::addCall(int type, unsigned long long hash, std::string stac
             std::cerr << "New trace:" << std::endl;
             std::cerr << stacktrace << std::endl;
         }
-        it->second.count++;
+        it->second.count += count;
         /* TODO: Get the row index? */
         emit dataChanged(index(0,1), index(rowCount()-1,1));
     }
     else {
         beginInsertRows(QModelIndex(), time_calls_map.size(), time_calls_map.size());
-        time_calls_map[hash] = {type, 1, stacktrace};
+        time_calls_map[hash] = {type, count, stacktrace};
         endInsertRows();
     }
 }
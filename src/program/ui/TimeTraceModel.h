@@ -52,11 +52,15 @@ public:
     void clearData();
 
 public slots:
-    void addCall(int type, unsigned long long hash, std::string stacktrace);
+    void addCall(int type, unsigned long long hash, unsigned int count, std::string stacktrace);
 
 private:
     Context *context;
 
+    /* Stack traces of all received hashes, which are only sent once by the
+     * game, so that they are kept when clearing the table */
+    std::map<uint64_t,std::string> stacktraces;
+
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
@@ -70,6 +70,8 @@ void DebugPane::initLayout()
     logToChoice->addItem(tr("Log to console"), SharedConfig::LOGGING_TO_CONSOLE);
     logToChoice->addItem(tr("Log to file"), SharedConfig::LOGGING_TO_FILE);
 
+    logAsyncBox = new ToolTipCheckBox(tr("Asynchronous logging"));
+
     QGroupBox* logPrintBox = new QGroupBox(tr("Print"));
     QGridLayout* logPrintLayout = new QGridLayout;
     logPrintBox->setLayout(logPrintLayout);
@@ -219,6 +221,7 @@ void DebugPane::initLayout()
     logExcludeLayout->addWidget(logExcludeWineBox, 5, 4);
     
     logLayout->addWidget(logToChoice);
+    logLayout->addWidget(logAsyncBox);
     logLayout->addWidget(logPrintBox);
     logLayout->addWidget(logExcludeBox);
 
@@ -239,6 +242,7 @@ void DebugPane::initSignals()
     connect(debugInetBox, &QAbstractButton::clicked, this, &DebugPane::saveConfig);
     connect(debugSigIntBox, &QAbstractButton::clicked, this, &DebugPane::saveConfig);
     connect(logToChoice, static_cast<void (QComboBox::*)(int)>(&QComboBox::activated), this, &DebugPane::saveConfig);
+    connect(logAsyncBox, &QAbstractButton::clicked, this, &DebugPane::saveConfig);
 
     connect(logPrintMainBox, &QAbstractButton::clicked, this, &DebugPane::saveConfig);
     connect(logPrintFrequentBox, &QAbstractButton::clicked, this, &DebugPane::saveConfig);
@@ -323,6 +327,13 @@ void DebugPane::initToolTips()
     "games to access to device files, such as reading joystick events, or the hardware random generator.");
 
     debugInetBox->setDescription("Let the game access the internet, only for debugging purpose.");
+
+    logAsyncBox->setDescription("Log messages are sent in a compact form to the program, "
+    "which formats and prints them in a separate thread. This greatly reduces the "
+    "cost of logging frequent messages.<br><br>"
+    "Errors and warnings are still printed immediately. Other messages "
+    "are not shown in the in-game log window, and may be printed with a small delay. "
+    "Changes apply when the game is restarted.");
 }
 
 void DebugPane::showEvent(QShowEvent *event)
@@ -342,6 +353,7 @@ void DebugPane::loadConfig()
     int index = logToChoice->findData(context->config.sc.logging_status);
     if (index >= 0)
         logToChoice->setCurrentIndex(index);
+    logAsyncBox->setChecked(context->config.sc.async_logging);
         
     logPrintMainBox->setChecked(context->config.sc.includeFlags & LCF_MAINTHREAD);
     logPrintFrequentBox->setChecked(context->config.sc.includeFlags & LCF_FREQUENT);
@@ -424,6 +436,7 @@ void DebugPane::saveConfig()
     context->config.sc.sigint_upon_launch = debugSigIntBox->isChecked();
 
     context->config.sc.logging_status = logToChoice->currentData().toInt();
+    context->config.sc.async_logging = logAsyncBox->isChecked();
     
     context->config.sc.includeFlags = 0;
     context->config.sc.includeFlags |= logPrintMainBox->isChecked() ? LCF_MAINTHREAD : 0;
@@ -56,6 +56,7 @@ private:
     QCheckBox* debugSigIntBox;
 
     QComboBox* logToChoice;
+    ToolTipCheckBox* logAsyncBox;
 
     QCheckBox* logPrintMainBox;
     QCheckBox* logPrintFrequentBox;
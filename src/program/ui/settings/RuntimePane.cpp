@@ -21,6 +21,7 @@
 #include "tooltip/ToolTipComboBox.h"
 #include "tooltip/ToolTipCheckBox.h"
 #include "tooltip/ToolTipGroupBox.h"
+#include "tooltip/ToolTipSpinBox.h"
 
 #include "Context.h"
 
@@ -74,12 +75,21 @@ void RuntimePane::initLayout()
     recycleBox = new ToolTipCheckBox(tr("Recycle threads"));
 #endif
 #endif
+    threadPoolSize = new ToolTipSpinBox();
+    threadPoolSize->setMaximum(256);
+
+    QFormLayout* threadPoolLayout = new QFormLayout;
+    threadPoolLayout->setFormAlignment(Qt::AlignLeft | Qt::AlignTop);
+    threadPoolLayout->setFieldGrowthPolicy(QFormLayout::AllNonFixedFieldsGrow);
+    threadPoolLayout->addRow(new QLabel(tr("Idle threads created at startup:")), threadPoolSize);
+
     steamBox = new ToolTipCheckBox(tr("Virtual Steam client"));
     downloadsBox = new ToolTipCheckBox(tr("Allow downloading missing libraries"));
 
     generalLayout->addLayout(localeLayout);
     generalLayout->addWidget(writingBox);
     generalLayout->addWidget(recycleBox);
+    generalLayout->addLayout(threadPoolLayout);
     generalLayout->addWidget(steamBox);
     generalLayout->addWidget(downloadsBox);
     
@@ -97,6 +107,7 @@ void RuntimePane::initLayout()
     stateCompressedBox = new ToolTipCheckBox(tr("Compressed savestates"));
     stateUnmappedBox = new ToolTipCheckBox(tr("Skip unmapped pages"));
     stateForkBox = new ToolTipCheckBox(tr("Fork to save states"));
+    stateFilePagesBox = new ToolTipCheckBox(tr("Skip unmodified file pages"));
 
     savestateLayout->addWidget(stateIncrementalBox, 0, 0);
     savestateLayout->addWidget(stateRamBox, 0, 1);
@@ -104,6 +115,7 @@ void RuntimePane::initLayout()
     savestateLayout->addWidget(stateCompressedBox, 1, 1);
     savestateLayout->addWidget(stateUnmappedBox, 2, 0);
     savestateLayout->addWidget(stateForkBox, 2, 1);
+    savestateLayout->addWidget(stateFilePagesBox, 3, 0);
 
     timingBox = new QGroupBox(tr("Timing"));
     QVBoxLayout* timingMainLayout = new QVBoxLayout;
@@ -191,6 +203,7 @@ void RuntimePane::initSignals()
 
     connect(writingBox, &QAbstractButton::clicked, this, &RuntimePane::saveConfig);
     connect(recycleBox, &QAbstractButton::clicked, this, &RuntimePane::saveConfig);
+    connect(threadPoolSize, QOverload<int>::of(&QSpinBox::valueChanged), this, &RuntimePane::saveConfig);
     connect(steamBox, &QAbstractButton::clicked, this, &RuntimePane::saveConfig);
     connect(downloadsBox, &QAbstractButton::clicked, this, &RuntimePane::saveConfig);
 
@@ -200,6 +213,7 @@ void RuntimePane::initSignals()
     connect(stateCompressedBox, &QAbstractButton::clicked, this, &RuntimePane::saveConfig);
     connect(stateUnmappedBox, &QAbstractButton::clicked, this, &RuntimePane::saveConfig);
     connect(stateForkBox, &QAbstractButton::clicked, this, &RuntimePane::saveConfig);
+    connect(stateFilePagesBox, &QAbstractButton::clicked, this, &RuntimePane::saveConfig);
 
     connect(trackingTimeBox, &QAbstractButton::clicked, this, &RuntimePane::saveConfig);
     connect(trackingGettimeofdayBox, &QAbstractButton::clicked, this, &RuntimePane::saveConfig);
@@ -236,6 +250,13 @@ void RuntimePane::initToolTips()
     "savestates more useable. Can crash on some games."
     "<br><br><em>If unsure, leave this unchecked</em>");
 
+    threadPoolSize->setTitle("Idle threads created at startup");
+    threadPoolSize->setDescription("When recycling threads, create this number "
+    "of threads waiting to be recycled when the game starts. Games that create "
+    "many short-lived threads will then reuse them instead of creating new "
+    "threads, which invalidates savestates."
+    "<br><br><em>If unsure, leave this to 0</em>");
+
     steamBox->setDescription("Implement a dummy Steam client, to be able to "
     "launch Steam games that require a connection to the Steam server. Almost none "
     "of the actual Steam features are implemented in this dummy client.");
@@ -279,6 +300,13 @@ void RuntimePane::initToolTips()
     "Linux copy-on-write magic. Useful for games that take a long time to save."
     "<br><br><em>If unsure, leave this unchecked</em>");
 
+    stateFilePagesBox->setDescription("Don't store the pages of privately mapped "
+    "files (game executable, libraries, assets) that were not modified. They are "
+    "read back from the files when loading a state, which gives much smaller "
+    "savestates for games that map large files. Files must not be modified "
+    "between saving and loading a state."
+    "<br><br><em>If unsure, leave this unchecked</em>");
+
     trackingBox->setDescription("By checking a specific function, time will advance "
     "a bit when too many calls of that function have been made from the main thread. "
     "This prevents softlocks when a game wait in a loop for time to advance.<br><br>"
@@ -372,6 +400,9 @@ void RuntimePane::loadConfig()
 
     writingBox->setChecked(context->config.sc.prevent_savefiles);
     recycleBox->setChecked(context->config.sc.recycle_threads);
+    threadPoolSize->blockSignals(true);
+    threadPoolSize->setValue(context->config.sc.thread_pool_size);
+    threadPoolSize->blockSignals(false);
     steamBox->setChecked(context->config.sc.virtual_steam);
     downloadsBox->setChecked(context->config.allow_downloads);
 
@@ -381,6 +412,7 @@ void RuntimePane::loadConfig()
     stateCompressedBox->setChecked(context->config.sc.savestate_settings & SharedConfig::SS_COMPRESSED);
     stateUnmappedBox->setChecked(context->config.sc.savestate_settings & SharedConfig::SS_PRESENT);
     stateForkBox->setChecked(context->config.sc.savestate_settings & SharedConfig::SS_FORK);
+    stateFilePagesBox->setChecked(context->config.sc.savestate_settings & SharedConfig::SS_FILEPAGES);
 
     trackingTimeBox->setChecked(context->config.sc.main_gettimes_threshold[SharedConfig::TIMETYPE_TIME] != -1);
     trackingGettimeofdayBox->setChecked(context->config.sc.main_gettimes_threshold[SharedConfig::TIMETYPE_GETTIMEOFDAY] != -1);
@@ -416,6 +448,7 @@ void RuntimePane::saveConfig()
 
     context->config.sc.prevent_savefiles = writingBox->isChecked();
     context->config.sc.recycle_threads = recycleBox->isChecked();
+    context->config.sc.thread_pool_size = threadPoolSize->value();
     context->config.sc.virtual_steam = steamBox->isChecked();
     context->config.allow_downloads = downloadsBox->isChecked();
 
@@ -426,6 +459,7 @@ void RuntimePane::saveConfig()
     context->config.sc.savestate_settings |= stateCompressedBox->isChecked() ? SharedConfig::SS_COMPRESSED : 0;
     context->config.sc.savestate_settings |= stateUnmappedBox->isChecked() ? SharedConfig::SS_PRESENT : 0;
     context->config.sc.savestate_settings |= stateForkBox->isChecked() ? SharedConfig::SS_FORK : 0;
+    context->config.sc.savestate_settings |= stateFilePagesBox->isChecked() ? SharedConfig::SS_FILEPAGES : 0;
 
     context->config.sc.main_gettimes_threshold[SharedConfig::TIMETYPE_TIME] = trackingTimeBox->isChecked() ? 100 : -1;
     context->config.sc.main_gettimes_threshold[SharedConfig::TIMETYPE_GETTIMEOFDAY] = trackingGettimeofdayBox->isChecked() ? 100 : -1;
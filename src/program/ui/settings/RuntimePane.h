@@ -28,6 +28,7 @@ class QCheckBox;
 class ToolTipComboBox;
 class ToolTipCheckBox;
 class ToolTipGroupBox;
+class ToolTipSpinBox;
 class QGroupBox;
 
 class RuntimePane : public QWidget {
@@ -54,6 +55,7 @@ private:
 
     ToolTipCheckBox* writingBox;
     ToolTipCheckBox* recycleBox;
+    ToolTipSpinBox* threadPoolSize;
     ToolTipCheckBox* steamBox;
     ToolTipCheckBox* downloadsBox;
 
@@ -63,6 +65,7 @@ private:
     ToolTipCheckBox* stateCompressedBox;
     ToolTipCheckBox* stateUnmappedBox;
     ToolTipCheckBox* stateForkBox;
+    ToolTipCheckBox* stateFilePagesBox;
 
     ToolTipGroupBox* trackingBox;
 
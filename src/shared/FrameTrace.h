@@ -0,0 +1,77 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBTAS_FRAMETRACE_H_INCLUDED
+#define LIBTAS_FRAMETRACE_H_INCLUDED
+
+#include <cstdint>
+
+/* Per-frame timeline of the phases of a frame inside the game process, sent
+ * to the program when frame tracing is enabled. A record covers the game
+ * execution following the previous frame boundary, and the whole frame
+ * boundary itself. Timestamps use CLOCK_MONOTONIC, so that they can be
+ * compared with the program timestamps. Both the 32-bit and the 64-bit
+ * versions of the library must share this exact layout. */
+namespace FrameTrace {
+
+enum GamePhase {
+    GAME_RUN, // game code between two frame boundaries
+    GAME_SYNC, // waiting for events and game threads
+    GAME_TIMER, // deterministic timer update and sleep
+    GAME_AUDIO, // audio mixing
+    GAME_SEND, // sending frame informations to the program
+    GAME_WAIT, // waiting for the program to process the frame boundary
+    GAME_HUD, // screen capture, HUD and encoding
+    GAME_DRAW, // native draw call
+    GAME_RECEIVE, // receiving inputs and config from the program
+    GAME_EVENTS, // generating input events
+    GAME_PHASES,
+};
+
+enum {
+    MAX_SEGMENTS = 32,
+};
+
+struct Segment {
+    uint64_t start; // in nanoseconds
+    uint32_t duration; // in nanoseconds
+    uint32_t phase;
+};
+
+struct Record {
+    uint64_t framecount;
+    uint32_t segment_count;
+    uint32_t unused;
+    Segment segments[MAX_SEGMENTS];
+};
+
+static_assert(sizeof(Record) == 16 + 16*MAX_SEGMENTS, "FrameTrace::Record must have the same size on all archs");
+
+inline const char* gamePhaseName(int phase)
+{
+    static const char* names[GAME_PHASES] = {"Game", "Sync", "Timer", "Audio",
+        "Send", "Wait", "HUD", "Draw", "Receive", "Events"};
+    if (phase < 0 || phase >= GAME_PHASES)
+        return "Unknown";
+    return names[phase];
+}
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "LogRing.h"
+
+#include <cstring>
+
+namespace LogRing {
+
+bool nextConversion(const char* fmt, Conversion& c)
+{
+    const char* p = fmt;
+    while (true) {
+        p = strchr(p, '%');
+        if (!p)
+            return false;
+
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        break;
+    }
+
+    c.begin = p++;
+    c.stars = 0;
+    c.length = 0;
+
+    /* Flags */
+    while (*p && strchr("-+ #0'", *p))
+        p++;
+
+    /* Width */
+    if (*p == '*') {
+        c.stars++;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9')
+        p++;
+
+    /* Precision */
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            c.stars++;
+            p++;
+        }
+        while (*p >= '0' && *p <= '9')
+            p++;
+    }
+
+    /* Length modifier */
+    switch (*p) {
+        case 'h':
+            p++;
+            c.length = 'h';
+            if (*p == 'h') {
+                p++;
+                c.length = 'H';
+            }
+            break;
+        case 'l':
+            p++;
+            c.length = 'l';
+            if (*p == 'l') {
+                p++;
+                c.length = 'q';
+            }
+            break;
+        case 'q':
+        case 'L':
+        case 'j':
+        case 'z':
+        case 't':
+            c.length = *p++;
+            break;
+        default:
+            break;
+    }
+
+    c.conv = *p;
+    c.end = (*p) ? (p + 1) : p;
+    return true;
+}
+
+int argType(const Conversion& c)
+{
+    switch (c.conv) {
+        case 'd':
+        case 'i':
+        case 'c':
+            return ARG_INT;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            return ARG_UINT;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            return ARG_DOUBLE;
+        case 's':
+            return ARG_STRING;
+        case 'p':
+            return ARG_POINTER;
+        default:
+            return 0;
+    }
+}
+
+}
@@ -0,0 +1,120 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LIBTAS_LOGRING_H_INCLUDED
+#define LIBTAS_LOGRING_H_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/* Layout of the shared memory object used for asynchronous logging.
+ * Each game thread owns a single-producer single-consumer ring of compact
+ * binary records, which are drained and formatted by the program. Strings
+ * that live in the game binary (format string, source file) are only passed
+ * by address and read back by the program. Both the 32-bit and the 64-bit
+ * versions of the library must share this exact layout. */
+namespace LogRing {
+
+enum {
+    MAGIC = 0x4C544C52,
+    RING_COUNT = 64,
+    RING_RECORDS = 256, // must be a power of two
+    PAYLOAD_SIZE = 216,
+};
+
+/* Type of each encoded argument inside the record payload */
+enum ArgType {
+    ARG_INT = 1, // int64_t
+    ARG_UINT, // uint64_t
+    ARG_DOUBLE, // double
+    ARG_STRING, // uint16_t length, then chars without the null terminator
+    ARG_POINTER, // uint64_t
+};
+
+enum RecordFlag {
+    REC_MAINTHREAD = 0x01, // record was pushed by the main thread
+    REC_TRUNCATED = 0x02, // some arguments did not fit in the payload
+};
+
+struct Record {
+    uint64_t fmt; // address of the format string in the game process
+    uint64_t file; // address of the source file name in the game process
+    uint64_t framecount;
+    int32_t lcf;
+    int32_t tid;
+    int32_t line;
+    uint16_t payload_size;
+    uint8_t flags;
+    uint8_t unused;
+    uint8_t payload[PAYLOAD_SIZE];
+};
+
+struct alignas(64) Ring {
+    /* Index of the next record to write, only modified by the owning thread */
+    alignas(64) std::atomic<uint32_t> head;
+
+    /* Index of the next record to read, only modified by the program */
+    alignas(64) std::atomic<uint32_t> tail;
+
+    /* Tid of the thread owning this ring, or 0 if free */
+    std::atomic<int32_t> owner;
+
+    Record records[RING_RECORDS];
+};
+
+struct alignas(64) Layout {
+    uint32_t magic;
+    uint32_t ring_count;
+    uint32_t ring_records;
+    uint32_t record_size;
+
+    /* Futex word that the program sleeps on when all rings are empty */
+    std::atomic<uint32_t> wake_seq;
+
+    /* Set while the program sleeps, so that threads only issue a wake
+     * syscall when needed */
+    std::atomic<uint32_t> reader_waiting;
+
+    Ring rings[RING_COUNT];
+};
+
+static_assert(sizeof(Record) == 256, "LogRing::Record must have the same size on all archs");
+
+/* Description of a printf conversion specification */
+struct Conversion {
+    const char* begin; // position of the '%' character
+    const char* end; // position following the conversion character
+    int stars; // number of '*' width/precision arguments
+    char length; // length modifier: 0, 'H' (hh), 'h', 'l', 'q' (ll), 'L', 'j', 'z' or 't'
+    char conv; // conversion character
+};
+
+/* Find the next conversion specification of `fmt`, skipping "%%" sequences.
+ * Returns false if there is none. */
+bool nextConversion(const char* fmt, Conversion& c);
+
+/* Returns the argument type used to encode a conversion, or 0 if the
+ * conversion does not consume a value (%n) or is unknown. */
+int argType(const Conversion& c);
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+    Copyright 2015-2023 Clément Gallet <clement.gallet@ens-lyon.org>
+
+    This file is part of libTAS.
+
+    libTAS is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    libTAS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with libTAS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBTAS_SAVESTATESTATUS_H_INCLUDED
+#define LIBTAS_SAVESTATESTATUS_H_INCLUDED
+
+/*
+ * Status codes returned by the game when saving or loading a state. When a
+ * savestate fails, the game sends the negative code in place of a message, so
+ * the program must decode it with these values and not with its own
+ * SaveState::Error codes.
+ */
+struct SaveStateStatus {
+    enum Error {
+        ESTATE_OK = 0,
+        ESTATE_UNKNOWN = -1, // Unknown error
+        ESTATE_NOMEM = -2, // Not enough memory to perform savestate
+        ESTATE_NOSTATE = -3, // No state in slot
+        ESTATE_NOTSAMETHREADS = -4, // Thread list has changed
+        ESTATE_NOTCOMPLETE = -5, // State still being saved
+        ESTATE_NOFILE = -6, // File mapped by the state was removed or replaced
+        ESTATE_NOSAVEFILE = -7, // Savefile content of the state is missing
+    };
+};
+
+#endif
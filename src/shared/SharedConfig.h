@@ -43,6 +43,9 @@ struct __attribute__((packed, aligned(8))) SharedConfig {
     };
     int fastforward_render = FF_RENDER_SOME;
 
+    /* Number of frames displayed per second when skipping most rendering */
+    int fastforward_display_rate = 8;
+
     /* Recording status */
     enum RecStatus {
         NO_RECORDING,
@@ -246,11 +249,18 @@ struct __attribute__((packed, aligned(8))) SharedConfig {
         SS_COMPRESSED = 0x08, /* Compress savestates */
         SS_PRESENT = 0x10, /* Skip unmapped pages */
         SS_FORK = 0x20, /* Use a forked process to save the state */
+        SS_FILEPAGES = 0x40, /* Reference unmodified pages of private file mappings */
     };
 
     /* Savestate settings */
     int savestate_settings = SS_COMPRESSED;
 
+    /* Number of savestate slots: slots 1 to 9 are user slots, slot 10 is the
+     * backtrack savestate, and the following ones are used by lua scripts.
+     * Forked savestates report their slot in the exit status of the child,
+     * so it cannot exceed 256. */
+    static const int SAVESTATE_SLOTS = 256;
+
     /* Stacktrace hash to advance time */
     uint64_t busy_loop_hash = 0;
 
@@ -278,6 +288,9 @@ struct __attribute__((packed, aligned(8))) SharedConfig {
     /* Display OSD in the video encode */
     bool osd_encode = false;
 
+    /* Send the timeline of each frame to the program */
+    bool frame_trace = false;
+
     /* Use a backup of savefiles in memory, which leaves the original
      * savefiles unmodified and save the content in savestates */
     bool prevent_savefiles = true;
@@ -299,6 +312,9 @@ struct __attribute__((packed, aligned(8))) SharedConfig {
     /* Recycle threads when they terminate */
     bool recycle_threads = false;
 
+    /* Number of threads created in advance to be recycled */
+    int thread_pool_size = 0;
+
     /* Simulates a virtual Steam client */
     bool virtual_steam = false;
 
@@ -319,6 +335,9 @@ struct __attribute__((packed, aligned(8))) SharedConfig {
 
     /* Call raise(SIGINT) in libtas::init */
     bool sigint_upon_launch = false;
+
+    /* Send log messages as binary records to be formatted by the program */
+    bool async_logging = false;
 };
 
 #endif
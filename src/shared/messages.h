@@ -162,7 +162,8 @@ enum {
     MSGN_SAVESTATE,
 
     /*
-     * Ask the game to load a savestate
+     * Ask the game to load a savestate. If loading fails, the game answers
+     * with the negative error code of SaveStateStatus as message
      * Argument: none
      */
     MSGN_LOADSTATE,
@@ -276,8 +277,10 @@ enum {
     MSGB_GIT_COMMIT,
 
     /*
-     * Send the hash and backtrace of a gettime function.
-     * Argument: uint64_t then size_t (string length) then char[len]
+     * Send the hash and backtrace of a gettime function, with the number of
+     * calls since the last frame. The backtrace is only sent the first time,
+     * and is empty afterwards.
+     * Argument: int then uint64_t then unsigned int then size_t (string length) then char[len]
      */
     MSGB_GETTIME_BACKTRACE,
 
@@ -381,6 +384,19 @@ enum {
      * Argument: uint64_t addr
      */
     MSGN_UNITY_WAIT_ADDR,
+
+    /* Send the file descriptor of the shared memory object holding the
+     * asynchronous log rings, to be opened by the program through procfs.
+     * Only sent at the end of initialization when asynchronous logging is on
+     * Argument: int fd
+     */
+    MSGB_LOG_RING,
+
+    /* Send the timeline of the phases of the previous frame, when frame
+     * tracing is enabled
+     * Argument: FrameTrace::Record record
+     */
+    MSGB_FRAME_TRACE,
 };
 
 #endif
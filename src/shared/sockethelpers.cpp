@@ -37,6 +37,7 @@
 #include <vector>
 #include <mutex>
 #include <errno.h>
+#include <cstring>
 
 
 #define SOCKET_FILENAME "/tmp/libTAS.socket"
@@ -54,8 +55,39 @@ static int socket_fd = 0;
 
 static std::mutex mutex;
 
+const char* getSocketPath(void)
+{
+    const char* path;
+#ifdef LIBTAS_LIBRARY
+    NATIVECALL(path = getenv("LIBTAS_SOCKET"));
+#else
+    path = getenv("LIBTAS_SOCKET");
+#endif
+    if (!path || !path[0])
+        return SOCKET_FILENAME;
+    return path;
+}
+
+/* Build the address of the socket file. Returns false if the path does not
+ * fit in the address, because a truncated path could be shared with another
+ * instance. */
+static bool getSocketAddress(struct sockaddr_un* addr)
+{
+    const char* path = getSocketPath();
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    if (strlen(path) >= sizeof(addr->sun_path))
+        return false;
+
+#if defined(__APPLE__) && defined(__MACH__)
+    addr->sun_len = sizeof(struct sockaddr_un);
+#endif
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
 int removeSocket(void) {
-    int ret = unlink(SOCKET_FILENAME);
+    int ret = unlink(getSocketPath());
     if ((ret == -1) && (errno != ENOENT))
         return errno;
     return 0;
@@ -64,11 +96,11 @@ int removeSocket(void) {
 #ifndef LIBTAS_LIBRARY
 bool initSocketProgram(pid_t fork_pid)
 {
-#ifdef __unix__
-    const struct sockaddr_un addr = { AF_UNIX, SOCKET_FILENAME };
-#elif defined(__APPLE__) && defined(__MACH__)
-    const struct sockaddr_un addr = { sizeof(struct sockaddr_un), AF_UNIX, SOCKET_FILENAME };
-#endif
+    struct sockaddr_un addr;
+    if (!getSocketAddress(&addr)) {
+        std::cerr << "Socket path " << getSocketPath() << " is too long" << std::endl;
+        return false;
+    }
     socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
 
     struct timespec tim = {0, 500L*1000L*1000L};
@@ -111,20 +143,21 @@ bool initSocketGame(void)
 {
     GlobalNative gn;
     
+    struct sockaddr_un addr;
+    if (!getSocketAddress(&addr)) {
+        debuglogstdio(LCF_SOCKET | LCF_ERROR, "Socket path %s is too long", getSocketPath());
+        exit(-1);
+    }
+
     /* Check if socket file already exists. If so, it is probably because
      * the link is already done in another process of the game.
      * In this case, we just return immediately.
      */
     struct stat st;
-    int result = stat(SOCKET_FILENAME, &st);
+    int result = stat(addr.sun_path, &st);
     if (result == 0)
         return false;
 
-#ifdef __unix__
-    const struct sockaddr_un addr = { AF_UNIX, SOCKET_FILENAME };
-#elif defined(__APPLE__) && defined(__MACH__)
-    const struct sockaddr_un addr = { sizeof(struct sockaddr_un), AF_UNIX, SOCKET_FILENAME };
-#endif
     const int tmp_fd = socket(AF_UNIX, SOCK_STREAM, 0);
     if (bind(tmp_fd, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(struct sockaddr_un)))
     {
@@ -24,6 +24,10 @@
 #include <string>
 #include <sys/types.h>
 
+/* Path of the socket file. It can be set per game instance with the
+ * LIBTAS_SOCKET environment variable, and defaults to /tmp/libTAS.socket */
+const char* getSocketPath();
+
 /* Remove the socket file and return error */
 int removeSocket();
 
@@ -0,0 +1,79 @@
+/* This code benchmarks the mixing of audio sources into the output buffer,
+ * comparing the former per-source clamping loop with the float bus of AudioMixer
+ * Can be compiled with: g++ -O2 -o audiomixbench audiomixbench.cpp ../src/library/audio/AudioMixer.cpp
+ */
+
+#include "../src/library/audio/AudioMixer.h"
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+#define clamptofullsignedrange(x,lo,hi) ((static_cast<unsigned int>((x)-(lo))<=static_cast<unsigned int>((hi)-(lo)))?(x):(((x)<0)?(lo):(hi)))
+
+static const int nbChannels = 2;
+static const int nbSamples = 735; // one frame at 44100 Hz and 60 fps
+static const int nbFrames = 2000;
+
+/* Former mixing code, each source is added and clamped to the output */
+static int mixScalar(const std::vector<std::vector<int16_t>>& sources, int16_t* out, float volume)
+{
+    int vas = static_cast<int>(volume * 65536.0f);
+    int nbSaturate = 0;
+    for (const auto& src : sources) {
+        for (int s=0; s<nbSamples*nbChannels; s++) {
+            int sum = out[s] + ((src[s] * vas) >> 16);
+            out[s] = clamptofullsignedrange(sum, INT16_MIN, INT16_MAX);
+            nbSaturate += (sum < INT16_MIN) || (sum > INT16_MAX);
+        }
+    }
+    return nbSaturate;
+}
+
+/* New mixing code, sources are accumulated in a float bus, clamped once */
+static int mixBus(const std::vector<std::vector<int16_t>>& sources, std::vector<float>& bus, int16_t* out, float volume)
+{
+    bus.assign(nbSamples*nbChannels, 0.0f);
+    for (const auto& src : sources)
+        libtas::AudioMixer::accumulateS16(bus.data(), src.data(), nbSamples*nbChannels, volume);
+    return libtas::AudioMixer::clampS16(bus.data(), out, nbSamples*nbChannels);
+}
+
+int main()
+{
+    const int nbSourcesList[] = {1, 16, 64};
+    srand(0);
+
+    for (int nbSources : nbSourcesList) {
+        std::vector<std::vector<int16_t>> sources(nbSources);
+        for (auto& src : sources) {
+            src.resize(nbSamples*nbChannels);
+            for (auto& v : src)
+                v = static_cast<int16_t>((rand() % 8192) - 4096);
+        }
+
+        std::vector<int16_t> out(nbSamples*nbChannels);
+        std::vector<float> bus;
+        long satScalar = 0, satBus = 0;
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int f=0; f<nbFrames; f++) {
+            out.assign(out.size(), 0);
+            satScalar += mixScalar(sources, out.data(), 0.5f);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (int f=0; f<nbFrames; f++) {
+            satBus += mixBus(sources, bus, out.data(), 0.5f);
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        double usScalar = std::chrono::duration<double, std::micro>(t1 - t0).count() / nbFrames;
+        double usBus = std::chrono::duration<double, std::micro>(t2 - t1).count() / nbFrames;
+
+        std::cout << nbSources << " sources: scalar " << usScalar << " us/frame (" << satScalar/nbFrames
+                  << " saturated), bus " << usBus << " us/frame (" << satBus/nbFrames << " saturated)" << std::endl;
+    }
+
+    return 0;
+}
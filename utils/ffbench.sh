@@ -0,0 +1,30 @@
+#!/bin/sh
+# Measure the overhead of libTAS in fast-forward, by running simplestgame
+# for a number of frames and printing the average duration of each phase of
+# a frame on the program and on the game side. The complete timeline is
+# written in the Chrome trace event format.
+#
+# Usage: ffbench.sh LIBTAS_BINARY [FRAMES] [TRACE_FILE]
+#
+# An X server is needed, for example by running it through xvfb-run.
+
+LIBTAS="$1"
+FRAMES="${2:-10000}"
+TRACE="${3:-ffbench.json}"
+
+if [ -z "$LIBTAS" ]; then
+    echo "Usage: $0 LIBTAS_BINARY [FRAMES] [TRACE_FILE]"
+    exit 1
+fi
+
+UTILSDIR=$(cd "$(dirname "$0")" && pwd)
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+gcc -O2 -o "$WORKDIR/simplestgame" "$UTILSDIR/simplestgame.c" -lSDL2 || exit 1
+
+# Isolated configuration, so that user settings are not used nor modified
+export XDG_CONFIG_HOME="$WORKDIR/config"
+export LIBTAS_FRAME_TRACE="$TRACE"
+
+"$LIBTAS" -n -i ffbench --fast-forward=some --pause-frame "$FRAMES" "$WORKDIR/simplestgame" | grep -A 30 "^Frame trace"
@@ -0,0 +1,27 @@
+-- Savestate benchmark driver, started by savestatebench.sh
+-- After a warmup, it alternates saving a state and loading it back a few
+-- frames later. Timings are recorded by the program into the file set in
+-- LIBTAS_SAVESTATE_STATS.
+
+local iterations = tonumber(os.getenv("LIBTAS_BENCH_ITERATIONS") or "10")
+local warmup = 30
+local interval = 5
+local frame = 0
+local iteration = 0
+
+function onFrame()
+    frame = frame + 1
+    if frame < warmup or iteration >= iterations then
+        return
+    end
+
+    local step = (frame - warmup) % (2 * interval)
+    if step == 0 then
+        runtime.saveState(1)
+    elseif step == interval then
+        runtime.loadState(1)
+        iteration = iteration + 1
+    end
+end
+
+callback.onFrame(onFrame)
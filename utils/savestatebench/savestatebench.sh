@@ -0,0 +1,98 @@
+#!/bin/sh
+# Savestate benchmark: runs the synthetic game under libTAS for every
+# combination of savestate flags and game parameters, and writes one JSON
+# object per save or load operation.
+#
+# Usage: savestatebench.sh LIBTAS_BINARY [OUTPUT_FILE]
+#
+# Game parameters are space-separated lists set in environment variables:
+#   BENCH_HEAP_MB (default "256"), BENCH_DIRTY (default "0.01 0.1"),
+#   BENCH_ZERO (default "0.5"), BENCH_THREADS (default "0 8"),
+#   BENCH_FLAGS (default: all combinations), BENCH_ITERATIONS (default 10),
+#   BENCH_TIMEOUT in seconds for each run (default 120)
+#
+# An X server is needed, for example by running it through xvfb-run.
+
+LIBTAS="$1"
+OUTPUT="${2:-savestatebench.jsonl}"
+
+if [ -z "$LIBTAS" ]; then
+    echo "Usage: $0 LIBTAS_BINARY [OUTPUT_FILE]"
+    exit 1
+fi
+
+BENCHDIR=$(cd "$(dirname "$0")" && pwd)
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+HEAP_MB="${BENCH_HEAP_MB:-256}"
+DIRTY="${BENCH_DIRTY:-0.01 0.1}"
+ZERO="${BENCH_ZERO:-0.5}"
+THREADS="${BENCH_THREADS:-0 8}"
+ITERATIONS="${BENCH_ITERATIONS:-10}"
+TIMEOUT="${BENCH_TIMEOUT:-120}"
+
+# SS_INCREMENTAL=1, SS_RAM=2, SS_COMPRESSED=8, SS_PRESENT=16, SS_FORK=32
+if [ -z "$BENCH_FLAGS" ]; then
+    BENCH_FLAGS=""
+    for f in $(seq 0 31); do
+        flags=$(( (f & 1) | ((f & 2)) | ((f & 4) << 1) | ((f & 8) << 1) | ((f & 16) << 1) ))
+        BENCH_FLAGS="$BENCH_FLAGS $flags"
+    done
+fi
+
+GAME="$WORKDIR/savestategame"
+gcc -O2 -o "$GAME" "$BENCHDIR/savestategame.c" -lSDL2 -lpthread || exit 1
+
+: > "$OUTPUT"
+
+for heap in $HEAP_MB; do
+for dirty in $DIRTY; do
+for zero in $ZERO; do
+for threads in $THREADS; do
+for flags in $BENCH_FLAGS; do
+    echo "heap ${heap}MB, dirty $dirty, zero $zero, threads $threads, flags $flags"
+
+    # Isolated configuration, so that user settings are not used nor modified
+    export XDG_CONFIG_HOME="$WORKDIR/config"
+    mkdir -p "$XDG_CONFIG_HOME/libTAS"
+    printf '[shared]\nsavestate_settings=%d\n' "$flags" > "$XDG_CONFIG_HOME/libTAS/savestategame.ini"
+
+    STATS="$WORKDIR/stats.jsonl"
+    : > "$STATS"
+    export LIBTAS_SAVESTATE_STATS="$STATS"
+    export LIBTAS_BENCH_ITERATIONS="$ITERATIONS"
+
+    setsid "$LIBTAS" -n -i savestatebench -l "$BENCHDIR/savestatebench.lua" \
+        "$GAME" "$heap" "$dirty" "$zero" "$threads" > "$WORKDIR/log.txt" 2>&1 &
+    PID=$!
+
+    # Wait for all operations to be recorded
+    expected=$((2 * ITERATIONS))
+    elapsed=0
+    while [ "$(wc -l < "$STATS")" -lt "$expected" ] && [ "$elapsed" -lt "$TIMEOUT" ] && kill -0 "$PID" 2>/dev/null; do
+        sleep 1
+        elapsed=$((elapsed + 1))
+    done
+
+    kill -TERM -- "-$PID" 2>/dev/null
+    sleep 1
+    kill -KILL -- "-$PID" 2>/dev/null
+    wait "$PID" 2>/dev/null
+
+    if [ "$(wc -l < "$STATS")" -lt "$expected" ]; then
+        echo "  incomplete run, see the log below"
+        tail -n 5 "$WORKDIR/log.txt"
+        printf '{"heap_mb":%s,"dirty":%s,"zero":%s,"threads":%s,"flags":%s,"error":"incomplete"}\n' \
+            "$heap" "$dirty" "$zero" "$threads" "$flags" >> "$OUTPUT"
+    fi
+
+    # Prefix each record with the game parameters
+    sed "s/^{/{\"heap_mb\":$heap,\"dirty\":$dirty,\"zero\":$zero,\"threads\":$threads,/" "$STATS" >> "$OUTPUT"
+done
+done
+done
+done
+done
+
+echo "Results written to $OUTPUT"
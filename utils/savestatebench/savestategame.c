@@ -0,0 +1,119 @@
+/* Synthetic game used by the savestate benchmark. It allocates a heap of a
+ * given size, fills part of it with zeros and the rest with random data, and
+ * writes into a ratio of the data pages on each frame. Worker threads are
+ * started at launch and keep touching their own buffers.
+ *
+ * Usage: savestategame HEAP_MB DIRTY_RATIO ZERO_RATIO THREADS
+ *
+ * Can be compiled with: gcc -O2 -o savestategame savestategame.c -lSDL2 -lpthread
+ */
+
+#include <SDL2/SDL.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#define PAGE_SIZE 4096
+
+static volatile int run = 1;
+
+static void* worker(void* arg)
+{
+    /* Each thread has a small buffer that is modified periodically */
+    unsigned char* buffer = malloc(64 * PAGE_SIZE);
+    struct timespec tim = {0, 5000000L};
+    unsigned int i = (unsigned int)(uintptr_t)arg;
+
+    memset(buffer, 0, 64 * PAGE_SIZE);
+    while (run) {
+        buffer[(i * PAGE_SIZE) % (64 * PAGE_SIZE)]++;
+        i++;
+        nanosleep(&tim, NULL);
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 5) {
+        fprintf(stderr, "Usage: %s HEAP_MB DIRTY_RATIO ZERO_RATIO THREADS\n", argv[0]);
+        return 1;
+    }
+
+    size_t heap_size = strtoull(argv[1], NULL, 10) * 1024 * 1024;
+    double dirty_ratio = atof(argv[2]);
+    double zero_ratio = atof(argv[3]);
+    int nb_threads = atoi(argv[4]);
+
+    SDL_Init(SDL_INIT_VIDEO);
+
+    SDL_Window* window = SDL_CreateWindow("Title",SDL_WINDOWPOS_UNDEFINED,
+            SDL_WINDOWPOS_UNDEFINED,
+            640,
+            480,
+            SDL_WINDOW_SHOWN);
+
+    SDL_Renderer *renderer = SDL_CreateRenderer(window,-1,SDL_RENDERER_SOFTWARE);
+
+    /* Fill the heap: zero pages first, then pages of random data */
+    size_t nb_pages = heap_size / PAGE_SIZE;
+    size_t nb_zero_pages = (size_t)(nb_pages * zero_ratio);
+    size_t nb_data_pages = nb_pages - nb_zero_pages;
+    size_t nb_dirty_pages = (size_t)(nb_data_pages * dirty_ratio);
+
+    unsigned char* heap = malloc(heap_size);
+    memset(heap, 0, nb_zero_pages * PAGE_SIZE);
+    unsigned char* data = heap + nb_zero_pages * PAGE_SIZE;
+
+    srand(0);
+    for (size_t j = 0; j < nb_data_pages * PAGE_SIZE; j += sizeof(int)) {
+        *(int*)(data + j) = rand();
+    }
+
+    pthread_t* threads = malloc(nb_threads * sizeof(pthread_t));
+    for (int t = 0; t < nb_threads; t++) {
+        pthread_create(&threads[t], NULL, worker, (void*)(uintptr_t)t);
+    }
+
+    size_t next_page = 0;
+    SDL_Rect rect = {200, 200, 20, 20};
+
+    while (run) {
+        /* Dirty pages in a round-robin way */
+        for (size_t p = 0; p < nb_dirty_pages; p++) {
+            data[next_page * PAGE_SIZE + (rand() % PAGE_SIZE)]++;
+            next_page = (next_page + 1) % nb_data_pages;
+        }
+
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        rect.x = 200 + (next_page % 200);
+        SDL_RenderFillRect(renderer, &rect);
+        SDL_RenderPresent(renderer);
+
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) {
+            if (e.type == SDL_QUIT) {
+                run = 0;
+            }
+        }
+    }
+
+    for (int t = 0; t < nb_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+    free(heap);
+
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+
+    return 0;
+}